@@ -1,537 +1,6445 @@
-#pragma once
-
-/*
-  SIMPLE WAVE
-  Copyright (C) Christian Luppi
-
-  This software is provided 'as-is', without any express or implied
-  warranty.  In no event will the authors be held liable for any damages
-  arising from the use of this software.
-
-  Permission is granted to anyone to use this software for any purpose,
-  including commercial applications, and to alter it and redistribute it
-  freely, subject to the following restrictions:
-
-  1. The origin of this software must not be misrepresented; you must not
-     claim that you wrote the original software. If you use this software
-     in a product, an acknowledgment in the product documentation would be
-     appreciated but is not required.
-  2. Altered source versions must be plainly marked as such, and must not be
-     misrepresented as being the original software.
-  3. This notice may not be removed or altered from any source distribution.
-
-  This is a simple wave library to parse and stream wave files.
-
-  Do this:
-      #define SIMPLE_WAVE_IMPLEMENTATION
-   before you include this file in *one* C or C++ file to create the implementation.
-
-   // i.e. it should look like this:
-   #include ...
-   #include ...
-   #include ...
-   #define SIMPLE_WAVE_IMPLEMENTATION
-   #include "simple_wave.h"
-
-   NOTE: This is not a full wav parser, only uncompressed PCM and FLOAT samples are supported.
-
-*/
-
-#include <stdint.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-#pragma pack(push, 1)
-
-#define RIFF_CODE(a, b, c, d) (((uint32_t)(a) << 0) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
-
-    typedef struct RIFF_HEADER
-    {
-        uint32_t riff_id;
-        uint32_t size;
-        uint32_t filetype_id;
-    } RIFF_HEADER;
-
-    typedef struct RIFF_CHUNK
-    {
-        uint32_t id;
-        uint32_t size;
-    } RIFF_CHUNK;
-
-    typedef enum WAVE_FORMAT_TAG
-    {
-        WAVE_FORMAT_TAG_PCM = 0x0001,
-        WAVE_FORMAT_TAG_IEEE_FLOAT = 0x0003,
-    } WAVE_FORMAT_TAG;
-
-    typedef struct WAVE_FORMAT
-    {
-        uint16_t format_tag;
-        uint16_t channels;
-        uint32_t samples_per_sec;
-        uint32_t avg_bytes_per_sec;
-        uint16_t block_align;
-        uint16_t bits_per_sample;
-    } WAVE_FORMAT;
-
-#pragma pack(pop)
-
-    typedef enum WAVE_CHUNK
-    {
-        WAVE_CHUNK_FORMAT = RIFF_CODE('f', 'm', 't', ' '),
-        WAVE_CHUNK_DATA = RIFF_CODE('d', 'a', 't', 'a'),
-    } WAVE_CHUNK;
-
-    typedef struct WAVE
-    {
-        void* free_ptr;
-        size_t free_ptr_size;
-
-        RIFF_HEADER* header;
-
-        RIFF_CHUNK* format_chunk;
-        size_t      format_chunk_offset;
-
-        RIFF_CHUNK* data_chunk;
-        size_t      data_chunk_offset;
-
-        void* sample_data;
-        size_t sample_data_size;
-        size_t sample_data_offset;
-
-        WAVE_FORMAT* format;
-    } WAVE;
-
-    typedef enum WAVE_SAMPLE_FORMAT
-    {
-        WAVE_SAMPLE_FORMAT_UNKNOWN,
-        WAVE_SAMPLE_FORMAT_U8,
-        WAVE_SAMPLE_FORMAT_S16,
-        WAVE_SAMPLE_FORMAT_S32,
-        WAVE_SAMPLE_FORMAT_F32,
-        WAVE_SAMPLE_FORMAT_F64,
-    } WAVE_SAMPLE_FORMAT;
-
-    typedef void* WAVE_ALLOCATE(void* data, size_t size);
-    typedef void WAVE_FREE(void* data, void* ptr, size_t size);
-
-    typedef struct WAVE_ALLOCATOR
-    {
-        WAVE_ALLOCATE* allocate;
-        WAVE_FREE*     free;
-        void*          data;
-    } WAVE_ALLOCATOR;
-    
-    /*
-      Returns a parsed wave file if the result is not 0.
-      This function does not allocate any memory,
-      you must read the wave file yourself.
-      The data stored in the wave structure is only valid if the given buffer is STILL allocated.
-    */
-    extern int Wave_ParseBuffer(void* buff, size_t size, WAVE* out_wave);
-
-    /*
-      Read a wav from the current file stream.
-    */
-    extern int Wave_LoadStream(FILE* file, long size, WAVE* out_wave, WAVE_ALLOCATOR* allocator);
-
-    /*
-     Read a wav from a file path.
-   */
-    extern int Wave_LoadPath(const char* path, WAVE* out_wave, WAVE_ALLOCATOR* allocator);
-
-    /*
-      Read a wav from the current file stream.
-    */
-    extern int Wave_LoadStreamOnlyInfo(FILE* file, long size, WAVE* out_wave, WAVE_ALLOCATOR* allocator);
-
-    /*
-     Read a wav from a file path.
-   */
-    extern int Wave_LoadPathOnlyInfo(const char* path, WAVE* out_wave, WAVE_ALLOCATOR* allocator);
-
-    /*
-      Returns the sample format of the stored samples.
-    */
-    extern WAVE_SAMPLE_FORMAT Wave_GetSampleFormat(WAVE* wave);
-
-    /*
-      Returns the length of the stored samples in seconds.
-    */
-    extern float Wave_GetLengthInSeconds(WAVE* wave);
-
-    /*
-      Returns the number of samples per second.
-    */
-    extern int Wave_GetSampleFrequency(WAVE* wave);
-
-    /*
-      Returns the number of channels.
-    */
-    extern int Wave_GetChannelCount(WAVE* wave);
-
-    /*
-      Returns the sample data in the given pointers.
-      Returns 0 if the function failed.
-    */
-    extern int Wave_GetSampleData(WAVE* wave, void** out_samples, size_t* out_samples_size);
-
-    /*
-      Returns the number of samples.
-    */
-    extern int Wave_GetSampleCount(WAVE* wave);
-
-    /*
-      Release internally allocated memory.
-    */
-    extern int Wave_Free(WAVE* wave, WAVE_ALLOCATOR* allocator);
-
-    /*
-      Returns the offset of the sample data in the parsed memory.
-    */
-    extern size_t Wave_GetSampleDataOffset(WAVE* wave);
-
-    //
-    //
-    //
-    //
-    //
-    //
-    //
-    //
-
-#ifdef SIMPLE_WAVE_IMPLEMENTATION
-
-    static int Wave_ValidateHeader(RIFF_HEADER* header)
-    {
-        // Check RIFF id
-        if (header->riff_id != RIFF_CODE('R', 'I', 'F', 'F'))
-            return 0;
-
-        // Check WAV id
-        if (header->filetype_id != RIFF_CODE('W', 'A', 'V', 'E'))
-            return 0;
-
-        return 1;
-    }
-
-    static int Wave_ValidateFormat(WAVE* out_wave)
-    {
-        if (!out_wave->format)
-            return 0;
-
-        if ((out_wave->format->format_tag != WAVE_FORMAT_TAG_PCM) && (out_wave->format->format_tag != WAVE_FORMAT_TAG_IEEE_FLOAT))
-            return 0;
-
-        if ((out_wave->format->format_tag == WAVE_FORMAT_TAG_PCM) && (out_wave->format->bits_per_sample != 8) && (out_wave->format->bits_per_sample != 16) && (out_wave->format->bits_per_sample != 32))
-            return 0;
-
-        if ((out_wave->format->format_tag == WAVE_FORMAT_TAG_IEEE_FLOAT) && (out_wave->format->bits_per_sample != 32) && (out_wave->format->bits_per_sample != 64))
-            return 0;
-
-        return 1;
-    }
-
-    static void* Wave_DefaultAlloc(void* data, size_t size)
-    {
-        return malloc(size);
-    }
-
-    static void Wave_DefaultFree(void* data, void* ptr, size_t size)
-    {
-        free(ptr);
-    }
-
-    static WAVE_ALLOCATOR* Wave_GetDefaultAllocator(void)
-    {
-        static WAVE_ALLOCATOR allocator = { 0 };
-        allocator.allocate = Wave_DefaultAlloc;
-        allocator.free     = Wave_DefaultFree;
-        return &allocator;
-    }
-
-    int Wave_ParseBuffer(void* buff, size_t size, WAVE* out_wave)
-    {
-        // Validate params
-        if ((!buff) || (!size) || (!out_wave))
-            return 0;
-
-        memset(out_wave, 0, sizeof(WAVE));
-
-        out_wave->header = (RIFF_HEADER*)buff;
-        if (!Wave_ValidateHeader(out_wave->header))
-            return 0;
-
-        // Parse RIFF chunks
-        char* at = (char*)(out_wave->header + 1);
-        char* max = (char*)(at + out_wave->header->size - 4);
-        while (at < max)
-        {
-            RIFF_CHUNK* chunk = (RIFF_CHUNK*)at;
-
-            switch (chunk->id)
-            {
-                case WAVE_CHUNK_DATA:
-                    out_wave->data_chunk = chunk;
-                    out_wave->data_chunk_offset = (size_t)((char*)chunk - (char*)buff);
-                    break;
-                case WAVE_CHUNK_FORMAT:
-                    out_wave->format_chunk = chunk;
-                    out_wave->format_chunk_offset = (size_t)((char*)chunk - (char*)buff);
-                    break;
-            }
-
-            at += sizeof(RIFF_CHUNK) + ((chunk->size + 1) & ~1); // If the size is odd round it
-        }
-
-        // Get format
-        if (!out_wave->format_chunk)
-            return 0;
-        out_wave->format = (WAVE_FORMAT*)(out_wave->format_chunk + 1);
-
-        // Get sample data
-        if (out_wave->data_chunk)
-        {
-            out_wave->sample_data = (void*)(out_wave->data_chunk + 1);
-            out_wave->sample_data_size = out_wave->data_chunk->size;
-            out_wave->sample_data_offset = (size_t)((char*)out_wave->sample_data - (char*)buff);
-        }
-
-        return Wave_ValidateFormat(out_wave);
-    }
-
-    int Wave_LoadStream(FILE* file, long size, WAVE* out_wave, WAVE_ALLOCATOR* allocator)
-    {
-        if (!out_wave)
-            return 0;
-        if (!file)
-            return 0;
-
-        if (!allocator)
-            allocator = Wave_GetDefaultAllocator();
-
-        void* buff = allocator->allocate(allocator->data, size);
-        fread(buff, 1, size, file);
-        out_wave->free_ptr = buff;
-        out_wave->free_ptr_size = size;
-        return Wave_ParseBuffer(buff, size, out_wave);
-    }
-
-    int Wave_LoadPath(const char* path, WAVE* out_wave, WAVE_ALLOCATOR* allocator)
-    {
-        if (!out_wave)
-            return 0;
-        if (!path)
-            return 0;
-
-        FILE* file = fopen(path, "rb");
-        if (file)
-        {
-            fseek(file, 0, SEEK_END);
-            long fileSize = ftell(file);
-            fseek(file, 0, SEEK_SET);
-
-            Wave_LoadStream(file, fileSize, out_wave, allocator);
-            fclose(file);
-        }
-
-        return 1;
-    }
-
-    int Wave_LoadStreamOnlyInfo(FILE* file, long size, WAVE* out_wave, WAVE_ALLOCATOR* allocator)
-    {
-        if (!file)
-            return 0;
-        if (!out_wave)
-            return 0;
-        if (!allocator)
-            allocator = Wave_GetDefaultAllocator();
-
-        memset(out_wave, 0, sizeof(WAVE));
-
-        // Allocate space
-        out_wave->free_ptr_size = sizeof(RIFF_HEADER) + sizeof(RIFF_CHUNK) * 2 + sizeof(WAVE_FORMAT);
-        out_wave->free_ptr = allocator->allocate(allocator->data, out_wave->free_ptr_size);
-
-        // Allocate space for the header
-        out_wave->header = (RIFF_HEADER*)out_wave->free_ptr;
-        fread(out_wave->header, sizeof(RIFF_HEADER), 1, file);
-
-        // Validate the header
-        if (!Wave_ValidateHeader(out_wave->header))
-            return 0;
-
-        // Initialize variables for chunk processing
-        RIFF_CHUNK chunk;
-
-        // Read chunks until the 'fmt ' chunk is found
-        while ((ftell(file) + sizeof(RIFF_CHUNK)) <= size)
-        {
-            // Read the chunk header
-            fread(&chunk, sizeof(RIFF_CHUNK), 1, file);
-
-            if (chunk.id == WAVE_CHUNK_DATA)
-            {
-                out_wave->data_chunk = (RIFF_CHUNK*)(out_wave->header+1);
-                memcpy(out_wave->data_chunk, &chunk, sizeof(RIFF_CHUNK));
-                out_wave->data_chunk_offset = ftell(file) - sizeof(RIFF_CHUNK);
-                out_wave->sample_data_offset = ftell(file);
-                out_wave->sample_data_size = chunk.size;
-
-                fseek(file, chunk.size, SEEK_CUR);
-            }
-            else if (chunk.id == WAVE_CHUNK_FORMAT)
-            {
-                out_wave->format_chunk = (RIFF_CHUNK*)((char*)(out_wave->header+1) + sizeof(RIFF_CHUNK));
-                memcpy(out_wave->format_chunk, &chunk, sizeof(RIFF_CHUNK));
-                out_wave->format_chunk_offset = ftell(file) - sizeof(RIFF_CHUNK);
-
-                out_wave->format = (WAVE_FORMAT*)((char*)(out_wave->header + 1) + sizeof(RIFF_CHUNK) * 2);
-                fread(out_wave->format, 1, chunk.size, file);
-            }
-            else
-            {
-                // Skip over this chunk
-                fseek(file, chunk.size, SEEK_CUR);
-            }
-
-            if (chunk.size % 2 != 0)
-                fseek(file, 1, SEEK_CUR);
-        }
-
-        // Validate the format chunk
-        if (!Wave_ValidateFormat(out_wave))
-            return 0;
-
-        return 1;
-    }
-
-    int Wave_LoadPathOnlyInfo(const char* path, WAVE* out_wave, WAVE_ALLOCATOR* allocator)
-    {
-        if (!path)
-            return 0;
-        if (!out_wave)
-            return 0;
-
-        FILE* file = fopen(path, "rb");
-        if (file)
-        {
-            fseek(file, 0, SEEK_END);
-            long fileSize = ftell(file);
-            fseek(file, 0, SEEK_SET);
-
-            Wave_LoadStreamOnlyInfo(file, fileSize, out_wave, allocator);
-            fclose(file);
-        }
-
-        return 1;
-    }
-
-    WAVE_SAMPLE_FORMAT Wave_GetSampleFormat(WAVE* wave)
-    {
-        if ((!wave) || (!wave->format))
-            return WAVE_SAMPLE_FORMAT_UNKNOWN;
-
-        if (wave->format->format_tag == WAVE_FORMAT_TAG_PCM)
-        {
-            if (wave->format->bits_per_sample == 8)
-                return WAVE_SAMPLE_FORMAT_U8;
-
-            if (wave->format->bits_per_sample == 16)
-                return WAVE_SAMPLE_FORMAT_S16;
-
-            if (wave->format->bits_per_sample == 32)
-                return WAVE_SAMPLE_FORMAT_S32;
-        }
-
-        if (wave->format->format_tag == WAVE_FORMAT_TAG_IEEE_FLOAT)
-        {
-            if (wave->format->bits_per_sample == 32)
-                return WAVE_SAMPLE_FORMAT_F32;
-
-            if (wave->format->bits_per_sample == 64)
-                return WAVE_SAMPLE_FORMAT_F64;
-        }
-
-        return WAVE_SAMPLE_FORMAT_UNKNOWN;
-    }
-
-    float Wave_GetLengthInSeconds(WAVE* wave)
-    {
-        if ((!wave) || (!wave->format))
-            return 0;
-
-        return ((float)wave->sample_data_size / (wave->format->bits_per_sample / 8)) / (float)wave->format->samples_per_sec;
-    }
-
-    int Wave_GetSampleFrequency(WAVE* wave)
-    {
-        if ((!wave) || (!wave->format))
-            return 0;
-
-        return wave->format->samples_per_sec;
-    }
-
-    int Wave_GetChannelCount(WAVE* wave)
-    {
-        if ((!wave) || (!wave->format))
-            return 0;
-
-        return wave->format->channels;
-    }
-
-    int Wave_GetSampleData(WAVE* wave, void** out_samples, size_t* out_samples_size)
-    {
-        if(!wave)
-            return 0;
-        if (out_samples)
-            *out_samples = wave->sample_data;
-        if (out_samples_size)
-            *out_samples_size = wave->sample_data_size;
-        return 1;
-    }
-
-    int Wave_GetSampleCount(WAVE* wave)
-    {
-        if ((!wave) || (!wave->format))
-            return 0;
-
-        return (int)(wave->sample_data_size / (wave->format->bits_per_sample / 8));
-    }
-
-    int Wave_Free(WAVE* wave, WAVE_ALLOCATOR* allocator)
-    {
-        if(!wave)
-            return 0;
-        if(!allocator)
-            allocator = Wave_GetDefaultAllocator();
-
-        if (wave->free_ptr)
-        {
-            allocator->free(allocator->data, wave->free_ptr, wave->free_ptr_size);
-            wave->free_ptr      = NULL;
-            wave->free_ptr_size = 0;
-            return 1;
-        }
-
-        return 0;
-    }
-
-    size_t Wave_GetSampleDataOffset(WAVE* wave)
-    {
-        if(!wave)
-            return 0;
-
-        return wave->sample_data_offset;
-    }
-
-#endif // SIMPLE_WAVE_IMPLEMENTATION
-
-#ifdef __cplusplus
-}
-#endif
+#pragma once
+
+/*
+  SIMPLE WAVE
+  Copyright (C) Christian Luppi
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+
+  This is a simple wave library to parse and stream wave files.
+
+  Do this:
+      #define SIMPLE_WAVE_IMPLEMENTATION
+   before you include this file in *one* C or C++ file to create the implementation.
+
+   // i.e. it should look like this:
+   #include ...
+   #include ...
+   #include ...
+   #define SIMPLE_WAVE_IMPLEMENTATION
+   #include "simple_wave.h"
+
+   NOTE: This is not a full wav parser, only uncompressed PCM and FLOAT samples are supported.
+
+   The DSP functions use the C math library, link with -lm (or define SIMPLE_WAVE_NO_DSP to build without it).
+
+   Subsystems can be left out to shrink the code, define before including this file:
+      SIMPLE_WAVE_NO_STDIO       no FILE based api: loading from streams and paths, reader, hybrid samples, scheduler, pipe, tail
+      SIMPLE_WAVE_NO_WRITER      no writer, channel split and merge (implied by SIMPLE_WAVE_NO_STDIO)
+      SIMPLE_WAVE_NO_DSP         no timeline, meters, fft, onsets, levels, resampler, vad, stereo, fault detection and alignment
+      SIMPLE_WAVE_NO_ALLOCATORS  no pool and NUMA allocators
+   Parsing, format conversion, hashing, descriptors and float views are always available.
+
+   The sample and DSP kernels are plain loops left to the compiler's vectorizer, there are no intrinsics to port or
+   dispatch. With gcc -O3 on x86-64, tests/bench.c converts S16 to float at about 10500 MB/s and measures levels at
+   about 1450 MB/s, against 4200 and 1090 MB/s with -fno-tree-vectorize.
+
+   NUMA placement is opt-in on Linux, define SIMPLE_WAVE_NUMA. It needs _GNU_SOURCE, which this file defines
+   when it is included in the implementation file before any system header; otherwise pass -D_GNU_SOURCE.
+
+*/
+
+#if defined(SIMPLE_WAVE_NO_STDIO) && !defined(SIMPLE_WAVE_NO_WRITER)
+#define SIMPLE_WAVE_NO_WRITER
+#endif
+
+// The NUMA code needs mmap flags and syscall, which strict modes (-std=c99) hide unless _GNU_SOURCE comes before the first system header
+#if defined(SIMPLE_WAVE_IMPLEMENTATION) && defined(SIMPLE_WAVE_NUMA) && defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#ifndef SIMPLE_WAVE_NO_DSP
+#include <math.h>
+#endif
+#include <stdint.h>
+#ifndef SIMPLE_WAVE_NO_STDIO
+#include <stdio.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(SIMPLE_WAVE_IMPLEMENTATION) && !defined(SIMPLE_WAVE_NO_STDIO) && (defined(__unix__) || defined(__APPLE__))
+#include <sys/types.h>
+#include <unistd.h>
+#if defined(__APPLE__) || (defined(_POSIX_C_SOURCE) && (_POSIX_C_SOURCE >= 200809L))
+#define WAVE_HAS_PWRITE
+#define WAVE_HAS_FSEEKO
+#endif
+#endif
+
+// NUMA placement is opt-in, it relies on Linux syscalls
+#if defined(SIMPLE_WAVE_IMPLEMENTATION) && defined(SIMPLE_WAVE_NUMA) && defined(__linux__) && !defined(SIMPLE_WAVE_NO_STDIO) && !defined(SIMPLE_WAVE_NO_ALLOCATORS)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifndef MAP_ANONYMOUS
+#error "SIMPLE_WAVE_NUMA needs _GNU_SOURCE: include simple_wave.h before any system header or define _GNU_SOURCE when compiling"
+#else
+#define WAVE_HAS_NUMA
+#endif
+#endif
+
+// Growing files are watched with inotify on Linux, other platforms poll
+#if defined(SIMPLE_WAVE_IMPLEMENTATION) && defined(__linux__) && !defined(SIMPLE_WAVE_NO_STDIO)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define WAVE_HAS_INOTIFY
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma pack(push, 1)
+
+#define RIFF_CODE(a, b, c, d) (((uint32_t)(a) << 0) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+    typedef struct RIFF_HEADER
+    {
+        uint32_t riff_id;
+        uint32_t size;
+        uint32_t filetype_id;
+    } RIFF_HEADER;
+
+    typedef struct RIFF_CHUNK
+    {
+        uint32_t id;
+        uint32_t size;
+    } RIFF_CHUNK;
+
+    typedef enum WAVE_FORMAT_TAG
+    {
+        WAVE_FORMAT_TAG_PCM = 0x0001,
+        WAVE_FORMAT_TAG_IEEE_FLOAT = 0x0003,
+        WAVE_FORMAT_TAG_EXTENSIBLE = 0xFFFE,
+    } WAVE_FORMAT_TAG;
+
+    typedef struct WAVE_FORMAT
+    {
+        uint16_t format_tag;
+        uint16_t channels;
+        uint32_t samples_per_sec;
+        uint32_t avg_bytes_per_sec;
+        uint16_t block_align;
+        uint16_t bits_per_sample;
+    } WAVE_FORMAT;
+
+    typedef struct WAVE_FORMAT_EXTENSIBLE
+    {
+        WAVE_FORMAT format;
+        uint16_t extension_size;
+        uint16_t valid_bits_per_sample;
+        uint32_t channel_mask;
+        uint8_t  sub_format[16]; // GUID, the first two bytes hold the actual format tag
+    } WAVE_FORMAT_EXTENSIBLE;
+
+    typedef enum WAVE_CHECKSUM_ALGORITHM
+    {
+        WAVE_CHECKSUM_ALGORITHM_XXH64 = 1,
+    } WAVE_CHECKSUM_ALGORITHM;
+
+    typedef struct WAVE_CHECKSUM
+    {
+        uint32_t algorithm;
+        uint32_t reserved;
+        uint64_t value; // Hash of the data chunk payload
+    } WAVE_CHECKSUM;
+
+#define WAVE_DESC_MAGIC RIFF_CODE('S', 'W', 'D', '2')
+
+    typedef struct WAVE_DESC
+    {
+        uint32_t magic;
+        uint32_t format_chunk_size;
+        uint64_t riff_size;             // Size of the RIFF header plus 8, as stored
+        uint64_t format_chunk_offset;   // Offsets are relative to the RIFF header
+        uint64_t data_chunk_offset;     // 0 when there is no data chunk
+        uint64_t data_chunk_size;       // As stored, it may claim more than the file holds (truncated or live recorded files)
+        uint64_t checksum_chunk_offset; // 0 when there is no checksum chunk
+        uint64_t sample_data_offset;
+        uint64_t sample_data_size;      // Bytes the file actually holds, the buffer must hold at least this much
+        WAVE_FORMAT format;
+    } WAVE_DESC;
+
+#pragma pack(pop)
+
+    typedef enum WAVE_CHUNK
+    {
+        WAVE_CHUNK_FORMAT = RIFF_CODE('f', 'm', 't', ' '),
+        WAVE_CHUNK_DATA = RIFF_CODE('d', 'a', 't', 'a'),
+        WAVE_CHUNK_CHECKSUM = RIFF_CODE('h', 'a', 's', 'h'),
+    } WAVE_CHUNK;
+
+    typedef struct WAVE
+    {
+        void* free_ptr;
+        size_t free_ptr_size;
+
+        RIFF_HEADER* header;
+
+        RIFF_CHUNK* format_chunk;
+        size_t      format_chunk_offset;
+
+        RIFF_CHUNK* data_chunk;
+        size_t      data_chunk_offset;
+
+        RIFF_CHUNK* checksum_chunk;
+        size_t      checksum_chunk_offset;
+
+        void* sample_data;
+        size_t sample_data_size;
+        size_t sample_data_offset;
+
+        WAVE_FORMAT* format;
+
+        int info_only; // Loaded without the samples, the offsets locate the chunks in the file
+        size_t header_offset; // Position of the RIFF header in the file stream, 0 unless loaded with Wave_LoadStreamOnlyInfo
+    } WAVE;
+
+    typedef enum WAVE_SAMPLE_FORMAT
+    {
+        WAVE_SAMPLE_FORMAT_UNKNOWN,
+        WAVE_SAMPLE_FORMAT_U8,
+        WAVE_SAMPLE_FORMAT_S16,
+        WAVE_SAMPLE_FORMAT_S32,
+        WAVE_SAMPLE_FORMAT_F32,
+        WAVE_SAMPLE_FORMAT_F64,
+    } WAVE_SAMPLE_FORMAT;
+
+    typedef void* WAVE_ALLOCATE(void* data, size_t size);
+    typedef void WAVE_FREE(void* data, void* ptr, size_t size);
+
+    typedef struct WAVE_ALLOCATOR
+    {
+        WAVE_ALLOCATE* allocate;
+        WAVE_FREE*     free;
+        void*          data;
+    } WAVE_ALLOCATOR;
+    
+    /*
+      Returns a parsed wave file if the result is not 0.
+      This function does not allocate any memory,
+      you must read the wave file yourself.
+      The data stored in the wave structure is only valid if the given buffer is STILL allocated.
+    */
+    extern int Wave_ParseBuffer(void* buff, size_t size, WAVE* out_wave);
+
+#ifndef SIMPLE_WAVE_NO_STDIO
+    /*
+      Read a wav from the current file stream.
+    */
+    extern int Wave_LoadStream(FILE* file, long size, WAVE* out_wave, WAVE_ALLOCATOR* allocator);
+
+    /*
+     Read a wav from a file path.
+   */
+    extern int Wave_LoadPath(const char* path, WAVE* out_wave, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Read a wav from the current file stream.
+      Only the info is kept in memory, the offsets of the wave are absolute positions in the file stream
+      (the current position plus the offset in the wav) so the samples can be read with a seek to them.
+    */
+    extern int Wave_LoadStreamOnlyInfo(FILE* file, long size, WAVE* out_wave, WAVE_ALLOCATOR* allocator);
+
+    /*
+     Read a wav from a file path.
+   */
+    extern int Wave_LoadPathOnlyInfo(const char* path, WAVE* out_wave, WAVE_ALLOCATOR* allocator);
+#endif // SIMPLE_WAVE_NO_STDIO
+
+    /*
+      Returns the sample format of the stored samples.
+    */
+    extern WAVE_SAMPLE_FORMAT Wave_GetSampleFormat(WAVE* wave);
+
+    /*
+      Returns the length of the stored samples in seconds.
+    */
+    extern float Wave_GetLengthInSeconds(WAVE* wave);
+
+    /*
+      Returns the number of samples per second.
+    */
+    extern int Wave_GetSampleFrequency(WAVE* wave);
+
+    /*
+      Returns the number of channels.
+    */
+    extern int Wave_GetChannelCount(WAVE* wave);
+
+    /*
+      Returns the sample data in the given pointers.
+      Returns 0 if the function failed.
+    */
+    extern int Wave_GetSampleData(WAVE* wave, void** out_samples, size_t* out_samples_size);
+
+    /*
+      Returns the number of samples.
+    */
+    extern int Wave_GetSampleCount(WAVE* wave);
+
+    /*
+      Release internally allocated memory.
+    */
+    extern int Wave_Free(WAVE* wave, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Returns the offset of the sample data in the parsed memory, or in the file stream for waves loaded with only their info.
+    */
+    extern size_t Wave_GetSampleDataOffset(WAVE* wave);
+
+    /*
+      Returns the number of frames (one sample for every channel).
+    */
+    extern size_t Wave_GetFrameCount(WAVE* wave);
+
+    /*
+      Returns the size in bytes of a single sample of the given format.
+    */
+    extern size_t Wave_GetSampleFormatSize(WAVE_SAMPLE_FORMAT sample_format);
+
+    /*
+      Converts sample_count samples of the given format to floats in the range [-1, 1].
+    */
+    extern void Wave_ConvertToFloat(const void* samples, WAVE_SAMPLE_FORMAT sample_format, size_t sample_count, float* out_samples);
+
+    /*
+      Converts sample_count floats to the given format, clamping out of range values.
+    */
+    extern void Wave_ConvertFromFloat(const float* samples, size_t sample_count, WAVE_SAMPLE_FORMAT sample_format, void* out_samples);
+
+    /*
+      Converts frame_count interleaved frames starting at first_frame to floats.
+      The wave must have its sample data in memory.
+      Returns the number of frames written to out_frames.
+    */
+    extern size_t Wave_ReadFramesFloat(WAVE* wave, size_t first_frame, size_t frame_count, float* out_frames);
+
+    typedef struct WAVE_HASH
+    {
+        uint64_t lanes[4];
+        uint64_t total_size;
+        unsigned char buffer[32];
+        size_t buffer_size;
+    } WAVE_HASH;
+
+    /*
+      Streaming XXH64 (seed 0), used for the checksum chunk.
+    */
+    extern void Wave_HashBegin(WAVE_HASH* hash);
+    extern void Wave_HashUpdate(WAVE_HASH* hash, const void* data, size_t size);
+    extern uint64_t Wave_HashEnd(const WAVE_HASH* hash);
+
+#ifndef SIMPLE_WAVE_NO_WRITER
+    typedef struct WAVE_WRITER
+    {
+        FILE* file;
+        WAVE_SAMPLE_FORMAT sample_format;
+        WAVE_FORMAT format;
+
+        uint64_t header_offset;
+        uint64_t data_chunk_offset;
+        size_t frames_written;
+        int dither;
+        int reposition; // Set by Wave_WriterWriteAt, the stream must go back after the last frame before appending
+
+        int checksum;
+        WAVE_HASH hash;
+    } WAVE_WRITER;
+
+    /*
+      Writes the header of a new wav at the current position of the file stream.
+      The file must be seekable, the sizes are patched by Wave_WriterEnd.
+    */
+    extern int Wave_WriterBegin(WAVE_WRITER* writer, FILE* file, WAVE_SAMPLE_FORMAT sample_format, int channels, int samples_per_sec);
+
+    /*
+      Same as Wave_WriterBegin but writes a WAVE_FORMAT_EXTENSIBLE format with the given speaker channel mask.
+    */
+    extern int Wave_WriterBeginExtensible(WAVE_WRITER* writer, FILE* file, WAVE_SAMPLE_FORMAT sample_format, int channels, int samples_per_sec, uint32_t channel_mask);
+
+    /*
+      Returns a channel mask assigning the first speaker positions in order, 0 when there are more channels than positions.
+    */
+    extern uint32_t Wave_GetDefaultChannelMask(int channels);
+
+    /*
+      Appends interleaved frames already stored in the sample format of the writer.
+      Frames are always appended after the last frame stored, including the ones stored with Wave_WriterWriteAt.
+    */
+    extern int Wave_WriterWrite(WAVE_WRITER* writer, const void* frames, size_t frame_count);
+
+    /*
+      Appends interleaved float frames, converting them to the sample format of the writer.
+    */
+    extern int Wave_WriterWriteFloat(WAVE_WRITER* writer, const float* frames, size_t frame_count);
+
+    /*
+      Enables TPDF dither when floats are converted to integer formats.
+      The noise only depends on the position of the sample, so blocks encoded in any order give the same bytes.
+    */
+    extern int Wave_WriterSetDither(WAVE_WRITER* writer, int enabled);
+
+    /*
+      Hashes the frames as they are written and stores the hash in a checksum chunk after the data chunk.
+      Must be called before any frame is written, blocks committed with Wave_WriterWriteAt must then be in order.
+    */
+    extern int Wave_WriterEnableChecksum(WAVE_WRITER* writer);
+
+    /*
+      Converts (and dithers) frame_count float frames that will be stored at first_frame into out_bytes.
+      It does not touch the writer or the file, so blocks can be encoded by parallel workers.
+      out_bytes must hold frame_count * format.block_align bytes.
+    */
+    extern int Wave_WriterEncode(const WAVE_WRITER* writer, const float* frames, size_t first_frame, size_t frame_count, void* out_bytes);
+
+    /*
+      Stores encoded frames at their precomputed offset in the data chunk, with pwrite where available.
+      Commit blocks from a single thread, in order, so the written frame count stays contiguous.
+      The next Wave_WriterWrite or Wave_WriterWriteFloat seeks back after the last frame stored before appending.
+    */
+    extern int Wave_WriterWriteAt(WAVE_WRITER* writer, size_t first_frame, const void* bytes, size_t frame_count);
+
+    /*
+      Pads the data chunk and patches the chunk sizes.
+      The file stream is left at the end of the written wav.
+    */
+    extern int Wave_WriterEnd(WAVE_WRITER* writer);
+#endif // SIMPLE_WAVE_NO_WRITER
+
+#ifndef WAVE_MAX_CHANNELS
+#define WAVE_MAX_CHANNELS 64
+#endif
+
+#ifndef WAVE_TIMELINE_BUCKET_FRAMES
+#define WAVE_TIMELINE_BUCKET_FRAMES 4096
+#endif
+
+#ifndef SIMPLE_WAVE_NO_DSP
+    typedef struct WAVE_CLIP
+    {
+        WAVE* wave;             // Source, its sample data must be addressable (in memory or memory mapped)
+        size_t position;        // Timeline frame where the clip starts
+        size_t source_frame;    // First frame read from the source
+        size_t frame_count;
+        float gain;
+        size_t fade_in_frames;  // Linear ramps, counted inside frame_count
+        size_t fade_out_frames;
+    } WAVE_CLIP;
+
+    typedef struct WAVE_TIMELINE
+    {
+        void* free_ptr;
+        size_t free_ptr_size;
+
+        const WAVE_CLIP* clips;
+        size_t clip_count;
+        int channels;
+        size_t frame_count;
+
+        // Interval index, bucket b holds bucket_clips[bucket_starts[b]..bucket_starts[b+1]]
+        size_t bucket_count;
+        uint32_t* bucket_starts;
+        uint32_t* bucket_clips;
+    } WAVE_TIMELINE;
+
+    /*
+      Builds the interval index of the given clips.
+      The clips array is referenced, it must stay valid while the timeline is used.
+      Sources are read in place and only the frames of the rendered ranges are touched: parse memory mapped files
+      with Wave_ParseBuffer so the system pages in just those ranges instead of loading whole clips.
+      Fails when a clip ends past its source or past the largest frame index.
+      Sources with fewer channels than the timeline are spread when mono, otherwise the missing channels are silent.
+    */
+    extern int Wave_TimelineInit(WAVE_TIMELINE* timeline, const WAVE_CLIP* clips, size_t clip_count, int channels, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Mixes frame_count interleaved float frames starting at first_frame into out_frames.
+      Only the source ranges overlapping the requested frames are converted.
+      Disjoint ranges can be rendered concurrently and produce the same samples as a single render.
+    */
+    extern int Wave_TimelineRender(WAVE_TIMELINE* timeline, size_t first_frame, size_t frame_count, float* out_frames);
+
+    /*
+      Returns in out_first_frame and out_frame_count the slab_index-th of slab_count independent time slabs.
+      Slabs are aligned to the index buckets, so every slab can be rendered by a different thread.
+    */
+    extern int Wave_TimelineGetSlab(WAVE_TIMELINE* timeline, size_t slab_index, size_t slab_count, size_t* out_first_frame, size_t* out_frame_count);
+
+#ifndef SIMPLE_WAVE_NO_WRITER
+    /*
+      Renders the whole timeline to the writer, one bucket at a time.
+    */
+    extern int Wave_TimelineRenderToWriter(WAVE_TIMELINE* timeline, WAVE_WRITER* writer, WAVE_ALLOCATOR* allocator);
+#endif // SIMPLE_WAVE_NO_WRITER
+
+    /*
+      Release the interval index.
+    */
+    extern int Wave_TimelineFree(WAVE_TIMELINE* timeline, WAVE_ALLOCATOR* allocator);
+
+#define WAVE_TRUE_PEAK_PHASES 4
+#define WAVE_TRUE_PEAK_TAPS 12
+
+    typedef struct WAVE_TRUE_PEAK
+    {
+        int channels;
+        size_t frames_processed;
+
+        // Last input frames, interleaved like the input so the filter runs across channel lanes
+        float history[(WAVE_TRUE_PEAK_TAPS - 1) * WAVE_MAX_CHANNELS];
+
+        float peak[WAVE_MAX_CHANNELS];
+        size_t peak_frame[WAVE_MAX_CHANNELS];
+    } WAVE_TRUE_PEAK;
+
+    /*
+      Prepares a true-peak meter (4x oversampling, BS.1770 polyphase FIR) for the given channel count.
+    */
+    extern int Wave_TruePeakInit(WAVE_TRUE_PEAK* meter, int channels);
+
+    /*
+      Feeds interleaved float frames, blocks of any size can be streamed one after another.
+    */
+    extern int Wave_TruePeakProcess(WAVE_TRUE_PEAK* meter, const float* frames, size_t frame_count);
+
+    /*
+      Feeds all the frames of a wave with its sample data in memory.
+    */
+    extern int Wave_TruePeakProcessWave(WAVE_TRUE_PEAK* meter, WAVE* wave);
+
+    /*
+      Flushes the filter at the end of the stream so the last frames are measured too.
+    */
+    extern int Wave_TruePeakFinish(WAVE_TRUE_PEAK* meter);
+
+    /*
+      Returns the true-peak of a channel in dBTP, out_frame receives the input frame where it was found.
+    */
+    extern float Wave_TruePeakGetDecibels(WAVE_TRUE_PEAK* meter, int channel, size_t* out_frame);
+
+    /*
+      In-place complex FFT, size must be a power of two.
+      The inverse transform is not scaled.
+    */
+    extern int Wave_FFT(float* real, float* imag, size_t size, int inverse);
+
+    /*
+      Fills the size / 2 cosines followed by the size / 2 sines of the twiddles of a transform of size.
+    */
+    extern int Wave_FFTTwiddles(float* out_twiddles, size_t size);
+
+    /*
+      Same transform as Wave_FFT with twiddles filled by Wave_FFTTwiddles for the same size,
+      repeated transforms of one size then skip the cos and sin calls.
+    */
+    extern int Wave_FFTWithTwiddles(float* real, float* imag, size_t size, int inverse, const float* twiddles);
+
+#define WAVE_ONSET_FRAME_SIZE 1024
+#define WAVE_ONSET_HOP_SIZE 512
+#define WAVE_ONSET_AVERAGE_HOPS 16
+
+    /*
+      Detects onsets with a spectral flux detector on a wave with its sample data in memory.
+      Only onsets inside [first_frame, first_frame + frame_count) are reported, but the analysis
+      runs on a fixed hop grid of the whole wave, so splitting a long file in segments (e.g. one per thread)
+      and concatenating the results in order gives exactly the onsets of a single pass.
+      threshold is added to the running average of the flux, 0.05 is a sensible default.
+      out_onset_count receives the number of onsets found, at most max_onsets are stored.
+    */
+    extern int Wave_DetectOnsets(WAVE* wave, size_t first_frame, size_t frame_count, float threshold, size_t* out_frames, size_t max_onsets, size_t* out_onset_count);
+
+#define WAVE_LEVELS_BLOCK_FRAMES 4096
+#define WAVE_LEVELS_STACK_DEPTH 48
+
+    typedef struct WAVE_LEVELS
+    {
+        int channels;
+        size_t frame_count;
+        float peak[WAVE_MAX_CHANNELS];
+        double sum_squares[WAVE_MAX_CHANNELS];
+    } WAVE_LEVELS;
+
+    /*
+      Peak and RMS analysis reduced in a fixed order: sums are taken per block of WAVE_LEVELS_BLOCK_FRAMES
+      frames and blocks are merged pairwise like a binary counter, so the result only depends on the samples,
+      never on how the work was split between threads.
+    */
+    typedef struct WAVE_LEVELS_STATE
+    {
+        size_t block_count;
+        WAVE_LEVELS pending;
+        WAVE_LEVELS stack[WAVE_LEVELS_STACK_DEPTH]; // stack[i] holds 2^i blocks when bit i of block_count is set
+    } WAVE_LEVELS_STATE;
+
+    /*
+      Prepares an empty analysis for the given channel count.
+    */
+    extern int Wave_LevelsBegin(WAVE_LEVELS_STATE* state, int channels);
+
+    /*
+      Feeds interleaved float frames, blocks of any size can be streamed one after another.
+    */
+    extern int Wave_LevelsProcess(WAVE_LEVELS_STATE* state, const float* frames, size_t frame_count);
+
+    /*
+      Feeds all the frames of a wave with its sample data in memory.
+    */
+    extern int Wave_LevelsProcessWave(WAVE_LEVELS_STATE* state, WAVE* wave);
+
+    /*
+      Returns the reduction of everything processed so far, the state can keep being fed afterwards.
+    */
+    extern int Wave_LevelsGetResult(WAVE_LEVELS_STATE* state, WAVE_LEVELS* out_levels);
+
+    /*
+      Computes one partial per block for blocks [first_block, first_block + block_count) of a wave in memory.
+      Workers can fill disjoint parts of the same array, Wave_LevelsCombine then gives the exact result of Wave_LevelsProcessWave.
+    */
+    extern int Wave_LevelsComputeBlocks(WAVE* wave, size_t first_block, size_t block_count, WAVE_LEVELS* out_blocks);
+
+    /*
+      Appends per-block partials to the state in the same fixed order as the streaming analysis.
+      The state must be at a block boundary, only the last partial may hold fewer frames than a block.
+    */
+    extern int Wave_LevelsCombine(WAVE_LEVELS_STATE* state, const WAVE_LEVELS* blocks, size_t block_count);
+
+    /*
+      Returns the RMS of a channel in dBFS.
+    */
+    extern float Wave_LevelsGetRmsDecibels(WAVE_LEVELS* levels, int channel);
+
+    /*
+      Returns the sample peak of a channel in dBFS.
+    */
+    extern float Wave_LevelsGetPeakDecibels(WAVE_LEVELS* levels, int channel);
+#endif // SIMPLE_WAVE_NO_DSP
+
+#ifndef SIMPLE_WAVE_NO_STDIO
+    typedef struct WAVE_READER
+    {
+        FILE* file;
+        WAVE wave; // Info only, sample_data_offset locates the frames in the file
+        WAVE_SAMPLE_FORMAT sample_format;
+        size_t frame_count;
+        size_t frame_position;
+
+        // Frames read in order from the start are hashed on the way
+        WAVE_HASH hash;
+        size_t hashed_frames;
+    } WAVE_READER;
+
+    /*
+      Reads the info of the wav at the current position of the file stream and prepares to stream its frames.
+    */
+    extern int Wave_ReaderOpen(WAVE_READER* reader, FILE* file, long size, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Moves the read position to the given frame.
+    */
+    extern int Wave_ReaderSeek(WAVE_READER* reader, size_t frame);
+
+    /*
+      Reads up to frame_count interleaved frames in the sample format of the file.
+      Returns the number of frames read.
+    */
+    extern size_t Wave_ReaderRead(WAVE_READER* reader, void* out_frames, size_t frame_count);
+
+    /*
+      Reads up to frame_count interleaved frames converted to floats.
+      Returns the number of frames read.
+    */
+    extern size_t Wave_ReaderReadFloat(WAVE_READER* reader, float* out_frames, size_t frame_count);
+
+    /*
+      Returns 1 if the wav has a checksum chunk matching its data chunk.
+      Frames already read in order were hashed while streaming, only the rest is read here.
+      The read position is preserved.
+    */
+    extern int Wave_ReaderVerifyChecksum(WAVE_READER* reader);
+#endif // SIMPLE_WAVE_NO_STDIO
+
+    /*
+      Returns 1 if the wave has a checksum chunk matching its sample data in memory.
+    */
+    extern int Wave_VerifyChecksum(WAVE* wave);
+
+#ifndef SIMPLE_WAVE_NO_STDIO
+    /*
+      Release the info of the reader, the file stream is not closed.
+    */
+    extern int Wave_ReaderClose(WAVE_READER* reader, WAVE_ALLOCATOR* allocator);
+#endif // SIMPLE_WAVE_NO_STDIO
+
+    /*
+      Copies interleaved frames to one buffer per channel in a single pass.
+      NULL entries in out_channels are skipped.
+    */
+    extern void Wave_Deinterleave(const void* frames, size_t frame_count, int channel_count, WAVE_SAMPLE_FORMAT sample_format, void** out_channels);
+
+#ifndef SIMPLE_WAVE_NO_WRITER
+#define WAVE_SPLIT_BLOCK_FRAMES 4096
+
+    /*
+      Splits the remaining frames of the reader in mono wavs, one per channel, in a single read of the data chunk.
+      outputs holds one seekable file stream per channel, NULL entries are skipped.
+      Samples are copied in their original format.
+    */
+    extern int Wave_SplitChannels(WAVE_READER* reader, FILE** outputs, WAVE_ALLOCATOR* allocator);
+#endif // SIMPLE_WAVE_NO_WRITER
+
+    /*
+      Copies one buffer per channel into interleaved frames in a single pass.
+      NULL entries in channels are written as silence.
+    */
+    extern void Wave_Interleave(const void* const* channels, size_t frame_count, int channel_count, WAVE_SAMPLE_FORMAT sample_format, void* out_frames);
+
+#ifndef SIMPLE_WAVE_NO_WRITER
+#define WAVE_MERGE_BLOCK_FRAMES 4096
+
+    /*
+      Merges mono readers into one interleaved WAVE_FORMAT_EXTENSIBLE wav with the given channel mask.
+      The inputs are read in lockstep one block at a time, shorter inputs are padded with silence.
+      All inputs must share the same sample format and rate.
+    */
+    extern int Wave_MergeChannels(WAVE_READER* inputs, int input_count, FILE* output, uint32_t channel_mask, WAVE_ALLOCATOR* allocator);
+#endif // SIMPLE_WAVE_NO_WRITER
+
+#ifndef SIMPLE_WAVE_NO_ALLOCATORS
+    typedef struct WAVE_POOL
+    {
+        unsigned char* memory;
+        size_t block_size;
+        size_t block_count;
+        void* free_list;
+    } WAVE_POOL;
+
+    /*
+      Carves the given memory in fixed size blocks, allocations larger than a block fail.
+      The pool is not thread safe.
+    */
+    extern int Wave_PoolInit(WAVE_POOL* pool, void* memory, size_t memory_size, size_t block_size);
+
+    /*
+      Fills out_allocator with callbacks allocating from the pool.
+    */
+    extern int Wave_PoolGetAllocator(WAVE_POOL* pool, WAVE_ALLOCATOR* out_allocator);
+#endif // SIMPLE_WAVE_NO_ALLOCATORS
+
+#ifndef SIMPLE_WAVE_NO_STDIO
+    /*
+      A sample whose first frames stay in memory while the rest is streamed from disk on demand.
+    */
+    typedef struct WAVE_HYBRID_SAMPLE
+    {
+        FILE* file;
+        WAVE wave; // Info only
+        WAVE_SAMPLE_FORMAT sample_format;
+        size_t frame_count;
+
+        void* head;
+        size_t head_size;
+        size_t head_frames;
+    } WAVE_HYBRID_SAMPLE;
+
+    /*
+      One playback of a hybrid sample. The audio thread reads the head from memory and the tail from a ring
+      that an I/O thread keeps filled, the two counters are the only state shared between them.
+    */
+    typedef struct WAVE_HYBRID_VOICE
+    {
+        WAVE_HYBRID_SAMPLE* sample;
+        unsigned char* ring;
+        size_t ring_frames;
+
+        size_t ring_write; // Tail frames fetched, written by the I/O thread
+        size_t ring_read;  // Tail frames played, written by the audio thread
+
+        size_t position;   // Written by the audio thread
+        size_t underruns;
+    } WAVE_HYBRID_VOICE;
+
+    /*
+      Reads the info of the wav and keeps up to head_size bytes of its first frames in memory allocated from head_allocator (e.g. a WAVE_POOL).
+      The file stream must stay open, the tail is streamed from it.
+    */
+    extern int Wave_HybridOpen(WAVE_HYBRID_SAMPLE* sample, FILE* file, long size, size_t head_size, WAVE_ALLOCATOR* head_allocator, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Release the head and the info of the sample.
+    */
+    extern int Wave_HybridClose(WAVE_HYBRID_SAMPLE* sample, WAVE_ALLOCATOR* head_allocator, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Starts a voice at the first frame, ring_memory must hold ring_frames frames.
+      Nothing is read from disk here: the head covers the start while the I/O thread fills the ring.
+      Hand the voice to the I/O thread only after this call, and reuse it only once that thread is done with it.
+    */
+    extern int Wave_HybridVoiceStart(WAVE_HYBRID_VOICE* voice, WAVE_HYBRID_SAMPLE* sample, void* ring_memory, size_t ring_frames);
+
+    /*
+      Called by the I/O thread, fills the free space of the ring with the next tail frames.
+      Returns the number of frames fetched.
+    */
+    extern size_t Wave_HybridVoiceService(WAVE_HYBRID_VOICE* voice);
+
+    /*
+      Called by the I/O thread, returns in out_offset the file offset of the next missing tail frame
+      and in out_frame_count how many frames fit in the free space of the ring.
+    */
+    extern int Wave_HybridVoiceGetRefill(WAVE_HYBRID_VOICE* voice, uint64_t* out_offset, size_t* out_frame_count);
+
+    /*
+      Called by the I/O thread, appends frames read from the offset returned by Wave_HybridVoiceGetRefill to the ring.
+    */
+    extern int Wave_HybridVoiceCommitRefill(WAVE_HYBRID_VOICE* voice, const void* frames, size_t frame_count);
+
+    /*
+      Called by the audio thread, reads up to frame_count frames in the sample format of the file.
+      Returns fewer frames at the end of the sample or when the ring ran dry (counted in underruns).
+    */
+    extern size_t Wave_HybridVoiceRead(WAVE_HYBRID_VOICE* voice, void* out_frames, size_t frame_count);
+
+    /*
+      Same as Wave_HybridVoiceRead with the frames converted to floats.
+    */
+    extern size_t Wave_HybridVoiceReadFloat(WAVE_HYBRID_VOICE* voice, float* out_frames, size_t frame_count);
+
+    /*
+      Returns the frames that can be played before the voice needs more of its tail.
+    */
+    extern size_t Wave_HybridVoiceGetBufferedFrames(WAVE_HYBRID_VOICE* voice);
+
+    typedef struct WAVE_STREAM_REQUEST
+    {
+        WAVE_HYBRID_VOICE* voice;
+        FILE* file;
+        uint64_t offset;
+        size_t size;
+        size_t deadline; // Frames the voice can still play before it runs dry
+        int urgent;
+    } WAVE_STREAM_REQUEST;
+
+    /*
+      Collects the refills of many streaming voices and turns them into few large reads:
+      urgent requests (deadline below urgent_frames) go first, closest deadline first,
+      the others are sorted by file and offset, and neighbouring requests are read together.
+      It is meant to be driven by a single I/O thread.
+    */
+    typedef struct WAVE_STREAM_SCHEDULER
+    {
+        WAVE_STREAM_REQUEST* requests;
+        size_t request_capacity;
+        size_t request_count;
+
+        unsigned char* buffer; // Staging memory for a coalesced read
+        size_t buffer_size;
+
+        size_t urgent_frames;
+        size_t min_request_frames;
+        size_t max_gap;        // Bytes that may be read and thrown away to join two requests
+    } WAVE_STREAM_SCHEDULER;
+
+    /*
+      Prepares a scheduler with caller provided request and staging memory.
+      Voices with fewer than min_request_frames free ring frames are not refilled unless they are urgent.
+    */
+    extern int Wave_SchedulerInit(WAVE_STREAM_SCHEDULER* scheduler, WAVE_STREAM_REQUEST* requests, size_t request_capacity, void* buffer, size_t buffer_size, size_t urgent_frames, size_t min_request_frames);
+
+    /*
+      Queues the refill of a voice, if it needs one.
+      Returns 0 when the voice is already queued, a voice gets at most one refill per Wave_SchedulerService.
+    */
+    extern int Wave_SchedulerSubmit(WAVE_STREAM_SCHEDULER* scheduler, WAVE_HYBRID_VOICE* voice);
+
+    /*
+      Issues the queued refills as ordered and coalesced batched reads, then empties the queue.
+      Returns the number of frames delivered to the voices.
+    */
+    extern size_t Wave_SchedulerService(WAVE_STREAM_SCHEDULER* scheduler);
+#endif // SIMPLE_WAVE_NO_STDIO
+
+    typedef struct WAVE_BUFFER
+    {
+        void* data;
+        size_t size;
+    } WAVE_BUFFER;
+
+#ifndef WAVE_PARSE_PREFETCH_DISTANCE
+#define WAVE_PARSE_PREFETCH_DISTANCE 8
+#endif
+
+    /*
+      Calls Wave_ParseBuffer on count buffers, prefetching the headers of the buffers a few entries ahead.
+      out_results receives the result of every buffer and can be NULL.
+      Calls on disjoint parts of the arrays are independent, split them between threads to parse in parallel.
+      Returns the number of buffers parsed successfully.
+    */
+    extern size_t Wave_ParseBuffers(const WAVE_BUFFER* buffers, size_t count, WAVE* out_waves, int* out_results);
+
+    /*
+      Fills a pointer-free description of the wave that can be stored, sent to another process or copied anywhere.
+      The offsets are relative to the RIFF header whatever the wave was loaded with, a wav read with Wave_LoadStreamOnlyInfo
+      from the middle of a file gives the description of the same wav parsed from a buffer.
+    */
+    extern int Wave_GetDesc(WAVE* wave, WAVE_DESC* out_desc);
+
+    /*
+      Rebinds a description to a buffer (or mapping) holding the same wav, starting at its RIFF header, without parsing it.
+      Only the bounds, the ids and the sizes of the described chunks are checked.
+      The data stored in the wave structure is only valid while the given buffer is STILL allocated.
+    */
+    extern int Wave_BindDesc(const WAVE_DESC* desc, void* buff, size_t size, WAVE* out_wave);
+
+    /*
+      Offset based accessors, they only read the *_offset fields so they keep working after the buffer
+      the wave was parsed from has been moved: pass the new address of the buffer as base.
+    */
+    extern RIFF_HEADER* Wave_GetHeaderAt(const WAVE* wave, void* base);
+    extern RIFF_CHUNK* Wave_GetFormatChunkAt(const WAVE* wave, void* base);
+    extern RIFF_CHUNK* Wave_GetDataChunkAt(const WAVE* wave, void* base);
+    extern WAVE_FORMAT* Wave_GetFormatAt(const WAVE* wave, void* base);
+    extern void* Wave_GetSampleDataAt(const WAVE* wave, void* base);
+
+    /*
+      Points every pointer of a wave parsed from a buffer to the buffer now at base, without parsing it again.
+      Waves loaded with only their info cannot be relocated, their offsets refer to the file.
+    */
+    extern int Wave_Relocate(WAVE* wave, void* base);
+
+    /*
+      Converts the frames of a wave to floats one page at a time, on first access, into a small LRU cache.
+      A view is not thread safe, use one per thread.
+    */
+    typedef struct WAVE_FLOAT_VIEW
+    {
+        void* free_ptr;
+        size_t free_ptr_size;
+
+        WAVE* wave;
+        size_t page_frames;
+        size_t slot_count;
+
+        float* pages;
+        size_t* slot_pages; // Page held by each slot, (size_t)-1 when empty
+        size_t* slot_uses;  // Last access of each slot
+        size_t clock;
+    } WAVE_FLOAT_VIEW;
+
+    /*
+      Prepares a view over a wave with its sample data in memory, caching up to cache_pages pages of page_frames frames.
+    */
+    extern int Wave_ViewInit(WAVE_FLOAT_VIEW* view, WAVE* wave, size_t page_frames, size_t cache_pages, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Returns the interleaved float frames of a page, converting it if it is not cached.
+      The pointer stays valid until cache_pages other pages have been accessed.
+    */
+    extern const float* Wave_ViewGetPage(WAVE_FLOAT_VIEW* view, size_t page, size_t* out_frame_count);
+
+    /*
+      Returns the float frames starting at frame, out_frame_count receives how many follow in the same page.
+    */
+    extern const float* Wave_ViewGetFrames(WAVE_FLOAT_VIEW* view, size_t frame, size_t* out_frame_count);
+
+    /*
+      Release the cache of the view.
+    */
+    extern int Wave_ViewFree(WAVE_FLOAT_VIEW* view, WAVE_ALLOCATOR* allocator);
+
+#ifndef SIMPLE_WAVE_NO_ALLOCATORS
+    typedef struct WAVE_NUMA_POLICY
+    {
+        int node; // Negative to interleave the pages across every node
+    } WAVE_NUMA_POLICY;
+
+    /*
+      Returns the number of NUMA nodes, 1 when NUMA support is not compiled in (define SIMPLE_WAVE_NUMA on Linux).
+    */
+    extern int Wave_NumaGetNodeCount(void);
+
+    /*
+      Fills out_allocator with callbacks placing every allocation on the given node, or interleaving it across nodes if node is negative.
+      The policy is referenced by the allocator and must outlive it.
+      Without NUMA support the default allocator is returned.
+    */
+    extern int Wave_NumaGetAllocator(WAVE_NUMA_POLICY* policy, int node, WAVE_ALLOCATOR* out_allocator);
+
+    /*
+      Returns the node owning the memory at the given address, -1 if unknown.
+    */
+    extern int Wave_NumaGetNodeOfAddress(const void* ptr);
+
+    /*
+      Returns the node owning the given frame of a wave in memory, so work on interleaved buffers
+      can be split into ranges handled by workers of the matching node.
+    */
+    extern int Wave_NumaGetNodeOfFrame(WAVE* wave, size_t frame);
+
+    /*
+      Restricts the calling thread to the CPUs of the given node, call it at the start of a worker.
+      Returns 0 if it failed or NUMA support is not compiled in.
+    */
+    extern int Wave_NumaBindThread(int node);
+#endif // SIMPLE_WAVE_NO_ALLOCATORS
+
+
+#ifndef SIMPLE_WAVE_NO_STDIO
+    typedef struct WAVE_PIPE
+    {
+        FILE* file;
+        WAVE wave; // Info only, filled from the chunks before the data chunk, offsets count the bytes consumed
+        WAVE_SAMPLE_FORMAT sample_format;
+        size_t frame_position;
+
+        // Live recorders leave the data size at 0xFFFFFFFF, or at 0 with the RIFF size unset too (0 or 0xFFFFFFFF),
+        // frames are then read until the end of the stream
+        int unbounded;
+        uint64_t data_remaining;
+    } WAVE_PIPE;
+
+    /*
+      Reads the info of a wav from a forward-only stream such as stdin or a pipe, stopping at the start of its data chunk.
+      Chunks are handled in order and never seeked, chunks after the data chunk are not seen.
+    */
+    extern int Wave_PipeOpen(WAVE_PIPE* pipe, FILE* file, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Reads up to frame_count interleaved frames in the sample format of the stream, blocking until they arrive.
+      Nothing is buffered beyond the frames requested.
+      Returns the number of frames read, less than frame_count only at the end of the data.
+    */
+    extern size_t Wave_PipeRead(WAVE_PIPE* pipe, void* out_frames, size_t frame_count);
+
+    /*
+      Reads up to frame_count interleaved frames converted to floats.
+      Returns the number of frames read.
+    */
+    extern size_t Wave_PipeReadFloat(WAVE_PIPE* pipe, float* out_frames, size_t frame_count);
+
+    /*
+      Release the info of the pipe, the file stream is not closed.
+    */
+    extern int Wave_PipeClose(WAVE_PIPE* pipe, WAVE_ALLOCATOR* allocator);
+
+
+    typedef struct WAVE_TAIL
+    {
+        FILE* file;
+        WAVE wave; // Info only, the data size in the header may be stale while recording
+        WAVE_SAMPLE_FORMAT sample_format;
+        size_t frame_position;
+        size_t frame_count; // Frames on disk as of the last update
+        int notify_fd;      // inotify instance on Linux, -1 when changes are polled
+    } WAVE_TAIL;
+
+    /*
+      Opens a wav that is still being recorded, its header and format must already be on disk.
+    */
+    extern int Wave_TailOpen(WAVE_TAIL* tail, const char* path, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Refreshes the frames on disk from the file size and block align, waiting up to timeout_ms for the file
+      to change if no unread frames are left (inotify on Linux, elsewhere it returns at once and the caller polls).
+      Once the RIFF size covers the whole file the recording is complete and the data size of the header is used instead.
+      Returns the number of frames that can be read.
+    */
+    extern size_t Wave_TailUpdate(WAVE_TAIL* tail, int timeout_ms);
+
+    /*
+      Reads up to frame_count new interleaved frames in the sample format of the file, never past the last update.
+      Returns the number of frames read.
+    */
+    extern size_t Wave_TailRead(WAVE_TAIL* tail, void* out_frames, size_t frame_count);
+
+    /*
+      Reads up to frame_count new interleaved frames converted to floats.
+      Returns the number of frames read.
+    */
+    extern size_t Wave_TailReadFloat(WAVE_TAIL* tail, float* out_frames, size_t frame_count);
+
+    /*
+      Closes the file and releases the info of the tail.
+    */
+    extern int Wave_TailClose(WAVE_TAIL* tail, WAVE_ALLOCATOR* allocator);
+#endif // SIMPLE_WAVE_NO_STDIO
+
+
+#ifndef SIMPLE_WAVE_NO_DSP
+#define WAVE_LEVELS_STATE_MAGIC RIFF_CODE('S', 'W', 'L', '1')
+#define WAVE_TRUE_PEAK_MAGIC RIFF_CODE('S', 'W', 'T', '1')
+
+    /*
+      Saves a levels analysis mid-stream so it can be resumed later, once the wav has grown, by feeding only the
+      frames after the saved frame count. Writes to out_buffer and returns the size written, or only the size
+      needed if out_buffer is NULL. Returns 0 if buffer_size is too small.
+      The data is in host byte order and tagged with a version, it is only loaded by builds with the same block size.
+      There is no overview pyramid to save: overviews are the per block levels of Wave_LevelsComputeBlocks, which
+      only need computing again from the last, possibly partial, block on.
+    */
+    extern size_t Wave_LevelsSave(const WAVE_LEVELS_STATE* state, void* out_buffer, size_t buffer_size);
+
+    /*
+      Restores a levels analysis saved with Wave_LevelsSave, results match an analysis that never stopped.
+    */
+    extern int Wave_LevelsLoad(WAVE_LEVELS_STATE* state, const void* buffer, size_t size);
+
+    /*
+      Returns the number of frames a levels analysis was fed, the frame to resume from.
+    */
+    extern size_t Wave_LevelsGetFrameCount(const WAVE_LEVELS_STATE* state);
+
+    /*
+      Saves a true-peak meter mid-stream, including its filter history, like Wave_LevelsSave.
+      Resume by feeding the frames from meter->frames_processed on.
+    */
+    extern size_t Wave_TruePeakSave(const WAVE_TRUE_PEAK* meter, void* out_buffer, size_t buffer_size);
+
+    /*
+      Restores a true-peak meter saved with Wave_TruePeakSave.
+    */
+    extern int Wave_TruePeakLoad(WAVE_TRUE_PEAK* meter, const void* buffer, size_t size);
+
+
+#define WAVE_RESAMPLE_DEFAULT_TAPS 32
+#define WAVE_RESAMPLE_MAX_TAPS 256
+#define WAVE_RESAMPLE_MAX_PHASES 65536
+#define WAVE_RESAMPLE_BLOCK_FRAMES 256
+#define WAVE_RESAMPLE_CACHE_SIZE 16
+#define WAVE_RESAMPLE_CUTOFF 0.9 // Passband edge as a fraction of the lower Nyquist frequency
+
+    /*
+      Polyphase coefficients for one rational ratio, read only once built so it can be shared by any number
+      of resamplers and threads converting at that ratio.
+    */
+    typedef struct WAVE_RESAMPLE_TABLE
+    {
+        void* free_ptr;
+        size_t free_ptr_size;
+
+        uint32_t up;   // L, the ratio reduced to out_rate / in_rate = up / down
+        uint32_t down; // M
+        int taps;      // Taps per phase
+        const float* coefficients; // up phases of taps coefficients, oldest input first
+    } WAVE_RESAMPLE_TABLE;
+
+    /*
+      Builds the table converting in_rate to out_rate (windowed sinc, taps per phase, 0 for the default).
+    */
+    extern int Wave_ResampleTableInit(WAVE_RESAMPLE_TABLE* table, uint32_t in_rate, uint32_t out_rate, int taps, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Returns the exact number of frames the conversion of frame_count input frames produces, ceil(frame_count * L / M).
+    */
+    extern uint64_t Wave_ResampleGetOutputLength(const WAVE_RESAMPLE_TABLE* table, uint64_t frame_count);
+
+    extern int Wave_ResampleTableFree(WAVE_RESAMPLE_TABLE* table, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Tables kept per ratio and taps, each built on its first request, so a batch converting many files between
+      a few rates builds every table once. Fill it from one thread, the tables it returns are read only.
+    */
+    typedef struct WAVE_RESAMPLE_CACHE
+    {
+        WAVE_RESAMPLE_TABLE tables[WAVE_RESAMPLE_CACHE_SIZE];
+        size_t count;
+    } WAVE_RESAMPLE_CACHE;
+
+    extern int Wave_ResampleCacheInit(WAVE_RESAMPLE_CACHE* cache);
+
+    /*
+      Returns the cached table converting in_rate to out_rate, building it when missing.
+      Fails when the cache is full and the ratio is not in it. The table lives until Wave_ResampleCacheFree.
+    */
+    extern int Wave_ResampleCacheGet(WAVE_RESAMPLE_CACHE* cache, uint32_t in_rate, uint32_t out_rate, int taps, const WAVE_RESAMPLE_TABLE** out_table, WAVE_ALLOCATOR* allocator);
+
+    extern int Wave_ResampleCacheFree(WAVE_RESAMPLE_CACHE* cache, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Streaming L/M converter. Positions are kept as integer frame counts so blocks of any size give the same
+      output as one call, without drift, and the total output length is exact once finished.
+      Output frame k is aligned to input position k * M / L, the filter delay is compensated.
+    */
+    typedef struct WAVE_RESAMPLER
+    {
+        void* free_ptr;
+        size_t free_ptr_size;
+
+        const WAVE_RESAMPLE_TABLE* table;
+        int channels;
+        uint64_t input_frames;  // Frames fed so far
+        uint64_t output_frames; // Frames produced so far
+
+        // Input frames from buffer_first on (counted from taps - 1 frames of silence before the start), interleaved
+        float* buffer;
+        size_t buffer_frames;
+        size_t buffer_capacity;
+        uint64_t buffer_first;
+    } WAVE_RESAMPLER;
+
+    /*
+      Prepares a resampler using the given table, which must outlive it.
+    */
+    extern int Wave_ResamplerInit(WAVE_RESAMPLER* resampler, const WAVE_RESAMPLE_TABLE* table, int channels, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Returns how many frames out_frames must hold for Wave_ResamplerProcess with frame_count input frames,
+      or for Wave_ResamplerFinish when frame_count is 0.
+    */
+    extern size_t Wave_ResamplerGetMaxOutput(const WAVE_RESAMPLER* resampler, size_t frame_count);
+
+    /*
+      Feeds interleaved float frames and writes every output frame they complete.
+      Returns the number of frames written.
+    */
+    extern size_t Wave_ResamplerProcess(WAVE_RESAMPLER* resampler, const float* frames, size_t frame_count, float* out_frames);
+
+    /*
+      Flushes the filter with silence and writes the last frames, the total output is then Wave_ResampleGetOutputLength
+      of the frames fed. Returns the number of frames written.
+    */
+    extern size_t Wave_ResamplerFinish(WAVE_RESAMPLER* resampler, float* out_frames);
+
+    extern int Wave_ResamplerFree(WAVE_RESAMPLER* resampler, WAVE_ALLOCATOR* allocator);
+
+
+#define WAVE_VAD_FRAME_MS 20
+#define WAVE_VAD_MAX_FFT_SIZE 4096
+#define WAVE_VAD_ENERGY_MARGIN 9.0f    // dB above the noise floor for a frame to count as speech
+#define WAVE_VAD_MIN_ENERGY -60.0f     // dBFS below which a frame is never speech
+#define WAVE_VAD_MAX_FLATNESS 0.35f    // Spectral flatness in the speech band, noise is close to 1
+#define WAVE_VAD_MAX_ZERO_CROSSINGS 0.3f // Per sample, fricatives are kept by the hangover
+#define WAVE_VAD_MIN_SPEECH_FRAMES 3
+#define WAVE_VAD_HANGOVER_FRAMES 15
+
+    typedef struct WAVE_VAD_SEGMENT
+    {
+        int channel;
+        size_t first_frame;
+        size_t frame_count;
+    } WAVE_VAD_SEGMENT;
+
+    typedef struct WAVE_VAD_CHANNEL
+    {
+        float noise_floor; // dBFS, tracked on frames judged as non speech
+        int active;
+        size_t speech_run;  // Consecutive speech frames
+        size_t silence_run; // Frames since the last speech frame of an active segment
+        size_t segment_start;
+    } WAVE_VAD_CHANNEL;
+
+    /*
+      Voice activity detector, every channel is segmented on its own.
+      Frames of WAVE_VAD_FRAME_MS are judged as speech when their energy rises above the tracked noise floor
+      and either their spectrum in the 300-3400 Hz band is not flat or they cross zero rarely.
+    */
+    typedef struct WAVE_VAD
+    {
+        void* free_ptr;
+        size_t free_ptr_size;
+
+        int channels;
+        uint32_t sample_rate;
+        size_t frame_size; // Samples per analysis frame
+        size_t fft_size;
+        size_t frame_position; // Frames fed so far
+        float* pending;        // Interleaved frames of the incomplete analysis frame
+        size_t pending_frames;
+        float* window;         // Hann window of frame_size samples
+        float* twiddles;       // Of the fft_size transform
+        WAVE_VAD_CHANNEL state[WAVE_MAX_CHANNELS];
+    } WAVE_VAD;
+
+    /*
+      Prepares a detector for the given channel count and sample rate.
+    */
+    extern int Wave_VadInit(WAVE_VAD* vad, int channels, uint32_t sample_rate, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Feeds interleaved float frames, segments that ended are written to out_segments.
+      out_segment_count receives the number of segments found, at most max_segments are stored.
+    */
+    extern int Wave_VadProcess(WAVE_VAD* vad, const float* frames, size_t frame_count, WAVE_VAD_SEGMENT* out_segments, size_t max_segments, size_t* out_segment_count);
+
+    /*
+      Closes the segments still open at the end of the stream, the detector can then be fed a new stream.
+    */
+    extern int Wave_VadFinish(WAVE_VAD* vad, WAVE_VAD_SEGMENT* out_segments, size_t max_segments, size_t* out_segment_count);
+
+#ifndef SIMPLE_WAVE_NO_STDIO
+    /*
+      Segments the remaining frames of a reader, the detector is restarted for it.
+    */
+    extern int Wave_VadProcessReader(WAVE_VAD* vad, WAVE_READER* reader, WAVE_VAD_SEGMENT* out_segments, size_t max_segments, size_t* out_segment_count);
+
+    /*
+      Segments many readers (e.g. short telephony files) with one detector whose buffers are reused.
+      The segments of every reader are stored one after another, out_segment_counts receives the number found
+      per reader and at most max_segments are stored in total.
+      A call runs on one thread (about 1000 files/s for 3 s 8 kHz mono files on one core). Calls on disjoint slices
+      of the readers, each with its own segment and count arrays, are independent: split a batch between threads
+      to scale, with a thread-safe allocator (the default one is) or one allocator per thread.
+    */
+    extern int Wave_VadProcessReaders(WAVE_READER* readers, size_t reader_count, WAVE_VAD_SEGMENT* out_segments, size_t max_segments, size_t* out_segment_counts, WAVE_ALLOCATOR* allocator);
+#endif // SIMPLE_WAVE_NO_STDIO
+
+    extern int Wave_VadFree(WAVE_VAD* vad, WAVE_ALLOCATOR* allocator);
+
+
+    typedef struct WAVE_STEREO_SUMS
+    {
+        size_t frame_count;
+        double left;    // Sum of L * L
+        double right;   // Sum of R * R
+        double product; // Sum of L * R, mid and side energies follow from the three sums
+    } WAVE_STEREO_SUMS;
+
+    typedef struct WAVE_STEREO_RESULT
+    {
+        size_t first_frame;
+        size_t frame_count;
+        float correlation; // -1 (opposite phase) to 1 (mono), 0 for silence
+        float balance_db;  // Left over right energy, positive when the left is louder
+        float side_db;     // Side over mid energy
+        float mono_db;     // Level of the mono fold-down (L + R) / 2 against the stereo level, 0 for mono, -3 for uncorrelated
+    } WAVE_STEREO_RESULT;
+
+    /*
+      Stereo correlation, balance and mono compatibility of a channel pair in one pass.
+      Blocks of any size can be streamed, every window_frames frames a result for that window is reported
+      for plotting, besides the result over everything fed.
+    */
+    typedef struct WAVE_STEREO_METER
+    {
+        int channels;
+        int left;
+        int right;
+        size_t window_frames;
+        size_t frame_position;
+        WAVE_STEREO_SUMS total;
+        WAVE_STEREO_SUMS window;
+    } WAVE_STEREO_METER;
+
+    /*
+      Prepares a meter on the channels left and right of frames with the given channel count.
+      window_frames of 0 disables the per-window results.
+    */
+    extern int Wave_StereoInit(WAVE_STEREO_METER* meter, int channels, int left, int right, size_t window_frames);
+
+    /*
+      Feeds interleaved float frames, results of the windows they complete are written to out_windows.
+      out_window_count receives the number of windows completed, at most max_windows are stored.
+    */
+    extern int Wave_StereoProcess(WAVE_STEREO_METER* meter, const float* frames, size_t frame_count, WAVE_STEREO_RESULT* out_windows, size_t max_windows, size_t* out_window_count);
+
+    /*
+      Feeds every frame of a wave with its sample data in memory, in any sample format.
+    */
+    extern int Wave_StereoProcessWave(WAVE_STEREO_METER* meter, WAVE* wave, WAVE_STEREO_RESULT* out_windows, size_t max_windows, size_t* out_window_count);
+
+    /*
+      Reports the last, incomplete window if any. out_window_count receives 0 or 1.
+    */
+    extern int Wave_StereoFinish(WAVE_STEREO_METER* meter, WAVE_STEREO_RESULT* out_windows, size_t max_windows, size_t* out_window_count);
+
+    /*
+      Returns the result over every frame fed so far.
+    */
+    extern int Wave_StereoGetResult(WAVE_STEREO_METER* meter, WAVE_STEREO_RESULT* out_result);
+
+
+#define WAVE_FAULT_MIN_CLIP_FRAMES 3
+#define WAVE_FAULT_MIN_STUCK_FRAMES 32
+#define WAVE_FAULT_MIN_DROPOUT_FRAMES 16
+
+    typedef enum WAVE_FAULT
+    {
+        WAVE_FAULT_CLIP,    // Consecutive samples at full scale (or beyond it for float formats)
+        WAVE_FAULT_STUCK,   // Consecutive identical samples that are neither silent nor clipped
+        WAVE_FAULT_DROPOUT, // Exact digital silence in the middle of the signal, leading and trailing silence is not a fault
+    } WAVE_FAULT;
+
+    typedef struct WAVE_FAULT_EVENT
+    {
+        WAVE_FAULT fault;
+        int channel;
+        size_t first_frame;
+        size_t frame_count;
+    } WAVE_FAULT_EVENT;
+
+    /*
+      Scans the native samples of a wave with its sample data in memory for clipped runs, stuck samples and dropouts,
+      comparing raw values so no precision is lost to conversions.
+      Only events starting inside [first_frame, first_frame + frame_count) are reported, with their full length,
+      so splitting a file in ranges (e.g. one per thread) and concatenating the results in order gives exactly the
+      events of a single pass. Events are sorted by first frame, then channel.
+      out_event_count receives the number of events found, at most max_events are stored: the ones that start first.
+    */
+    extern int Wave_DetectFaults(WAVE* wave, size_t first_frame, size_t frame_count, WAVE_FAULT_EVENT* out_events, size_t max_events, size_t* out_event_count);
+
+    /*
+      Scans many waves, the events of every wave are stored one after another.
+      out_event_counts receives the number found per wave and at most max_events are stored in total.
+    */
+    extern int Wave_DetectFaultsBatch(WAVE* waves, size_t wave_count, WAVE_FAULT_EVENT* out_events, size_t max_events, size_t* out_event_counts);
+
+
+#define WAVE_ALIGN_MIN_FFT_SIZE 8192
+#define WAVE_ALIGN_BLOCK_SEGMENTS 16
+#define WAVE_ALIGN_MAX_DECIMATION 1024
+
+    typedef struct WAVE_ALIGN_RESULT
+    {
+        double lag;        // Frames b is delayed against a, with sub-sample precision, negative if b is ahead
+        float correlation; // Peak normalized by the energies of both signals, close to 1 for identical content
+    } WAVE_ALIGN_RESULT;
+
+    /*
+      FFT cross-correlation of the mono downmixes of two waves with their sample data in memory, over lags
+      in [-max_lag, max_lag]. The first wave is cut in segments grouped in blocks, blocks can be computed
+      on any thread and are accumulated in block order, so the result never depends on the threading.
+    */
+    typedef struct WAVE_ALIGN
+    {
+        void* free_ptr;
+        size_t free_ptr_size;
+        WAVE_ALLOCATOR allocator; // Used by the block computations, it must be thread safe to compute blocks in parallel
+
+        WAVE* a;
+        WAVE* b;
+        size_t decimation;
+        size_t max_lag;        // In decimated frames
+        size_t fft_size;
+        size_t segment_frames; // Decimated frames of a per segment
+        size_t segment_count;
+        size_t block_count;
+        size_t blocks_accumulated;
+
+        double* correlation; // Lags from -max_lag to max_lag, followed by the energies of a and b
+        float* twiddles;     // Of the fft_size transform, shared by every block
+    } WAVE_ALIGN;
+
+    /*
+      Prepares the alignment of b against a. Both are averaged down by decimation (1 to keep every frame)
+      before correlating, which makes long searches cheaper at the cost of precision.
+    */
+    extern int Wave_AlignInit(WAVE_ALIGN* align, WAVE* a, WAVE* b, size_t max_lag, size_t decimation, WAVE_ALLOCATOR* allocator);
+
+    /*
+      Returns the number of doubles a block result holds.
+    */
+    extern size_t Wave_AlignGetBlockLength(const WAVE_ALIGN* align);
+
+    /*
+      Computes the correlation of one block of segments into out_block, thread safe.
+    */
+    extern int Wave_AlignComputeBlock(const WAVE_ALIGN* align, size_t block, double* out_block);
+
+    /*
+      Adds the result of a block, blocks must be accumulated in order starting from 0.
+    */
+    extern int Wave_AlignAccumulate(WAVE_ALIGN* align, size_t block, const double* block_result);
+
+    /*
+      Finds the correlation peak of the accumulated blocks, refined with a parabola through its neighbours.
+    */
+    extern int Wave_AlignGetResult(const WAVE_ALIGN* align, WAVE_ALIGN_RESULT* out_result);
+
+    extern int Wave_AlignFree(WAVE_ALIGN* align);
+
+    /*
+      Aligns b against a on the calling thread.
+    */
+    extern int Wave_AlignWaves(WAVE* a, WAVE* b, size_t max_lag, size_t decimation, WAVE_ALIGN_RESULT* out_result, WAVE_ALLOCATOR* allocator);
+#endif // SIMPLE_WAVE_NO_DSP
+
+    //
+    //
+    //
+    //
+    //
+    //
+    //
+    //
+
+#ifdef SIMPLE_WAVE_IMPLEMENTATION
+
+    static int Wave_ValidateHeader(RIFF_HEADER* header)
+    {
+        // Check RIFF id
+        if (header->riff_id != RIFF_CODE('R', 'I', 'F', 'F'))
+            return 0;
+
+        // Check WAV id
+        if (header->filetype_id != RIFF_CODE('W', 'A', 'V', 'E'))
+            return 0;
+
+        return 1;
+    }
+
+    // Extensible formats store the actual tag in their sub format
+    static uint16_t Wave_GetFormatTag(WAVE* wave)
+    {
+        if (wave->format->format_tag != WAVE_FORMAT_TAG_EXTENSIBLE)
+            return wave->format->format_tag;
+        if ((!wave->format_chunk) || (wave->format_chunk->size < sizeof(WAVE_FORMAT_EXTENSIBLE)))
+            return 0;
+
+        WAVE_FORMAT_EXTENSIBLE* extensible = (WAVE_FORMAT_EXTENSIBLE*)wave->format;
+        return (uint16_t)(extensible->sub_format[0] | (extensible->sub_format[1] << 8));
+    }
+
+    static int Wave_ValidateFormat(WAVE* out_wave)
+    {
+        if (!out_wave->format)
+            return 0;
+        if ((out_wave->format_chunk) && (out_wave->format_chunk->size < sizeof(WAVE_FORMAT)))
+            return 0;
+
+        uint16_t format_tag = Wave_GetFormatTag(out_wave);
+        if ((format_tag != WAVE_FORMAT_TAG_PCM) && (format_tag != WAVE_FORMAT_TAG_IEEE_FLOAT))
+            return 0;
+
+        if ((format_tag == WAVE_FORMAT_TAG_PCM) && (out_wave->format->bits_per_sample != 8) && (out_wave->format->bits_per_sample != 16) && (out_wave->format->bits_per_sample != 32))
+            return 0;
+
+        if ((format_tag == WAVE_FORMAT_TAG_IEEE_FLOAT) && (out_wave->format->bits_per_sample != 32) && (out_wave->format->bits_per_sample != 64))
+            return 0;
+
+        // Frames are addressed through the block align, it must match the samples it holds
+        if ((!out_wave->format->channels) || (out_wave->format->block_align != out_wave->format->channels * (out_wave->format->bits_per_sample / 8)))
+            return 0;
+
+        return 1;
+    }
+
+    static void* Wave_DefaultAlloc(void* data, size_t size)
+    {
+        return malloc(size);
+    }
+
+    static void Wave_DefaultFree(void* data, void* ptr, size_t size)
+    {
+        free(ptr);
+    }
+
+    static WAVE_ALLOCATOR* Wave_GetDefaultAllocator(void)
+    {
+        // Initialized once and never written, so threads can share it
+        static WAVE_ALLOCATOR allocator = { Wave_DefaultAlloc, Wave_DefaultFree, NULL };
+        return &allocator;
+    }
+
+    int Wave_ParseBuffer(void* buff, size_t size, WAVE* out_wave)
+    {
+        // Validate params
+        if ((!buff) || (size < sizeof(RIFF_HEADER)) || (!out_wave))
+            return 0;
+
+        memset(out_wave, 0, sizeof(WAVE));
+
+        out_wave->header = (RIFF_HEADER*)buff;
+        if (!Wave_ValidateHeader(out_wave->header))
+            return 0;
+
+        // Parse RIFF chunks, never past the buffer even if the header claims more
+        char* at = (char*)(out_wave->header + 1);
+        char* max = (char*)buff + size;
+        if ((out_wave->header->size >= 4) && (out_wave->header->size - 4 < (size_t)(max - at)))
+            max = at + out_wave->header->size - 4;
+        while ((size_t)(max - at) >= sizeof(RIFF_CHUNK))
+        {
+            RIFF_CHUNK* chunk = (RIFF_CHUNK*)at;
+            size_t available = (size_t)(max - at) - sizeof(RIFF_CHUNK);
+
+            switch (chunk->id)
+            {
+                case WAVE_CHUNK_DATA:
+                    out_wave->data_chunk = chunk;
+                    out_wave->data_chunk_offset = (size_t)((char*)chunk - (char*)buff);
+                    break;
+                case WAVE_CHUNK_FORMAT:
+                    if (chunk->size > available)
+                        return 0;
+                    out_wave->format_chunk = chunk;
+                    out_wave->format_chunk_offset = (size_t)((char*)chunk - (char*)buff);
+                    break;
+                case WAVE_CHUNK_CHECKSUM:
+                    if (chunk->size > available)
+                        break;
+                    out_wave->checksum_chunk = chunk;
+                    out_wave->checksum_chunk_offset = (size_t)((char*)chunk - (char*)buff);
+                    break;
+            }
+
+            // If the size is odd round it, a chunk running past the end ends the walk
+            size_t advance = (size_t)chunk->size + (chunk->size & 1);
+            if (advance >= available)
+                break;
+            at += sizeof(RIFF_CHUNK) + advance;
+        }
+
+        // Get format
+        if (!out_wave->format_chunk)
+            return 0;
+        out_wave->format = (WAVE_FORMAT*)(out_wave->format_chunk + 1);
+
+        // Get sample data
+        if (out_wave->data_chunk)
+        {
+            out_wave->sample_data = (void*)(out_wave->data_chunk + 1);
+            out_wave->sample_data_offset = (size_t)((char*)out_wave->sample_data - (char*)buff);
+
+            // Truncated files keep the samples that are actually there
+            out_wave->sample_data_size = out_wave->data_chunk->size;
+            if (out_wave->sample_data_size > size - out_wave->sample_data_offset)
+                out_wave->sample_data_size = size - out_wave->sample_data_offset;
+        }
+
+        return Wave_ValidateFormat(out_wave);
+    }
+
+#ifndef SIMPLE_WAVE_NO_STDIO
+    // Seeks to an absolute position, offsets past 2 GB need _fseeki64 or fseeko
+    static int Wave_Seek(FILE* file, uint64_t offset)
+    {
+#if defined(_WIN32)
+        if (offset > 0x7FFFFFFFFFFFFFFFull)
+            return 0;
+        return _fseeki64(file, (long long)offset, SEEK_SET) == 0;
+#elif defined(WAVE_HAS_FSEEKO)
+        if (((off_t)offset < 0) || ((uint64_t)(off_t)offset != offset))
+            return 0;
+        return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#else
+        if (((long)offset < 0) || ((uint64_t)(long)offset != offset))
+            return 0;
+        return fseek(file, (long)offset, SEEK_SET) == 0;
+#endif
+    }
+
+    // Position of the stream, 64 bit like Wave_Seek
+    static int Wave_Tell(FILE* file, uint64_t* out_offset)
+    {
+#if defined(_WIN32)
+        long long offset = _ftelli64(file);
+#elif defined(WAVE_HAS_FSEEKO)
+        off_t offset = ftello(file);
+#else
+        long offset = ftell(file);
+#endif
+        if (offset < 0)
+            return 0;
+        *out_offset = (uint64_t)offset;
+        return 1;
+    }
+
+    int Wave_LoadStream(FILE* file, long size, WAVE* out_wave, WAVE_ALLOCATOR* allocator)
+    {
+        if (!out_wave)
+            return 0;
+        if (!file)
+            return 0;
+
+        if (size <= 0)
+            return 0;
+
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        void* buff = allocator->allocate(allocator->data, size);
+        if (!buff)
+            return 0;
+
+        // The parse clears the wave, the allocation is attached afterwards so it is never lost
+        if ((fread(buff, 1, size, file) != (size_t)size) || (!Wave_ParseBuffer(buff, size, out_wave)))
+        {
+            allocator->free(allocator->data, buff, size);
+            memset(out_wave, 0, sizeof(WAVE));
+            return 0;
+        }
+
+        out_wave->free_ptr = buff;
+        out_wave->free_ptr_size = size;
+        return 1;
+    }
+
+    int Wave_LoadPath(const char* path, WAVE* out_wave, WAVE_ALLOCATOR* allocator)
+    {
+        if (!out_wave)
+            return 0;
+        if (!path)
+            return 0;
+
+        FILE* file = fopen(path, "rb");
+        if (!file)
+            return 0;
+
+        fseek(file, 0, SEEK_END);
+        long fileSize = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        int result = Wave_LoadStream(file, fileSize, out_wave, allocator);
+        fclose(file);
+        return result;
+    }
+
+    int Wave_LoadStreamOnlyInfo(FILE* file, long size, WAVE* out_wave, WAVE_ALLOCATOR* allocator)
+    {
+        if (!file)
+            return 0;
+        if (!out_wave)
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        memset(out_wave, 0, sizeof(WAVE));
+        out_wave->info_only = 1;
+
+        long header_offset = ftell(file);
+        if (header_offset < 0)
+            return 0;
+        out_wave->header_offset = (size_t)header_offset;
+
+        // Allocate space
+        out_wave->free_ptr_size = sizeof(RIFF_HEADER) + sizeof(RIFF_CHUNK) * 3 + sizeof(WAVE_FORMAT_EXTENSIBLE) + sizeof(WAVE_CHECKSUM);
+        out_wave->free_ptr = allocator->allocate(allocator->data, out_wave->free_ptr_size);
+        if (!out_wave->free_ptr)
+        {
+            out_wave->free_ptr_size = 0;
+            return 0;
+        }
+
+        // Allocate space for the header
+        out_wave->header = (RIFF_HEADER*)out_wave->free_ptr;
+
+        // Validate the header
+        if ((fread(out_wave->header, sizeof(RIFF_HEADER), 1, file) != 1) || (!Wave_ValidateHeader(out_wave->header)))
+        {
+            Wave_Free(out_wave, allocator);
+            return 0;
+        }
+
+        // Initialize variables for chunk processing
+        RIFF_CHUNK chunk;
+
+        // Read chunks until the 'fmt ' chunk is found
+        while ((ftell(file) + (long)sizeof(RIFF_CHUNK)) <= size)
+        {
+            // Read the chunk header
+            if (fread(&chunk, sizeof(RIFF_CHUNK), 1, file) != 1)
+                break;
+
+            if (chunk.id == WAVE_CHUNK_DATA)
+            {
+                out_wave->data_chunk = (RIFF_CHUNK*)(out_wave->header+1);
+                memcpy(out_wave->data_chunk, &chunk, sizeof(RIFF_CHUNK));
+                out_wave->data_chunk_offset = ftell(file) - sizeof(RIFF_CHUNK);
+                out_wave->sample_data_offset = ftell(file);
+
+                // Truncated files keep the samples that are actually there
+                out_wave->sample_data_size = chunk.size;
+                if (out_wave->sample_data_size > (size_t)(size - (long)out_wave->sample_data_offset))
+                    out_wave->sample_data_size = (size_t)(size - (long)out_wave->sample_data_offset);
+
+                fseek(file, (long)out_wave->sample_data_size, SEEK_CUR);
+            }
+            else if (chunk.id == WAVE_CHUNK_FORMAT)
+            {
+                out_wave->format_chunk = (RIFF_CHUNK*)((char*)(out_wave->header+1) + sizeof(RIFF_CHUNK));
+                memcpy(out_wave->format_chunk, &chunk, sizeof(RIFF_CHUNK));
+                out_wave->format_chunk_offset = ftell(file) - sizeof(RIFF_CHUNK);
+
+                out_wave->format = (WAVE_FORMAT*)((char*)(out_wave->header + 1) + sizeof(RIFF_CHUNK) * 2);
+
+                // Only the known part of the format is kept, the rest is skipped
+                size_t format_size = (chunk.size < sizeof(WAVE_FORMAT_EXTENSIBLE)) ? chunk.size : sizeof(WAVE_FORMAT_EXTENSIBLE);
+                memset(out_wave->format, 0, sizeof(WAVE_FORMAT_EXTENSIBLE));
+                fread(out_wave->format, 1, format_size, file);
+                fseek(file, (long)(chunk.size - format_size), SEEK_CUR);
+            }
+            else if ((chunk.id == WAVE_CHUNK_CHECKSUM) && (chunk.size >= sizeof(WAVE_CHECKSUM)))
+            {
+                // Stored after the format, the payload follows the chunk header like in a parsed buffer
+                out_wave->checksum_chunk = (RIFF_CHUNK*)((char*)(out_wave->header + 1) + sizeof(RIFF_CHUNK) * 2 + sizeof(WAVE_FORMAT_EXTENSIBLE));
+                memcpy(out_wave->checksum_chunk, &chunk, sizeof(RIFF_CHUNK));
+                out_wave->checksum_chunk_offset = ftell(file) - sizeof(RIFF_CHUNK);
+
+                fread(out_wave->checksum_chunk + 1, 1, sizeof(WAVE_CHECKSUM), file);
+                fseek(file, (long)(chunk.size - sizeof(WAVE_CHECKSUM)), SEEK_CUR);
+            }
+            else
+            {
+                // Skip over this chunk, one running past the end ends the walk
+                if ((long)chunk.size > size - ftell(file))
+                    break;
+                fseek(file, (long)chunk.size, SEEK_CUR);
+            }
+
+            if (chunk.size % 2 != 0)
+                fseek(file, 1, SEEK_CUR);
+        }
+
+        // Validate the format chunk
+        if (!Wave_ValidateFormat(out_wave))
+        {
+            Wave_Free(out_wave, allocator);
+            return 0;
+        }
+
+        return 1;
+    }
+
+    int Wave_LoadPathOnlyInfo(const char* path, WAVE* out_wave, WAVE_ALLOCATOR* allocator)
+    {
+        if (!path)
+            return 0;
+        if (!out_wave)
+            return 0;
+
+        FILE* file = fopen(path, "rb");
+        if (!file)
+            return 0;
+
+        fseek(file, 0, SEEK_END);
+        long fileSize = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        int result = Wave_LoadStreamOnlyInfo(file, fileSize, out_wave, allocator);
+        fclose(file);
+        return result;
+    }
+#endif // SIMPLE_WAVE_NO_STDIO
+
+    WAVE_SAMPLE_FORMAT Wave_GetSampleFormat(WAVE* wave)
+    {
+        if ((!wave) || (!wave->format))
+            return WAVE_SAMPLE_FORMAT_UNKNOWN;
+
+        uint16_t format_tag = Wave_GetFormatTag(wave);
+        if (format_tag == WAVE_FORMAT_TAG_PCM)
+        {
+            if (wave->format->bits_per_sample == 8)
+                return WAVE_SAMPLE_FORMAT_U8;
+
+            if (wave->format->bits_per_sample == 16)
+                return WAVE_SAMPLE_FORMAT_S16;
+
+            if (wave->format->bits_per_sample == 32)
+                return WAVE_SAMPLE_FORMAT_S32;
+        }
+
+        if (format_tag == WAVE_FORMAT_TAG_IEEE_FLOAT)
+        {
+            if (wave->format->bits_per_sample == 32)
+                return WAVE_SAMPLE_FORMAT_F32;
+
+            if (wave->format->bits_per_sample == 64)
+                return WAVE_SAMPLE_FORMAT_F64;
+        }
+
+        return WAVE_SAMPLE_FORMAT_UNKNOWN;
+    }
+
+    float Wave_GetLengthInSeconds(WAVE* wave)
+    {
+        if ((!wave) || (!wave->format))
+            return 0;
+
+        if (!wave->format->samples_per_sec)
+            return 0;
+
+        return (float)Wave_GetFrameCount(wave) / (float)wave->format->samples_per_sec;
+    }
+
+    int Wave_GetSampleFrequency(WAVE* wave)
+    {
+        if ((!wave) || (!wave->format))
+            return 0;
+
+        return wave->format->samples_per_sec;
+    }
+
+    int Wave_GetChannelCount(WAVE* wave)
+    {
+        if ((!wave) || (!wave->format))
+            return 0;
+
+        return wave->format->channels;
+    }
+
+    int Wave_GetSampleData(WAVE* wave, void** out_samples, size_t* out_samples_size)
+    {
+        if(!wave)
+            return 0;
+        if (out_samples)
+            *out_samples = wave->sample_data;
+        if (out_samples_size)
+            *out_samples_size = wave->sample_data_size;
+        return 1;
+    }
+
+    int Wave_GetSampleCount(WAVE* wave)
+    {
+        if ((!wave) || (!wave->format))
+            return 0;
+
+        if (wave->format->bits_per_sample < 8)
+            return 0;
+
+        return (int)(wave->sample_data_size / (wave->format->bits_per_sample / 8));
+    }
+
+    int Wave_Free(WAVE* wave, WAVE_ALLOCATOR* allocator)
+    {
+        if(!wave)
+            return 0;
+        if(!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        if (wave->free_ptr)
+        {
+            allocator->free(allocator->data, wave->free_ptr, wave->free_ptr_size);
+            wave->free_ptr      = NULL;
+            wave->free_ptr_size = 0;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    size_t Wave_GetSampleDataOffset(WAVE* wave)
+    {
+        if(!wave)
+            return 0;
+
+        return wave->sample_data_offset;
+    }
+
+    size_t Wave_GetFrameCount(WAVE* wave)
+    {
+        if ((!wave) || (!wave->format) || (!wave->format->block_align))
+            return 0;
+
+        return wave->sample_data_size / wave->format->block_align;
+    }
+
+    size_t Wave_GetSampleFormatSize(WAVE_SAMPLE_FORMAT sample_format)
+    {
+        switch (sample_format)
+        {
+            case WAVE_SAMPLE_FORMAT_U8:  return 1;
+            case WAVE_SAMPLE_FORMAT_S16: return 2;
+            case WAVE_SAMPLE_FORMAT_S32: return 4;
+            case WAVE_SAMPLE_FORMAT_F32: return 4;
+            case WAVE_SAMPLE_FORMAT_F64: return 8;
+            default:                     return 0;
+        }
+    }
+
+    void Wave_ConvertToFloat(const void* samples, WAVE_SAMPLE_FORMAT sample_format, size_t sample_count, float* out_samples)
+    {
+        const unsigned char* src = (const unsigned char*)samples;
+        size_t i;
+
+        // Sample data is not guaranteed to be aligned, memcpy keeps the loads legal and still vectorizes
+        switch (sample_format)
+        {
+            case WAVE_SAMPLE_FORMAT_U8:
+                for (i = 0; i < sample_count; ++i)
+                    out_samples[i] = ((float)src[i] - 128.0f) * (1.0f / 128.0f);
+                break;
+            case WAVE_SAMPLE_FORMAT_S16:
+                for (i = 0; i < sample_count; ++i)
+                {
+                    int16_t v;
+                    memcpy(&v, src + i * 2, 2);
+                    out_samples[i] = (float)v * (1.0f / 32768.0f);
+                }
+                break;
+            case WAVE_SAMPLE_FORMAT_S32:
+                for (i = 0; i < sample_count; ++i)
+                {
+                    int32_t v;
+                    memcpy(&v, src + i * 4, 4);
+                    out_samples[i] = (float)v * (1.0f / 2147483648.0f);
+                }
+                break;
+            case WAVE_SAMPLE_FORMAT_F32:
+                memcpy(out_samples, src, sample_count * 4);
+                break;
+            case WAVE_SAMPLE_FORMAT_F64:
+                for (i = 0; i < sample_count; ++i)
+                {
+                    double v;
+                    memcpy(&v, src + i * 8, 8);
+                    out_samples[i] = (float)v;
+                }
+                break;
+            default:
+                memset(out_samples, 0, sample_count * sizeof(float));
+                break;
+        }
+    }
+
+    // Clamps to [min, max] and rounds down without libm, NaN maps to min
+    static int64_t Wave_FloorClamped(double value, double min, double max)
+    {
+        value = (value >= min) ? ((value <= max) ? value : max) : min;
+        int64_t truncated = (int64_t)value;
+        return truncated - ((double)truncated > value);
+    }
+
+    void Wave_ConvertFromFloat(const float* samples, size_t sample_count, WAVE_SAMPLE_FORMAT sample_format, void* out_samples)
+    {
+        unsigned char* dst = (unsigned char*)out_samples;
+        size_t i;
+
+        switch (sample_format)
+        {
+            case WAVE_SAMPLE_FORMAT_U8:
+                for (i = 0; i < sample_count; ++i)
+                    dst[i] = (unsigned char)Wave_FloorClamped(samples[i] * 128.0f + 128.5f, 0.0, 255.0);
+                break;
+            case WAVE_SAMPLE_FORMAT_S16:
+                for (i = 0; i < sample_count; ++i)
+                {
+                    int16_t s = (int16_t)Wave_FloorClamped(samples[i] * 32768.0f + 0.5f, -32768.0, 32767.0);
+                    memcpy(dst + i * 2, &s, 2);
+                }
+                break;
+            case WAVE_SAMPLE_FORMAT_S32:
+                for (i = 0; i < sample_count; ++i)
+                {
+                    int32_t s = (int32_t)Wave_FloorClamped((double)samples[i] * 2147483648.0 + 0.5, -2147483648.0, 2147483647.0);
+                    memcpy(dst + i * 4, &s, 4);
+                }
+                break;
+            case WAVE_SAMPLE_FORMAT_F32:
+                memcpy(dst, samples, sample_count * 4);
+                break;
+            case WAVE_SAMPLE_FORMAT_F64:
+                for (i = 0; i < sample_count; ++i)
+                {
+                    double v = samples[i];
+                    memcpy(dst + i * 8, &v, 8);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    size_t Wave_ReadFramesFloat(WAVE* wave, size_t first_frame, size_t frame_count, float* out_frames)
+    {
+        if ((!wave) || (!wave->sample_data) || (!out_frames))
+            return 0;
+
+        size_t total = Wave_GetFrameCount(wave);
+        if (first_frame >= total)
+            return 0;
+        if (frame_count > total - first_frame)
+            frame_count = total - first_frame;
+
+        const char* src = (const char*)wave->sample_data + first_frame * wave->format->block_align;
+        Wave_ConvertToFloat(src, Wave_GetSampleFormat(wave), frame_count * wave->format->channels, out_frames);
+        return frame_count;
+    }
+
+#ifndef SIMPLE_WAVE_NO_WRITER
+    static int Wave_WriteU32At(FILE* file, uint64_t offset, uint32_t value)
+    {
+        if (!Wave_Seek(file, offset))
+            return 0;
+        return fwrite(&value, sizeof(value), 1, file) == 1;
+    }
+
+    static int Wave_WriterBeginFormat(WAVE_WRITER* writer, FILE* file, WAVE_SAMPLE_FORMAT sample_format, int channels, int samples_per_sec, int extensible, uint32_t channel_mask)
+    {
+        if ((!writer) || (!file))
+            return 0;
+        if ((channels <= 0) || (channels > 0xFFFF) || (samples_per_sec <= 0))
+            return 0;
+
+        size_t sample_size = Wave_GetSampleFormatSize(sample_format);
+        if ((!sample_size) || (sample_size * (size_t)channels > 0xFFFF))
+            return 0;
+
+        memset(writer, 0, sizeof(WAVE_WRITER));
+        writer->file = file;
+        writer->sample_format = sample_format;
+
+        int is_float = (sample_format == WAVE_SAMPLE_FORMAT_F32) || (sample_format == WAVE_SAMPLE_FORMAT_F64);
+        writer->format.format_tag = (uint16_t)(is_float ? WAVE_FORMAT_TAG_IEEE_FLOAT : WAVE_FORMAT_TAG_PCM);
+        writer->format.channels = (uint16_t)channels;
+        writer->format.samples_per_sec = (uint32_t)samples_per_sec;
+        writer->format.block_align = (uint16_t)(sample_size * channels);
+        writer->format.avg_bytes_per_sec = writer->format.samples_per_sec * writer->format.block_align;
+        writer->format.bits_per_sample = (uint16_t)(sample_size * 8);
+
+        if (!Wave_Tell(file, &writer->header_offset))
+            return 0;
+
+        // The extensible layout wraps the same format, with the real tag moved to the sub format GUID
+        WAVE_FORMAT_EXTENSIBLE format;
+        static const uint8_t sub_format_suffix[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+        memset(&format, 0, sizeof(format));
+        format.format = writer->format;
+        if (extensible)
+        {
+            format.format.format_tag = WAVE_FORMAT_TAG_EXTENSIBLE;
+            format.extension_size = (uint16_t)(sizeof(WAVE_FORMAT_EXTENSIBLE) - sizeof(WAVE_FORMAT) - sizeof(uint16_t));
+            format.valid_bits_per_sample = writer->format.bits_per_sample;
+            format.channel_mask = channel_mask;
+            format.sub_format[0] = (uint8_t)(writer->format.format_tag & 0xFF);
+            format.sub_format[1] = (uint8_t)(writer->format.format_tag >> 8);
+            memcpy(format.sub_format + 2, sub_format_suffix, sizeof(sub_format_suffix));
+        }
+
+        // Sizes are left at 0 until Wave_WriterEnd
+        RIFF_HEADER header = { RIFF_CODE('R', 'I', 'F', 'F'), 0, RIFF_CODE('W', 'A', 'V', 'E') };
+        RIFF_CHUNK format_chunk = { WAVE_CHUNK_FORMAT, (uint32_t)(extensible ? sizeof(WAVE_FORMAT_EXTENSIBLE) : sizeof(WAVE_FORMAT)) };
+        RIFF_CHUNK data_chunk = { WAVE_CHUNK_DATA, 0 };
+
+        if (fwrite(&header, sizeof(header), 1, file) != 1)
+            return 0;
+        if (fwrite(&format_chunk, sizeof(format_chunk), 1, file) != 1)
+            return 0;
+        if (fwrite(&format, format_chunk.size, 1, file) != 1)
+            return 0;
+
+        if (!Wave_Tell(file, &writer->data_chunk_offset))
+            return 0;
+        if (fwrite(&data_chunk, sizeof(data_chunk), 1, file) != 1)
+            return 0;
+
+        return 1;
+    }
+#endif // SIMPLE_WAVE_NO_WRITER
+
+#define WAVE_XXH_PRIME1 0x9E3779B185EBCA87ull
+#define WAVE_XXH_PRIME2 0xC2B2AE3D27D4EB4Full
+#define WAVE_XXH_PRIME3 0x165667B19E3779F9ull
+#define WAVE_XXH_PRIME4 0x85EBCA77C2B2AE63ull
+#define WAVE_XXH_PRIME5 0x27D4EB2F165667C5ull
+
+    static uint64_t Wave_Rotl64(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static uint64_t Wave_Read64(const unsigned char* at)
+    {
+        uint64_t value;
+        memcpy(&value, at, sizeof(value));
+        return value;
+    }
+
+    static uint64_t Wave_HashRound(uint64_t lane, uint64_t input)
+    {
+        lane += input * WAVE_XXH_PRIME2;
+        lane = Wave_Rotl64(lane, 31);
+        return lane * WAVE_XXH_PRIME1;
+    }
+
+    static uint64_t Wave_HashMerge(uint64_t hash, uint64_t lane)
+    {
+        hash ^= Wave_HashRound(0, lane);
+        return hash * WAVE_XXH_PRIME1 + WAVE_XXH_PRIME4;
+    }
+
+    void Wave_HashBegin(WAVE_HASH* hash)
+    {
+        memset(hash, 0, sizeof(WAVE_HASH));
+        hash->lanes[0] = WAVE_XXH_PRIME1 + WAVE_XXH_PRIME2;
+        hash->lanes[1] = WAVE_XXH_PRIME2;
+        hash->lanes[2] = 0;
+        hash->lanes[3] = 0 - WAVE_XXH_PRIME1;
+    }
+
+    void Wave_HashUpdate(WAVE_HASH* hash, const void* data, size_t size)
+    {
+        const unsigned char* at = (const unsigned char*)data;
+        hash->total_size += size;
+
+        // Complete a stripe left over by the previous update
+        if (hash->buffer_size)
+        {
+            size_t fill = 32 - hash->buffer_size;
+            if (fill > size)
+                fill = size;
+            memcpy(hash->buffer + hash->buffer_size, at, fill);
+            hash->buffer_size += fill;
+            at += fill;
+            size -= fill;
+
+            if (hash->buffer_size < 32)
+                return;
+
+            int i;
+            for (i = 0; i < 4; ++i)
+                hash->lanes[i] = Wave_HashRound(hash->lanes[i], Wave_Read64(hash->buffer + i * 8));
+            hash->buffer_size = 0;
+        }
+
+        // Four independent lanes per 32 byte stripe
+        uint64_t v0 = hash->lanes[0], v1 = hash->lanes[1], v2 = hash->lanes[2], v3 = hash->lanes[3];
+        while (size >= 32)
+        {
+            v0 = Wave_HashRound(v0, Wave_Read64(at + 0));
+            v1 = Wave_HashRound(v1, Wave_Read64(at + 8));
+            v2 = Wave_HashRound(v2, Wave_Read64(at + 16));
+            v3 = Wave_HashRound(v3, Wave_Read64(at + 24));
+            at += 32;
+            size -= 32;
+        }
+        hash->lanes[0] = v0; hash->lanes[1] = v1; hash->lanes[2] = v2; hash->lanes[3] = v3;
+
+        memcpy(hash->buffer, at, size);
+        hash->buffer_size = size;
+    }
+
+    uint64_t Wave_HashEnd(const WAVE_HASH* hash)
+    {
+        uint64_t result;
+        if (hash->total_size >= 32)
+        {
+            result = Wave_Rotl64(hash->lanes[0], 1) + Wave_Rotl64(hash->lanes[1], 7) + Wave_Rotl64(hash->lanes[2], 12) + Wave_Rotl64(hash->lanes[3], 18);
+            result = Wave_HashMerge(result, hash->lanes[0]);
+            result = Wave_HashMerge(result, hash->lanes[1]);
+            result = Wave_HashMerge(result, hash->lanes[2]);
+            result = Wave_HashMerge(result, hash->lanes[3]);
+        }
+        else
+            result = WAVE_XXH_PRIME5;
+
+        result += hash->total_size;
+
+        const unsigned char* at = hash->buffer;
+        size_t size = hash->buffer_size;
+        for (; size >= 8; at += 8, size -= 8)
+        {
+            result ^= Wave_HashRound(0, Wave_Read64(at));
+            result = Wave_Rotl64(result, 27) * WAVE_XXH_PRIME1 + WAVE_XXH_PRIME4;
+        }
+        if (size >= 4)
+        {
+            uint32_t value;
+            memcpy(&value, at, sizeof(value));
+            result ^= (uint64_t)value * WAVE_XXH_PRIME1;
+            result = Wave_Rotl64(result, 23) * WAVE_XXH_PRIME2 + WAVE_XXH_PRIME3;
+            at += 4;
+            size -= 4;
+        }
+        for (; size; ++at, --size)
+        {
+            result ^= (uint64_t)(*at) * WAVE_XXH_PRIME5;
+            result = Wave_Rotl64(result, 11) * WAVE_XXH_PRIME1;
+        }
+
+        result ^= result >> 33;
+        result *= WAVE_XXH_PRIME2;
+        result ^= result >> 29;
+        result *= WAVE_XXH_PRIME3;
+        result ^= result >> 32;
+        return result;
+    }
+
+#ifndef SIMPLE_WAVE_NO_WRITER
+    int Wave_WriterBegin(WAVE_WRITER* writer, FILE* file, WAVE_SAMPLE_FORMAT sample_format, int channels, int samples_per_sec)
+    {
+        return Wave_WriterBeginFormat(writer, file, sample_format, channels, samples_per_sec, 0, 0);
+    }
+
+    int Wave_WriterBeginExtensible(WAVE_WRITER* writer, FILE* file, WAVE_SAMPLE_FORMAT sample_format, int channels, int samples_per_sec, uint32_t channel_mask)
+    {
+        return Wave_WriterBeginFormat(writer, file, sample_format, channels, samples_per_sec, 1, channel_mask);
+    }
+
+    uint32_t Wave_GetDefaultChannelMask(int channels)
+    {
+        // Speaker positions are assigned in the order of their bits, up to the 18 defined ones
+        if ((channels <= 0) || (channels > 18))
+            return 0;
+
+        return (uint32_t)((1u << channels) - 1);
+    }
+
+    // Appends bytes after the frames written so far, the frame count is left to the caller
+    static int Wave_WriterAppend(WAVE_WRITER* writer, const void* bytes, size_t size)
+    {
+        if (writer->reposition)
+        {
+            uint64_t end = writer->data_chunk_offset + sizeof(RIFF_CHUNK) + (uint64_t)writer->frames_written * writer->format.block_align;
+            if (!Wave_Seek(writer->file, end))
+                return 0;
+            writer->reposition = 0;
+        }
+
+        if (fwrite(bytes, 1, size, writer->file) != size)
+            return 0;
+
+        if (writer->checksum)
+            Wave_HashUpdate(&writer->hash, bytes, size);
+        return 1;
+    }
+
+    static int Wave_WriterEncodeSamples(const WAVE_WRITER* writer, const float* samples, size_t first_sample, size_t sample_count, void* out_bytes);
+
+    int Wave_WriterWrite(WAVE_WRITER* writer, const void* frames, size_t frame_count)
+    {
+        if ((!writer) || (!writer->file))
+            return 0;
+        if (!frame_count)
+            return 1;
+        if (!frames)
+            return 0;
+
+        if (!Wave_WriterAppend(writer, frames, frame_count * writer->format.block_align))
+            return 0;
+
+        writer->frames_written += frame_count;
+        return 1;
+    }
+
+    int Wave_WriterWriteFloat(WAVE_WRITER* writer, const float* frames, size_t frame_count)
+    {
+        if ((!writer) || (!writer->file))
+            return 0;
+        if (!frame_count)
+            return 1;
+        if (!frames)
+            return 0;
+
+        // Convert through a small stack buffer in whole samples, so frames of any width fit without allocating
+        double temp[512];
+        size_t sample_size = Wave_GetSampleFormatSize(writer->sample_format);
+        size_t chunk_samples = sizeof(temp) / sample_size;
+        size_t first_sample = writer->frames_written * writer->format.channels;
+        size_t total = frame_count * writer->format.channels;
+        size_t at = 0;
+
+        while (at < total)
+        {
+            size_t count = ((total - at) < chunk_samples) ? total - at : chunk_samples;
+            if (!Wave_WriterEncodeSamples(writer, frames + at, first_sample + at, count, temp))
+                return 0;
+            if (!Wave_WriterAppend(writer, temp, count * sample_size))
+                return 0;
+            at += count;
+        }
+
+        writer->frames_written += frame_count;
+        return 1;
+    }
+
+    int Wave_WriterSetDither(WAVE_WRITER* writer, int enabled)
+    {
+        if (!writer)
+            return 0;
+
+        writer->dither = enabled;
+        return 1;
+    }
+
+    // Counter based hash, the same sample index always gets the same noise
+    static uint64_t Wave_HashIndex(uint64_t index)
+    {
+        index += 0x9E3779B97F4A7C15ull;
+        index = (index ^ (index >> 30)) * 0xBF58476D1CE4E5B9ull;
+        index = (index ^ (index >> 27)) * 0x94D049BB133111EBull;
+        return index ^ (index >> 31);
+    }
+
+    int Wave_WriterEnableChecksum(WAVE_WRITER* writer)
+    {
+        if ((!writer) || (!writer->file) || (writer->frames_written))
+            return 0;
+
+        writer->checksum = 1;
+        Wave_HashBegin(&writer->hash);
+        return 1;
+    }
+
+    // Sample based core of Wave_WriterEncode, the dither noise is indexed by sample
+    static int Wave_WriterEncodeSamples(const WAVE_WRITER* writer, const float* frames, size_t first_sample, size_t sample_count, void* out_bytes)
+    {
+        int is_integer = (writer->sample_format == WAVE_SAMPLE_FORMAT_U8) || (writer->sample_format == WAVE_SAMPLE_FORMAT_S16) || (writer->sample_format == WAVE_SAMPLE_FORMAT_S32);
+        if ((!writer->dither) || (!is_integer))
+        {
+            Wave_ConvertFromFloat(frames, sample_count, writer->sample_format, out_bytes);
+            return 1;
+        }
+
+        // Triangular noise of +-1 LSB from two uniform values, S32 has no audible quantization to hide
+        float lsb = (writer->sample_format == WAVE_SAMPLE_FORMAT_U8) ? (1.0f / 128.0f) : ((writer->sample_format == WAVE_SAMPLE_FORMAT_S16) ? (1.0f / 32768.0f) : 0.0f);
+        float temp[1024];
+        unsigned char* dst = (unsigned char*)out_bytes;
+        size_t sample_size = Wave_GetSampleFormatSize(writer->sample_format);
+        size_t total = sample_count;
+        size_t index = first_sample;
+        size_t at = 0;
+
+        while (at < total)
+        {
+            size_t count = ((total - at) < 1024) ? total - at : 1024;
+            size_t i;
+            for (i = 0; i < count; ++i)
+            {
+                uint64_t r = Wave_HashIndex((uint64_t)(index + at + i));
+                float a = (float)(r & 0xFFFFFF) * (1.0f / 16777216.0f);
+                float b = (float)((r >> 24) & 0xFFFFFF) * (1.0f / 16777216.0f);
+                temp[i] = frames[at + i] + (a - b) * lsb;
+            }
+
+            Wave_ConvertFromFloat(temp, count, writer->sample_format, dst + at * sample_size);
+            at += count;
+        }
+
+        return 1;
+    }
+
+    int Wave_WriterEncode(const WAVE_WRITER* writer, const float* frames, size_t first_frame, size_t frame_count, void* out_bytes)
+    {
+        if ((!writer) || (!writer->format.block_align))
+            return 0;
+        if ((frame_count) && ((!frames) || (!out_bytes)))
+            return 0;
+
+        size_t channels = writer->format.channels;
+        return Wave_WriterEncodeSamples(writer, frames, first_frame * channels, frame_count * channels, out_bytes);
+    }
+
+    int Wave_WriterWriteAt(WAVE_WRITER* writer, size_t first_frame, const void* bytes, size_t frame_count)
+    {
+        if ((!writer) || (!writer->file))
+            return 0;
+        if (!frame_count)
+            return 1;
+        if (!bytes)
+            return 0;
+
+        // The hash is streamed, it cannot follow blocks out of order
+        if ((writer->checksum) && (first_frame != writer->frames_written))
+            return 0;
+
+        size_t size = frame_count * writer->format.block_align;
+        uint64_t offset = writer->data_chunk_offset + sizeof(RIFF_CHUNK) + (uint64_t)first_frame * writer->format.block_align;
+
+#ifdef WAVE_HAS_PWRITE
+        // The header may still sit in the stream buffer
+        if (fflush(writer->file) != 0)
+            return 0;
+
+        int fd = fileno(writer->file);
+        const char* at = (const char*)bytes;
+        while (size)
+        {
+            ssize_t written = pwrite(fd, at, size, (off_t)offset);
+            if (written <= 0)
+                return 0;
+            at += written;
+            offset += (uint64_t)written;
+            size -= (size_t)written;
+        }
+#else
+        if (!Wave_Seek(writer->file, offset))
+            return 0;
+        if (fwrite(bytes, 1, size, writer->file) != size)
+            return 0;
+#endif
+        writer->reposition = 1;
+
+        if (writer->checksum)
+            Wave_HashUpdate(&writer->hash, bytes, frame_count * writer->format.block_align);
+
+        if (first_frame + frame_count > writer->frames_written)
+            writer->frames_written = first_frame + frame_count;
+        return 1;
+    }
+
+    int Wave_WriterEnd(WAVE_WRITER* writer)
+    {
+        if ((!writer) || (!writer->file))
+            return 0;
+
+        FILE* file = writer->file;
+        uint64_t data_size = (uint64_t)writer->frames_written * writer->format.block_align;
+        // The RIFF size skips its own 8 bytes, which the data chunk header makes up for
+        uint64_t riff_size = (writer->data_chunk_offset - writer->header_offset) + ((data_size + 1) & ~(uint64_t)1);
+        if (writer->checksum)
+            riff_size += sizeof(RIFF_CHUNK) + sizeof(WAVE_CHECKSUM);
+        if (riff_size > 0xFFFFFFFFu)
+            return 0;
+
+        // Blocks may have been stored with Wave_WriterWriteAt, the stream position is not trusted
+        if (!Wave_Seek(file, writer->data_chunk_offset + sizeof(RIFF_CHUNK) + data_size))
+            return 0;
+
+        // Chunks are word aligned
+        if (data_size & 1)
+        {
+            unsigned char pad = 0;
+            if (fwrite(&pad, 1, 1, file) != 1)
+                return 0;
+        }
+
+        if (writer->checksum)
+        {
+            RIFF_CHUNK checksum_chunk = { WAVE_CHUNK_CHECKSUM, sizeof(WAVE_CHECKSUM) };
+            WAVE_CHECKSUM checksum = { WAVE_CHECKSUM_ALGORITHM_XXH64, 0, Wave_HashEnd(&writer->hash) };
+            if (fwrite(&checksum_chunk, sizeof(checksum_chunk), 1, file) != 1)
+                return 0;
+            if (fwrite(&checksum, sizeof(checksum), 1, file) != 1)
+                return 0;
+        }
+
+        uint64_t end;
+        if (!Wave_Tell(file, &end))
+            return 0;
+        if (!Wave_WriteU32At(file, writer->header_offset + 4, (uint32_t)riff_size))
+            return 0;
+        if (!Wave_WriteU32At(file, writer->data_chunk_offset + 4, (uint32_t)data_size))
+            return 0;
+        if (!Wave_Seek(file, end))
+            return 0;
+
+        writer->file = NULL;
+        return 1;
+    }
+#endif // SIMPLE_WAVE_NO_WRITER
+
+#ifndef SIMPLE_WAVE_NO_DSP
+    int Wave_TimelineInit(WAVE_TIMELINE* timeline, const WAVE_CLIP* clips, size_t clip_count, int channels, WAVE_ALLOCATOR* allocator)
+    {
+        if ((!timeline) || (channels <= 0) || (channels > WAVE_MAX_CHANNELS))
+            return 0;
+        if ((clip_count) && (!clips))
+            return 0;
+        if (clip_count > 0xFFFFFFFFu)
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        memset(timeline, 0, sizeof(WAVE_TIMELINE));
+        timeline->clips = clips;
+        timeline->clip_count = clip_count;
+        timeline->channels = channels;
+
+        size_t i;
+        for (i = 0; i < clip_count; ++i)
+        {
+            const WAVE_CLIP* clip = &clips[i];
+            if ((!clip->wave) || (!clip->wave->sample_data) || (!clip->wave->format))
+                return 0;
+            if ((!clip->wave->format->channels) || (clip->wave->format->channels > WAVE_MAX_CHANNELS))
+                return 0;
+            if (clip->frame_count > (size_t)-1 - clip->position)
+                return 0;
+            if ((clip->source_frame > Wave_GetFrameCount(clip->wave)) || (clip->frame_count > Wave_GetFrameCount(clip->wave) - clip->source_frame))
+                return 0;
+
+            if ((clip->frame_count) && (clip->position + clip->frame_count > timeline->frame_count))
+                timeline->frame_count = clip->position + clip->frame_count;
+        }
+
+        // Count the clips overlapping every bucket, then fill them in clip order
+        // so the mix order of a frame never depends on how the timeline is split
+        size_t bucket_count = (timeline->frame_count + WAVE_TIMELINE_BUCKET_FRAMES - 1) / WAVE_TIMELINE_BUCKET_FRAMES;
+        size_t entry_count = 0;
+        for (i = 0; i < clip_count; ++i)
+        {
+            const WAVE_CLIP* clip = &clips[i];
+            if (clip->frame_count)
+                entry_count += (clip->position + clip->frame_count - 1) / WAVE_TIMELINE_BUCKET_FRAMES - clip->position / WAVE_TIMELINE_BUCKET_FRAMES + 1;
+        }
+        if (entry_count > 0xFFFFFFFFu)
+            return 0;
+
+        timeline->free_ptr_size = (bucket_count + 1 + entry_count) * sizeof(uint32_t);
+        timeline->free_ptr = allocator->allocate(allocator->data, timeline->free_ptr_size);
+        if (!timeline->free_ptr)
+            return 0;
+
+        timeline->bucket_count = bucket_count;
+        timeline->bucket_starts = (uint32_t*)timeline->free_ptr;
+        timeline->bucket_clips = timeline->bucket_starts + bucket_count + 1;
+        memset(timeline->bucket_starts, 0, (bucket_count + 1) * sizeof(uint32_t));
+
+        size_t b;
+        for (i = 0; i < clip_count; ++i)
+        {
+            const WAVE_CLIP* clip = &clips[i];
+            if (!clip->frame_count)
+                continue;
+            size_t last = (clip->position + clip->frame_count - 1) / WAVE_TIMELINE_BUCKET_FRAMES;
+            for (b = clip->position / WAVE_TIMELINE_BUCKET_FRAMES; b <= last; ++b)
+                timeline->bucket_starts[b + 1]++;
+        }
+        for (b = 0; b < bucket_count; ++b)
+            timeline->bucket_starts[b + 1] += timeline->bucket_starts[b];
+
+        // Reuse the starts as fill cursors, shifted back afterwards
+        for (i = 0; i < clip_count; ++i)
+        {
+            const WAVE_CLIP* clip = &clips[i];
+            if (!clip->frame_count)
+                continue;
+            size_t last = (clip->position + clip->frame_count - 1) / WAVE_TIMELINE_BUCKET_FRAMES;
+            for (b = clip->position / WAVE_TIMELINE_BUCKET_FRAMES; b <= last; ++b)
+                timeline->bucket_clips[timeline->bucket_starts[b]++] = (uint32_t)i;
+        }
+        for (b = bucket_count; b > 0; --b)
+            timeline->bucket_starts[b] = timeline->bucket_starts[b - 1];
+        timeline->bucket_starts[0] = 0;
+
+        return 1;
+    }
+
+    static void Wave_TimelineMixClip(WAVE_TIMELINE* timeline, const WAVE_CLIP* clip, size_t first_frame, size_t frame_count, float* out_frames)
+    {
+        float temp[WAVE_MAX_CHANNELS * 16];
+        size_t channels = (size_t)timeline->channels;
+        size_t source_channels = clip->wave->format->channels;
+        size_t chunk_frames = sizeof(temp) / sizeof(float) / source_channels;
+        size_t offset = first_frame - clip->position;
+
+        while (frame_count)
+        {
+            size_t count = (frame_count < chunk_frames) ? frame_count : chunk_frames;
+            Wave_ReadFramesFloat(clip->wave, clip->source_frame + offset, count, temp);
+
+            size_t i, c;
+            for (i = 0; i < count; ++i)
+            {
+                size_t at = offset + i;
+                float gain = clip->gain;
+                if (at < clip->fade_in_frames)
+                    gain *= (float)at / (float)clip->fade_in_frames;
+                if (clip->frame_count - at <= clip->fade_out_frames)
+                    gain *= (float)(clip->frame_count - at - 1) / (float)clip->fade_out_frames;
+
+                const float* src = temp + i * source_channels;
+                float* dst = out_frames + i * channels;
+                if (source_channels == 1)
+                {
+                    for (c = 0; c < channels; ++c)
+                        dst[c] += src[0] * gain;
+                }
+                else
+                {
+                    size_t shared = (source_channels < channels) ? source_channels : channels;
+                    for (c = 0; c < shared; ++c)
+                        dst[c] += src[c] * gain;
+                }
+            }
+
+            out_frames += count * channels;
+            offset += count;
+            frame_count -= count;
+        }
+    }
+
+    int Wave_TimelineRender(WAVE_TIMELINE* timeline, size_t first_frame, size_t frame_count, float* out_frames)
+    {
+        if ((!timeline) || (!out_frames))
+            return 0;
+
+        memset(out_frames, 0, frame_count * timeline->channels * sizeof(float));
+
+        size_t end_frame = timeline->frame_count;
+        if ((first_frame < end_frame) && (frame_count < end_frame - first_frame))
+            end_frame = first_frame + frame_count;
+
+        size_t at = first_frame;
+        while (at < end_frame)
+        {
+            // Mix one bucket at a time, only its active clips are visited
+            size_t bucket = at / WAVE_TIMELINE_BUCKET_FRAMES;
+            size_t bucket_end = (bucket + 1) * WAVE_TIMELINE_BUCKET_FRAMES;
+            if (bucket_end > end_frame)
+                bucket_end = end_frame;
+
+            uint32_t k;
+            for (k = timeline->bucket_starts[bucket]; k < timeline->bucket_starts[bucket + 1]; ++k)
+            {
+                const WAVE_CLIP* clip = &timeline->clips[timeline->bucket_clips[k]];
+                size_t clip_start = (clip->position > at) ? clip->position : at;
+                size_t clip_end = clip->position + clip->frame_count;
+                if (clip_end > bucket_end)
+                    clip_end = bucket_end;
+                if (clip_start >= clip_end)
+                    continue;
+
+                Wave_TimelineMixClip(timeline, clip, clip_start, clip_end - clip_start, out_frames + (clip_start - first_frame) * timeline->channels);
+            }
+
+            at = bucket_end;
+        }
+
+        return 1;
+    }
+
+    int Wave_TimelineGetSlab(WAVE_TIMELINE* timeline, size_t slab_index, size_t slab_count, size_t* out_first_frame, size_t* out_frame_count)
+    {
+        if ((!timeline) || (!slab_count) || (slab_index >= slab_count))
+            return 0;
+
+        size_t first_bucket = timeline->bucket_count * slab_index / slab_count;
+        size_t last_bucket = timeline->bucket_count * (slab_index + 1) / slab_count;
+        size_t first_frame = first_bucket * WAVE_TIMELINE_BUCKET_FRAMES;
+        size_t end_frame = last_bucket * WAVE_TIMELINE_BUCKET_FRAMES;
+        if (end_frame > timeline->frame_count)
+            end_frame = timeline->frame_count;
+
+        if (out_first_frame)
+            *out_first_frame = first_frame;
+        if (out_frame_count)
+            *out_frame_count = end_frame - first_frame;
+        return 1;
+    }
+
+#ifndef SIMPLE_WAVE_NO_WRITER
+    int Wave_TimelineRenderToWriter(WAVE_TIMELINE* timeline, WAVE_WRITER* writer, WAVE_ALLOCATOR* allocator)
+    {
+        if ((!timeline) || (!writer))
+            return 0;
+        if (writer->format.channels != timeline->channels)
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        size_t buffer_size = WAVE_TIMELINE_BUCKET_FRAMES * timeline->channels * sizeof(float);
+        float* buffer = (float*)allocator->allocate(allocator->data, buffer_size);
+        if (!buffer)
+            return 0;
+
+        int result = 1;
+        size_t at;
+        for (at = 0; (result) && (at < timeline->frame_count); at += WAVE_TIMELINE_BUCKET_FRAMES)
+        {
+            size_t count = timeline->frame_count - at;
+            if (count > WAVE_TIMELINE_BUCKET_FRAMES)
+                count = WAVE_TIMELINE_BUCKET_FRAMES;
+
+            result = Wave_TimelineRender(timeline, at, count, buffer) && Wave_WriterWriteFloat(writer, buffer, count);
+        }
+
+        allocator->free(allocator->data, buffer, buffer_size);
+        return result;
+    }
+#endif // SIMPLE_WAVE_NO_WRITER
+
+    int Wave_TimelineFree(WAVE_TIMELINE* timeline, WAVE_ALLOCATOR* allocator)
+    {
+        if (!timeline)
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        if (timeline->free_ptr)
+        {
+            allocator->free(allocator->data, timeline->free_ptr, timeline->free_ptr_size);
+            timeline->free_ptr = NULL;
+            timeline->free_ptr_size = 0;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // ITU-R BS.1770-4 Annex 2, 48 taps split in 4 phases
+    static const float Wave_TruePeakCoefficients[WAVE_TRUE_PEAK_PHASES][WAVE_TRUE_PEAK_TAPS] =
+    {
+        {  0.0017089843750f,  0.0109863281250f, -0.0196533203125f,  0.0332031250000f, -0.0594482421875f,  0.1373291015625f,
+           0.9721679687500f, -0.1022949218750f,  0.0476074218750f, -0.0266113281250f,  0.0148925781250f, -0.0083007812500f },
+        { -0.0291748046875f,  0.0292968750000f, -0.0517578125000f,  0.0891113281250f, -0.1665039062500f,  0.4650878906250f,
+           0.7797851562500f, -0.2003173828125f,  0.1015625000000f, -0.0582275390625f,  0.0330810546875f, -0.0189208984375f },
+        { -0.0189208984375f,  0.0330810546875f, -0.0582275390625f,  0.1015625000000f, -0.2003173828125f,  0.7797851562500f,
+           0.4650878906250f, -0.1665039062500f,  0.0891113281250f, -0.0517578125000f,  0.0292968750000f, -0.0291748046875f },
+        { -0.0083007812500f,  0.0148925781250f, -0.0266113281250f,  0.0476074218750f, -0.1022949218750f,  0.9721679687500f,
+           0.1373291015625f, -0.0594482421875f,  0.0332031250000f, -0.0196533203125f,  0.0109863281250f,  0.0017089843750f },
+    };
+
+    // The main tap sits 6 frames behind the newest input in the first two phases, 5 in the last two
+#define WAVE_TRUE_PEAK_DELAY 6
+
+    int Wave_TruePeakInit(WAVE_TRUE_PEAK* meter, int channels)
+    {
+        if ((!meter) || (channels <= 0) || (channels > WAVE_MAX_CHANNELS))
+            return 0;
+
+        memset(meter, 0, sizeof(WAVE_TRUE_PEAK));
+        meter->channels = channels;
+        return 1;
+    }
+
+    int Wave_TruePeakProcess(WAVE_TRUE_PEAK* meter, const float* frames, size_t frame_count)
+    {
+        if ((!meter) || (meter->channels <= 0))
+            return 0;
+        if ((frame_count) && (!frames))
+            return 0;
+
+        // History followed by the new frames in one contiguous window
+        float window[(WAVE_TRUE_PEAK_TAPS - 1 + 64) * WAVE_MAX_CHANNELS];
+        size_t channels = (size_t)meter->channels;
+        size_t history_size = (WAVE_TRUE_PEAK_TAPS - 1) * channels;
+        size_t chunk_frames = sizeof(window) / sizeof(float) / channels - (WAVE_TRUE_PEAK_TAPS - 1);
+
+        while (frame_count)
+        {
+            size_t count = (frame_count < chunk_frames) ? frame_count : chunk_frames;
+            memcpy(window, meter->history, history_size * sizeof(float));
+            memcpy(window + history_size, frames, count * channels * sizeof(float));
+
+            size_t f, p, k, c;
+            for (f = 0; f < count; ++f)
+            {
+                // Newest frame of this output is window frame f + TAPS - 1, coefficient k reads k frames back
+                const float* newest = window + (f + WAVE_TRUE_PEAK_TAPS - 1) * channels;
+                size_t frame = meter->frames_processed + f;
+
+                for (p = 0; p < WAVE_TRUE_PEAK_PHASES; ++p)
+                {
+                    // Phases past the half way point lie nearer the next input frame
+                    size_t delay = (p < WAVE_TRUE_PEAK_PHASES / 2) ? WAVE_TRUE_PEAK_DELAY : WAVE_TRUE_PEAK_DELAY - 1;
+                    size_t position = (frame > delay) ? frame - delay : 0;
+                    float lanes[WAVE_MAX_CHANNELS] = { 0 };
+                    for (k = 0; k < WAVE_TRUE_PEAK_TAPS; ++k)
+                    {
+                        float coefficient = Wave_TruePeakCoefficients[p][k];
+                        const float* x = newest - k * channels;
+                        for (c = 0; c < channels; ++c)
+                            lanes[c] += coefficient * x[c];
+                    }
+
+                    for (c = 0; c < channels; ++c)
+                    {
+                        float v = fabsf(lanes[c]);
+                        if (v > meter->peak[c])
+                        {
+                            meter->peak[c] = v;
+                            meter->peak_frame[c] = position;
+                        }
+                    }
+                }
+            }
+
+            memcpy(meter->history, window + count * channels, history_size * sizeof(float));
+            meter->frames_processed += count;
+            frames += count * channels;
+            frame_count -= count;
+        }
+
+        return 1;
+    }
+
+    int Wave_TruePeakProcessWave(WAVE_TRUE_PEAK* meter, WAVE* wave)
+    {
+        if ((!meter) || (!wave) || (!wave->sample_data))
+            return 0;
+        if (Wave_GetChannelCount(wave) != meter->channels)
+            return 0;
+
+        float temp[64 * WAVE_MAX_CHANNELS];
+        size_t chunk_frames = sizeof(temp) / sizeof(float) / meter->channels;
+        size_t total = Wave_GetFrameCount(wave);
+        size_t at;
+        for (at = 0; at < total; at += chunk_frames)
+        {
+            size_t count = Wave_ReadFramesFloat(wave, at, chunk_frames, temp);
+            if (!Wave_TruePeakProcess(meter, temp, count))
+                return 0;
+        }
+
+        return 1;
+    }
+
+    int Wave_TruePeakFinish(WAVE_TRUE_PEAK* meter)
+    {
+        if ((!meter) || (meter->channels <= 0))
+            return 0;
+
+        // Zero frames push the tail of the signal through every tap, they are not counted as input
+        float zeros[(WAVE_TRUE_PEAK_TAPS - 1) * WAVE_MAX_CHANNELS] = { 0 };
+        size_t frames_processed = meter->frames_processed;
+        int result = Wave_TruePeakProcess(meter, zeros, WAVE_TRUE_PEAK_TAPS - 1);
+        meter->frames_processed = frames_processed;
+
+        // Peaks found in the padding are reported at the last real frame
+        int c;
+        for (c = 0; c < meter->channels; ++c)
+            if (meter->peak_frame[c] >= frames_processed)
+                meter->peak_frame[c] = frames_processed ? frames_processed - 1 : 0;
+
+        return result;
+    }
+
+    float Wave_TruePeakGetDecibels(WAVE_TRUE_PEAK* meter, int channel, size_t* out_frame)
+    {
+        if ((!meter) || (channel < 0) || (channel >= meter->channels))
+            return -HUGE_VALF;
+
+        if (out_frame)
+            *out_frame = meter->peak_frame[channel];
+        if (meter->peak[channel] <= 0.0f)
+            return -HUGE_VALF;
+
+        return 20.0f * log10f(meter->peak[channel]);
+    }
+
+    static void Wave_FFTBitReverse(float* real, float* imag, size_t size)
+    {
+        size_t i, j;
+        for (i = 1, j = 0; i < size; ++i)
+        {
+            size_t bit = size >> 1;
+            for (; j & bit; bit >>= 1)
+                j ^= bit;
+            j ^= bit;
+
+            if (i < j)
+            {
+                float t = real[i]; real[i] = real[j]; real[j] = t;
+                t = imag[i]; imag[i] = imag[j]; imag[j] = t;
+            }
+        }
+    }
+
+    int Wave_FFT(float* real, float* imag, size_t size, int inverse)
+    {
+        if ((!real) || (!imag) || (!size) || (size & (size - 1)))
+            return 0;
+
+        Wave_FFTBitReverse(real, imag, size);
+
+        // Butterflies, twiddles are computed in double per stage to keep large sizes accurate
+        size_t length, i, k;
+        for (length = 2; length <= size; length <<= 1)
+        {
+            double angle = (inverse ? 2.0 : -2.0) * 3.14159265358979323846 / (double)length;
+            size_t half = length >> 1;
+            for (k = 0; k < half; ++k)
+            {
+                float wr = (float)cos(angle * (double)k);
+                float wi = (float)sin(angle * (double)k);
+                for (i = k; i < size; i += length)
+                {
+                    size_t m = i + half;
+                    float tr = real[m] * wr - imag[m] * wi;
+                    float ti = real[m] * wi + imag[m] * wr;
+                    real[m] = real[i] - tr;
+                    imag[m] = imag[i] - ti;
+                    real[i] += tr;
+                    imag[i] += ti;
+                }
+            }
+        }
+
+        return 1;
+    }
+
+    int Wave_FFTTwiddles(float* out_twiddles, size_t size)
+    {
+        if ((!out_twiddles) || (!size) || (size & (size - 1)))
+            return 0;
+
+        size_t half = size >> 1;
+        size_t k;
+        for (k = 0; k < half; ++k)
+        {
+            double angle = -2.0 * 3.14159265358979323846 * (double)k / (double)size;
+            out_twiddles[k] = (float)cos(angle);
+            out_twiddles[half + k] = (float)sin(angle);
+        }
+
+        return 1;
+    }
+
+    int Wave_FFTWithTwiddles(float* real, float* imag, size_t size, int inverse, const float* twiddles)
+    {
+        if ((!real) || (!imag) || (!twiddles) || (!size) || (size & (size - 1)))
+            return 0;
+
+        Wave_FFTBitReverse(real, imag, size);
+
+        // Stage length reads every size / length twiddle, the inverse conjugates them
+        size_t half_size = size >> 1;
+        size_t length, i, k;
+        for (length = 2; length <= size; length <<= 1)
+        {
+            size_t half = length >> 1;
+            size_t stride = size / length;
+            for (k = 0; k < half; ++k)
+            {
+                float wr = twiddles[k * stride];
+                float wi = inverse ? -twiddles[half_size + k * stride] : twiddles[half_size + k * stride];
+                for (i = k; i < size; i += length)
+                {
+                    size_t m = i + half;
+                    float tr = real[m] * wr - imag[m] * wi;
+                    float ti = real[m] * wi + imag[m] * wr;
+                    real[m] = real[i] - tr;
+                    imag[m] = imag[i] - ti;
+                    real[i] += tr;
+                    imag[i] += ti;
+                }
+            }
+        }
+
+        return 1;
+    }
+
+    // Reads a mono downmix, frames past the end of the wave are silent
+    static void Wave_ReadMono(WAVE* wave, size_t first_frame, size_t frame_count, float* out_samples)
+    {
+        float temp[64 * WAVE_MAX_CHANNELS];
+        size_t channels = wave->format->channels;
+        size_t chunk_frames = sizeof(temp) / sizeof(float) / channels;
+        float scale = 1.0f / (float)channels;
+
+        while (frame_count)
+        {
+            size_t count = (frame_count < chunk_frames) ? frame_count : chunk_frames;
+            size_t read = Wave_ReadFramesFloat(wave, first_frame, count, temp);
+
+            size_t i, c;
+            for (i = 0; i < read; ++i)
+            {
+                float sum = 0.0f;
+                for (c = 0; c < channels; ++c)
+                    sum += temp[i * channels + c];
+                out_samples[i] = sum * scale;
+            }
+            for (; i < count; ++i)
+                out_samples[i] = 0.0f;
+
+            first_frame += count;
+            out_samples += count;
+            frame_count -= count;
+        }
+    }
+
+    // Half-wave rectified log magnitude difference between the spectrum of hop and the previous one
+    static float Wave_OnsetFlux(const float* samples, const float* window, const float* twiddles, float* magnitudes)
+    {
+        float real[WAVE_ONSET_FRAME_SIZE];
+        float imag[WAVE_ONSET_FRAME_SIZE];
+        size_t i;
+
+        for (i = 0; i < WAVE_ONSET_FRAME_SIZE; ++i)
+        {
+            real[i] = samples[i] * window[i];
+            imag[i] = 0.0f;
+        }
+        Wave_FFTWithTwiddles(real, imag, WAVE_ONSET_FRAME_SIZE, 0, twiddles);
+
+        float flux = 0.0f;
+        for (i = 0; i <= WAVE_ONSET_FRAME_SIZE / 2; ++i)
+        {
+            float magnitude = logf(1.0f + 100.0f * sqrtf(real[i] * real[i] + imag[i] * imag[i]));
+            float diff = magnitude - magnitudes[i];
+            flux += (diff > 0.0f) ? diff : 0.0f;
+            magnitudes[i] = magnitude;
+        }
+
+        return flux / (float)(WAVE_ONSET_FRAME_SIZE / 2 + 1);
+    }
+
+    int Wave_DetectOnsets(WAVE* wave, size_t first_frame, size_t frame_count, float threshold, size_t* out_frames, size_t max_onsets, size_t* out_onset_count)
+    {
+        if ((!wave) || (!wave->sample_data) || (!wave->format) || (!wave->format->channels))
+            return 0;
+        if (wave->format->channels > WAVE_MAX_CHANNELS)
+            return 0;
+        if ((max_onsets) && (!out_frames))
+            return 0;
+
+        size_t total = Wave_GetFrameCount(wave);
+        if (first_frame > total)
+            first_frame = total;
+        if (frame_count > total - first_frame)
+            frame_count = total - first_frame;
+
+        size_t end_frame = first_frame + frame_count;
+        size_t onset_count = 0;
+
+        // Hop h reports its onset at h * HOP + HOP, find the hops whose report falls in range
+        size_t first_hop = (first_frame > WAVE_ONSET_HOP_SIZE) ? (first_frame - WAVE_ONSET_HOP_SIZE + WAVE_ONSET_HOP_SIZE - 1) / WAVE_ONSET_HOP_SIZE : 0;
+        size_t end_hop = (end_frame > WAVE_ONSET_HOP_SIZE) ? (end_frame - WAVE_ONSET_HOP_SIZE + WAVE_ONSET_HOP_SIZE - 1) / WAVE_ONSET_HOP_SIZE : 0;
+        size_t hop_count = (total + WAVE_ONSET_HOP_SIZE - 1) / WAVE_ONSET_HOP_SIZE;
+        if (end_hop > hop_count)
+            end_hop = hop_count;
+
+        if (first_hop < end_hop)
+        {
+            // Pre-roll far enough back that the threshold window and the previous spectrum match a full pass
+            size_t start_hop = (first_hop > WAVE_ONSET_AVERAGE_HOPS + 1) ? first_hop - WAVE_ONSET_AVERAGE_HOPS - 1 : 0;
+
+            float samples[WAVE_ONSET_FRAME_SIZE];
+            float magnitudes[WAVE_ONSET_FRAME_SIZE / 2 + 1];
+            float history[WAVE_ONSET_AVERAGE_HOPS] = { 0 };
+            size_t history_count = 0;
+            float previous = 0.0f, current = 0.0f, next = 0.0f;
+
+            // Window and twiddles are shared by every hop of the call
+            float window[WAVE_ONSET_FRAME_SIZE];
+            float twiddles[WAVE_ONSET_FRAME_SIZE];
+            size_t i;
+            for (i = 0; i < WAVE_ONSET_FRAME_SIZE; ++i)
+                window[i] = 0.5f - 0.5f * cosf(2.0f * 3.14159265f * (float)i / (float)WAVE_ONSET_FRAME_SIZE);
+            Wave_FFTTwiddles(twiddles, WAVE_ONSET_FRAME_SIZE);
+
+            Wave_ReadMono(wave, start_hop * WAVE_ONSET_HOP_SIZE, WAVE_ONSET_FRAME_SIZE, samples);
+            memset(magnitudes, 0, sizeof(magnitudes));
+
+            // The first hop of the wave has no previous spectrum, its flux is 0
+            size_t h;
+            for (h = start_hop; h <= end_hop; ++h)
+            {
+                if (h != start_hop)
+                {
+                    memmove(samples, samples + WAVE_ONSET_HOP_SIZE, (WAVE_ONSET_FRAME_SIZE - WAVE_ONSET_HOP_SIZE) * sizeof(float));
+                    Wave_ReadMono(wave, h * WAVE_ONSET_HOP_SIZE + WAVE_ONSET_FRAME_SIZE - WAVE_ONSET_HOP_SIZE, WAVE_ONSET_HOP_SIZE, samples + WAVE_ONSET_FRAME_SIZE - WAVE_ONSET_HOP_SIZE);
+                }
+
+                float flux = Wave_OnsetFlux(samples, window, twiddles, magnitudes);
+                if ((h == 0) || (h == start_hop))
+                    flux = 0.0f;
+                if (h >= hop_count)
+                    flux = 0.0f;
+
+                previous = current;
+                current = next;
+                next = flux;
+
+                // Decide on h - 1 now that its successor is known
+                if ((h > start_hop) && (h - 1 >= first_hop) && (h - 1 < end_hop))
+                {
+                    float average = 0.0f;
+                    for (i = 0; i < history_count; ++i)
+                        average += history[i];
+                    if (history_count)
+                        average /= (float)history_count;
+
+                    if ((current > previous) && (current >= next) && (current > average + threshold))
+                    {
+                        if (onset_count < max_onsets)
+                            out_frames[onset_count] = (h - 1) * WAVE_ONSET_HOP_SIZE + WAVE_ONSET_HOP_SIZE;
+                        onset_count++;
+                    }
+                }
+
+                // Running window of the fluxes before the next candidate
+                if (h > start_hop)
+                {
+                    if (history_count < WAVE_ONSET_AVERAGE_HOPS)
+                        history[history_count++] = current;
+                    else
+                    {
+                        memmove(history, history + 1, (WAVE_ONSET_AVERAGE_HOPS - 1) * sizeof(float));
+                        history[WAVE_ONSET_AVERAGE_HOPS - 1] = current;
+                    }
+                }
+            }
+        }
+
+        if (out_onset_count)
+            *out_onset_count = onset_count;
+        return 1;
+    }
+
+    static void Wave_LevelsAccumulate(WAVE_LEVELS* levels, const float* frames, size_t frame_count)
+    {
+        size_t channels = (size_t)levels->channels;
+        size_t i, c;
+
+        // Frame order inside a block is fixed, channels are independent lanes
+        for (i = 0; i < frame_count; ++i)
+        {
+            const float* frame = frames + i * channels;
+            for (c = 0; c < channels; ++c)
+            {
+                float v = fabsf(frame[c]);
+                levels->peak[c] = (v > levels->peak[c]) ? v : levels->peak[c];
+                levels->sum_squares[c] += (double)frame[c] * (double)frame[c];
+            }
+        }
+
+        levels->frame_count += frame_count;
+    }
+
+    static void Wave_LevelsMerge(WAVE_LEVELS* left, const WAVE_LEVELS* right)
+    {
+        int c;
+        for (c = 0; c < left->channels; ++c)
+        {
+            left->peak[c] = (right->peak[c] > left->peak[c]) ? right->peak[c] : left->peak[c];
+            left->sum_squares[c] += right->sum_squares[c];
+        }
+        left->frame_count += right->frame_count;
+    }
+
+    static void Wave_LevelsReset(WAVE_LEVELS* levels, int channels)
+    {
+        memset(levels, 0, sizeof(WAVE_LEVELS));
+        levels->channels = channels;
+    }
+
+    static int Wave_LevelsPushBlock(WAVE_LEVELS_STATE* state, const WAVE_LEVELS* block)
+    {
+        WAVE_LEVELS carry = *block;
+        size_t level = 0;
+
+        // Binary counter, equal sized groups are merged as soon as they exist
+        while (state->block_count & ((size_t)1 << level))
+        {
+            WAVE_LEVELS merged = state->stack[level];
+            Wave_LevelsMerge(&merged, &carry);
+            carry = merged;
+            if (++level >= WAVE_LEVELS_STACK_DEPTH)
+                return 0;
+        }
+
+        state->stack[level] = carry;
+        state->block_count++;
+        return 1;
+    }
+
+    int Wave_LevelsBegin(WAVE_LEVELS_STATE* state, int channels)
+    {
+        if ((!state) || (channels <= 0) || (channels > WAVE_MAX_CHANNELS))
+            return 0;
+
+        state->block_count = 0;
+        Wave_LevelsReset(&state->pending, channels);
+        return 1;
+    }
+
+    int Wave_LevelsProcess(WAVE_LEVELS_STATE* state, const float* frames, size_t frame_count)
+    {
+        if ((!state) || (state->pending.channels <= 0))
+            return 0;
+        if ((frame_count) && (!frames))
+            return 0;
+
+        size_t channels = (size_t)state->pending.channels;
+        while (frame_count)
+        {
+            size_t count = WAVE_LEVELS_BLOCK_FRAMES - state->pending.frame_count;
+            if (count > frame_count)
+                count = frame_count;
+
+            Wave_LevelsAccumulate(&state->pending, frames, count);
+            if (state->pending.frame_count == WAVE_LEVELS_BLOCK_FRAMES)
+            {
+                if (!Wave_LevelsPushBlock(state, &state->pending))
+                    return 0;
+                Wave_LevelsReset(&state->pending, (int)channels);
+            }
+
+            frames += count * channels;
+            frame_count -= count;
+        }
+
+        return 1;
+    }
+
+    int Wave_LevelsProcessWave(WAVE_LEVELS_STATE* state, WAVE* wave)
+    {
+        if ((!state) || (!wave) || (!wave->sample_data))
+            return 0;
+        if (Wave_GetChannelCount(wave) != state->pending.channels)
+            return 0;
+
+        float temp[64 * WAVE_MAX_CHANNELS];
+        size_t chunk_frames = sizeof(temp) / sizeof(float) / state->pending.channels;
+        size_t total = Wave_GetFrameCount(wave);
+        size_t at;
+        for (at = 0; at < total; at += chunk_frames)
+        {
+            size_t count = Wave_ReadFramesFloat(wave, at, chunk_frames, temp);
+            if (!Wave_LevelsProcess(state, temp, count))
+                return 0;
+        }
+
+        return 1;
+    }
+
+    int Wave_LevelsGetResult(WAVE_LEVELS_STATE* state, WAVE_LEVELS* out_levels)
+    {
+        if ((!state) || (!out_levels) || (state->pending.channels <= 0))
+            return 0;
+
+        // Fold the groups from the smallest (latest) up, then the incomplete block
+        Wave_LevelsReset(out_levels, state->pending.channels);
+        int first = 1;
+        size_t level;
+        for (level = 0; level < WAVE_LEVELS_STACK_DEPTH; ++level)
+        {
+            if (!(state->block_count & ((size_t)1 << level)))
+                continue;
+
+            if (first)
+                *out_levels = state->stack[level];
+            else
+            {
+                WAVE_LEVELS merged = state->stack[level];
+                Wave_LevelsMerge(&merged, out_levels);
+                *out_levels = merged;
+            }
+            first = 0;
+        }
+
+        Wave_LevelsMerge(out_levels, &state->pending);
+        return 1;
+    }
+
+    int Wave_LevelsComputeBlocks(WAVE* wave, size_t first_block, size_t block_count, WAVE_LEVELS* out_blocks)
+    {
+        if ((!wave) || (!wave->sample_data) || (!out_blocks))
+            return 0;
+
+        int channels = Wave_GetChannelCount(wave);
+        if ((channels <= 0) || (channels > WAVE_MAX_CHANNELS))
+            return 0;
+
+        float temp[64 * WAVE_MAX_CHANNELS];
+        size_t chunk_frames = sizeof(temp) / sizeof(float) / channels;
+        size_t b;
+        for (b = 0; b < block_count; ++b)
+        {
+            WAVE_LEVELS* block = &out_blocks[b];
+            Wave_LevelsReset(block, channels);
+
+            size_t at = (first_block + b) * WAVE_LEVELS_BLOCK_FRAMES;
+            size_t end = at + WAVE_LEVELS_BLOCK_FRAMES;
+            while (at < end)
+            {
+                size_t count = Wave_ReadFramesFloat(wave, at, ((end - at) < chunk_frames) ? end - at : chunk_frames, temp);
+                if (!count)
+                    break;
+                Wave_LevelsAccumulate(block, temp, count);
+                at += count;
+            }
+        }
+
+        return 1;
+    }
+
+    int Wave_LevelsCombine(WAVE_LEVELS_STATE* state, const WAVE_LEVELS* blocks, size_t block_count)
+    {
+        if ((!state) || (state->pending.channels <= 0) || (state->pending.frame_count))
+            return 0;
+        if ((block_count) && (!blocks))
+            return 0;
+
+        size_t b;
+        for (b = 0; b < block_count; ++b)
+        {
+            if (blocks[b].channels != state->pending.channels)
+                return 0;
+
+            if (blocks[b].frame_count == WAVE_LEVELS_BLOCK_FRAMES)
+            {
+                if (!Wave_LevelsPushBlock(state, &blocks[b]))
+                    return 0;
+            }
+            else if ((b == block_count - 1) && (blocks[b].frame_count < WAVE_LEVELS_BLOCK_FRAMES))
+                state->pending = blocks[b];
+            else
+                return 0;
+        }
+
+        return 1;
+    }
+
+    float Wave_LevelsGetRmsDecibels(WAVE_LEVELS* levels, int channel)
+    {
+        if ((!levels) || (channel < 0) || (channel >= levels->channels) || (!levels->frame_count))
+            return -HUGE_VALF;
+
+        double mean = levels->sum_squares[channel] / (double)levels->frame_count;
+        if (mean <= 0.0)
+            return -HUGE_VALF;
+
+        return (float)(10.0 * log10(mean));
+    }
+
+    float Wave_LevelsGetPeakDecibels(WAVE_LEVELS* levels, int channel)
+    {
+        if ((!levels) || (channel < 0) || (channel >= levels->channels) || (levels->peak[channel] <= 0.0f))
+            return -HUGE_VALF;
+
+        return 20.0f * log10f(levels->peak[channel]);
+    }
+#endif // SIMPLE_WAVE_NO_DSP
+
+#ifndef SIMPLE_WAVE_NO_STDIO
+    int Wave_ReaderOpen(WAVE_READER* reader, FILE* file, long size, WAVE_ALLOCATOR* allocator)
+    {
+        if ((!reader) || (!file))
+            return 0;
+
+        memset(reader, 0, sizeof(WAVE_READER));
+        if (!Wave_LoadStreamOnlyInfo(file, size, &reader->wave, allocator))
+        {
+            Wave_Free(&reader->wave, allocator);
+            return 0;
+        }
+
+        reader->file = file;
+        reader->sample_format = Wave_GetSampleFormat(&reader->wave);
+        reader->frame_count = Wave_GetFrameCount(&reader->wave);
+        Wave_HashBegin(&reader->hash);
+        return Wave_ReaderSeek(reader, 0);
+    }
+
+    int Wave_ReaderSeek(WAVE_READER* reader, size_t frame)
+    {
+        if ((!reader) || (!reader->file))
+            return 0;
+        if (frame > reader->frame_count)
+            return 0;
+
+        uint64_t offset = (uint64_t)reader->wave.sample_data_offset + (uint64_t)frame * reader->wave.format->block_align;
+        if (!Wave_Seek(reader->file, offset))
+            return 0;
+
+        reader->frame_position = frame;
+        return 1;
+    }
+
+    size_t Wave_ReaderRead(WAVE_READER* reader, void* out_frames, size_t frame_count)
+    {
+        if ((!reader) || (!reader->file) || (!out_frames))
+            return 0;
+
+        if (frame_count > reader->frame_count - reader->frame_position)
+            frame_count = reader->frame_count - reader->frame_position;
+
+        size_t read = fread(out_frames, reader->wave.format->block_align, frame_count, reader->file);
+        if (reader->frame_position == reader->hashed_frames)
+        {
+            Wave_HashUpdate(&reader->hash, out_frames, read * reader->wave.format->block_align);
+            reader->hashed_frames += read;
+        }
+
+        reader->frame_position += read;
+        return read;
+    }
+
+    size_t Wave_ReaderReadFloat(WAVE_READER* reader, float* out_frames, size_t frame_count)
+    {
+        if ((!reader) || (!reader->file) || (!out_frames))
+            return 0;
+
+        double temp[1024];
+        size_t channels = reader->wave.format->channels;
+        size_t chunk_frames = sizeof(temp) / reader->wave.format->block_align;
+        size_t total = 0;
+        if (!chunk_frames)
+            return 0;
+
+        while (frame_count)
+        {
+            size_t count = (frame_count < chunk_frames) ? frame_count : chunk_frames;
+            size_t read = Wave_ReaderRead(reader, temp, count);
+            Wave_ConvertToFloat(temp, reader->sample_format, read * channels, out_frames + total * channels);
+
+            total += read;
+            frame_count -= read;
+            if (read < count)
+                break;
+        }
+
+        return total;
+    }
+#endif // SIMPLE_WAVE_NO_STDIO
+
+    static int Wave_GetStoredChecksum(WAVE* wave, uint64_t* out_value)
+    {
+        if ((!wave->checksum_chunk) || (wave->checksum_chunk->size < sizeof(WAVE_CHECKSUM)))
+            return 0;
+
+        WAVE_CHECKSUM checksum;
+        memcpy(&checksum, wave->checksum_chunk + 1, sizeof(checksum));
+        if (checksum.algorithm != WAVE_CHECKSUM_ALGORITHM_XXH64)
+            return 0;
+
+        *out_value = checksum.value;
+        return 1;
+    }
+
+#ifndef SIMPLE_WAVE_NO_STDIO
+    int Wave_ReaderVerifyChecksum(WAVE_READER* reader)
+    {
+        if ((!reader) || (!reader->file))
+            return 0;
+
+        uint64_t expected;
+        if (!Wave_GetStoredChecksum(&reader->wave, &expected))
+            return 0;
+
+        // Hash whatever the caller did not stream, including bytes past the last whole frame
+        WAVE_HASH hash = reader->hash;
+        uint64_t offset = reader->hashed_frames * reader->wave.format->block_align;
+        uint64_t size = reader->wave.sample_data_size;
+        if (!Wave_Seek(reader->file, reader->wave.sample_data_offset + offset))
+            return 0;
+
+        unsigned char temp[4096];
+        while (offset < size)
+        {
+            size_t count = ((size - offset) < sizeof(temp)) ? (size_t)(size - offset) : sizeof(temp);
+            if (fread(temp, 1, count, reader->file) != count)
+                break;
+            Wave_HashUpdate(&hash, temp, count);
+            offset += count;
+        }
+
+        if (!Wave_ReaderSeek(reader, reader->frame_position))
+            return 0;
+
+        return (offset == size) && (Wave_HashEnd(&hash) == expected);
+    }
+#endif // SIMPLE_WAVE_NO_STDIO
+
+    int Wave_VerifyChecksum(WAVE* wave)
+    {
+        if ((!wave) || (!wave->sample_data))
+            return 0;
+
+        uint64_t expected;
+        if (!Wave_GetStoredChecksum(wave, &expected))
+            return 0;
+
+        WAVE_HASH hash;
+        Wave_HashBegin(&hash);
+        Wave_HashUpdate(&hash, wave->sample_data, wave->sample_data_size);
+        return Wave_HashEnd(&hash) == expected;
+    }
+
+#ifndef SIMPLE_WAVE_NO_STDIO
+    int Wave_ReaderClose(WAVE_READER* reader, WAVE_ALLOCATOR* allocator)
+    {
+        if (!reader)
+            return 0;
+
+        reader->file = NULL;
+        return Wave_Free(&reader->wave, allocator);
+    }
+#endif // SIMPLE_WAVE_NO_STDIO
+
+    void Wave_Deinterleave(const void* frames, size_t frame_count, int channel_count, WAVE_SAMPLE_FORMAT sample_format, void** out_channels)
+    {
+        const unsigned char* src = (const unsigned char*)frames;
+        size_t sample_size = Wave_GetSampleFormatSize(sample_format);
+        size_t stride = (size_t)channel_count * sample_size;
+        int c;
+
+        // Typed copies per sample size, the channel loop is outermost so every output is written sequentially
+        for (c = 0; c < channel_count; ++c)
+        {
+            unsigned char* dst = (unsigned char*)out_channels[c];
+            const unsigned char* at = src + c * sample_size;
+            size_t i;
+            if (!dst)
+                continue;
+
+            switch (sample_size)
+            {
+                case 1:
+                    for (i = 0; i < frame_count; ++i)
+                        dst[i] = at[i * stride];
+                    break;
+                case 2:
+                    for (i = 0; i < frame_count; ++i)
+                        memcpy(dst + i * 2, at + i * stride, 2);
+                    break;
+                case 4:
+                    for (i = 0; i < frame_count; ++i)
+                        memcpy(dst + i * 4, at + i * stride, 4);
+                    break;
+                case 8:
+                    for (i = 0; i < frame_count; ++i)
+                        memcpy(dst + i * 8, at + i * stride, 8);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+#ifndef SIMPLE_WAVE_NO_WRITER
+    int Wave_SplitChannels(WAVE_READER* reader, FILE** outputs, WAVE_ALLOCATOR* allocator)
+    {
+        if ((!reader) || (!reader->file) || (!outputs))
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        int channels = reader->wave.format->channels;
+        size_t sample_size = Wave_GetSampleFormatSize(reader->sample_format);
+        if ((channels <= 0) || (channels > WAVE_MAX_CHANNELS) || (!sample_size))
+            return 0;
+
+        WAVE_WRITER writers[WAVE_MAX_CHANNELS];
+        void* channel_buffers[WAVE_MAX_CHANNELS];
+        memset(writers, 0, sizeof(writers));
+
+        // One source block plus one write buffer per channel, all in a single allocation
+        size_t block_size = WAVE_SPLIT_BLOCK_FRAMES * reader->wave.format->block_align;
+        size_t buffer_size = block_size * 2;
+        char* buffer = (char*)allocator->allocate(allocator->data, buffer_size);
+        if (!buffer)
+            return 0;
+
+        int result = 1;
+        int c;
+        for (c = 0; c < channels; ++c)
+        {
+            channel_buffers[c] = NULL;
+            if (!outputs[c])
+                continue;
+
+            channel_buffers[c] = buffer + block_size + c * WAVE_SPLIT_BLOCK_FRAMES * sample_size;
+            if (!Wave_WriterBegin(&writers[c], outputs[c], reader->sample_format, 1, (int)reader->wave.format->samples_per_sec))
+                result = 0;
+        }
+
+        while (result)
+        {
+            size_t read = Wave_ReaderRead(reader, buffer, WAVE_SPLIT_BLOCK_FRAMES);
+            if (!read)
+                break;
+
+            Wave_Deinterleave(buffer, read, channels, reader->sample_format, channel_buffers);
+            for (c = 0; (result) && (c < channels); ++c)
+            {
+                if (channel_buffers[c])
+                    result = Wave_WriterWrite(&writers[c], channel_buffers[c], read);
+            }
+        }
+
+        for (c = 0; c < channels; ++c)
+        {
+            if ((writers[c].file) && (!Wave_WriterEnd(&writers[c])))
+                result = 0;
+        }
+
+        allocator->free(allocator->data, buffer, buffer_size);
+        return result;
+    }
+#endif // SIMPLE_WAVE_NO_WRITER
+
+    void Wave_Interleave(const void* const* channels, size_t frame_count, int channel_count, WAVE_SAMPLE_FORMAT sample_format, void* out_frames)
+    {
+        size_t sample_size = Wave_GetSampleFormatSize(sample_format);
+        size_t stride = (size_t)channel_count * sample_size;
+        unsigned char silence = (sample_format == WAVE_SAMPLE_FORMAT_U8) ? 128 : 0;
+        int c;
+
+        // Typed copies per sample size, every input is read sequentially
+        for (c = 0; c < channel_count; ++c)
+        {
+            const unsigned char* src = (const unsigned char*)channels[c];
+            unsigned char* at = (unsigned char*)out_frames + c * sample_size;
+            size_t i;
+
+            if (!src)
+            {
+                for (i = 0; i < frame_count; ++i)
+                    memset(at + i * stride, silence, sample_size);
+                continue;
+            }
+
+            switch (sample_size)
+            {
+                case 1:
+                    for (i = 0; i < frame_count; ++i)
+                        at[i * stride] = src[i];
+                    break;
+                case 2:
+                    for (i = 0; i < frame_count; ++i)
+                        memcpy(at + i * stride, src + i * 2, 2);
+                    break;
+                case 4:
+                    for (i = 0; i < frame_count; ++i)
+                        memcpy(at + i * stride, src + i * 4, 4);
+                    break;
+                case 8:
+                    for (i = 0; i < frame_count; ++i)
+                        memcpy(at + i * stride, src + i * 8, 8);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+#ifndef SIMPLE_WAVE_NO_WRITER
+    int Wave_MergeChannels(WAVE_READER* inputs, int input_count, FILE* output, uint32_t channel_mask, WAVE_ALLOCATOR* allocator)
+    {
+        if ((!inputs) || (!output) || (input_count <= 0) || (input_count > WAVE_MAX_CHANNELS))
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        WAVE_SAMPLE_FORMAT sample_format = inputs[0].sample_format;
+        uint32_t samples_per_sec = inputs[0].wave.format ? inputs[0].wave.format->samples_per_sec : 0;
+        size_t sample_size = Wave_GetSampleFormatSize(sample_format);
+        if (!sample_size)
+            return 0;
+
+        int c;
+        for (c = 0; c < input_count; ++c)
+        {
+            WAVE_READER* input = &inputs[c];
+            if ((!input->file) || (!input->wave.format) || (input->wave.format->channels != 1))
+                return 0;
+            if ((input->sample_format != sample_format) || (input->wave.format->samples_per_sec != samples_per_sec))
+                return 0;
+        }
+
+        // A block per input plus the interleaved block, memory does not grow with the length of the inputs
+        size_t block_size = WAVE_MERGE_BLOCK_FRAMES * sample_size * input_count;
+        size_t buffer_size = block_size * 2;
+        char* buffer = (char*)allocator->allocate(allocator->data, buffer_size);
+        if (!buffer)
+            return 0;
+
+        WAVE_WRITER writer;
+        memset(&writer, 0, sizeof(writer));
+        int result = Wave_WriterBeginExtensible(&writer, output, sample_format, input_count, (int)samples_per_sec, channel_mask);
+
+        const void* channels[WAVE_MAX_CHANNELS];
+        while (result)
+        {
+            size_t block_frames = 0;
+            for (c = 0; c < input_count; ++c)
+            {
+                char* block = buffer + c * WAVE_MERGE_BLOCK_FRAMES * sample_size;
+                size_t read = Wave_ReaderRead(&inputs[c], block, WAVE_MERGE_BLOCK_FRAMES);
+                memset(block + read * sample_size, (sample_format == WAVE_SAMPLE_FORMAT_U8) ? 128 : 0, (WAVE_MERGE_BLOCK_FRAMES - read) * sample_size);
+                channels[c] = block;
+
+                if (read > block_frames)
+                    block_frames = read;
+            }
+
+            if (!block_frames)
+                break;
+
+            Wave_Interleave(channels, block_frames, input_count, sample_format, buffer + block_size);
+            result = Wave_WriterWrite(&writer, buffer + block_size, block_frames);
+        }
+
+        if ((writer.file) && (!Wave_WriterEnd(&writer)))
+            result = 0;
+
+        allocator->free(allocator->data, buffer, buffer_size);
+        return result;
+    }
+#endif // SIMPLE_WAVE_NO_WRITER
+
+#if defined(__GNUC__) || defined(__clang__)
+#define WAVE_ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define WAVE_ATOMIC_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#else
+    // Volatile accesses have acquire/release semantics with MSVC on x86 and x64
+#define WAVE_ATOMIC_LOAD(ptr) (*(volatile size_t*)(ptr))
+#define WAVE_ATOMIC_STORE(ptr, value) (*(volatile size_t*)(ptr) = (value))
+#endif
+
+#ifndef SIMPLE_WAVE_NO_ALLOCATORS
+    static void* Wave_PoolAlloc(void* data, size_t size)
+    {
+        WAVE_POOL* pool = (WAVE_POOL*)data;
+        if ((size > pool->block_size) || (!pool->free_list))
+            return NULL;
+
+        void* block = pool->free_list;
+        memcpy(&pool->free_list, block, sizeof(void*));
+        return block;
+    }
+
+    static void Wave_PoolFree(void* data, void* ptr, size_t size)
+    {
+        WAVE_POOL* pool = (WAVE_POOL*)data;
+        (void)size;
+        if (!ptr)
+            return;
+
+        memcpy(ptr, &pool->free_list, sizeof(void*));
+        pool->free_list = ptr;
+    }
+
+    int Wave_PoolInit(WAVE_POOL* pool, void* memory, size_t memory_size, size_t block_size)
+    {
+        if ((!pool) || (!memory) || (!block_size))
+            return 0;
+
+        // Blocks stay 16 byte aligned so any sample format can be read in place
+        block_size = (block_size + 15) & ~(size_t)15;
+
+        memset(pool, 0, sizeof(WAVE_POOL));
+        pool->memory = (unsigned char*)memory;
+        pool->block_size = block_size;
+        pool->block_count = memory_size / block_size;
+
+        size_t i;
+        for (i = pool->block_count; i > 0; --i)
+            Wave_PoolFree(pool, pool->memory + (i - 1) * block_size, block_size);
+
+        return pool->block_count != 0;
+    }
+
+    int Wave_PoolGetAllocator(WAVE_POOL* pool, WAVE_ALLOCATOR* out_allocator)
+    {
+        if ((!pool) || (!out_allocator))
+            return 0;
+
+        out_allocator->allocate = Wave_PoolAlloc;
+        out_allocator->free = Wave_PoolFree;
+        out_allocator->data = pool;
+        return 1;
+    }
+#endif // SIMPLE_WAVE_NO_ALLOCATORS
+
+#ifndef SIMPLE_WAVE_NO_STDIO
+    int Wave_HybridOpen(WAVE_HYBRID_SAMPLE* sample, FILE* file, long size, size_t head_size, WAVE_ALLOCATOR* head_allocator, WAVE_ALLOCATOR* allocator)
+    {
+        if ((!sample) || (!file))
+            return 0;
+        if (!head_allocator)
+            head_allocator = Wave_GetDefaultAllocator();
+
+        memset(sample, 0, sizeof(WAVE_HYBRID_SAMPLE));
+        if (!Wave_LoadStreamOnlyInfo(file, size, &sample->wave, allocator))
+        {
+            Wave_Free(&sample->wave, allocator);
+            return 0;
+        }
+
+        sample->file = file;
+        sample->sample_format = Wave_GetSampleFormat(&sample->wave);
+        sample->frame_count = Wave_GetFrameCount(&sample->wave);
+
+        // The head holds whole frames only
+        size_t block_align = sample->wave.format->block_align;
+        sample->head_frames = head_size / block_align;
+        if (sample->head_frames > sample->frame_count)
+            sample->head_frames = sample->frame_count;
+        if (!sample->head_frames)
+            return 1;
+
+        sample->head_size = sample->head_frames * block_align;
+        sample->head = head_allocator->allocate(head_allocator->data, sample->head_size);
+        if (!sample->head)
+        {
+            Wave_Free(&sample->wave, allocator);
+            return 0;
+        }
+
+        if ((!Wave_Seek(file, (uint64_t)sample->wave.sample_data_offset)) || (fread(sample->head, 1, sample->head_size, file) != sample->head_size))
+        {
+            Wave_HybridClose(sample, head_allocator, allocator);
+            return 0;
+        }
+
+        return 1;
+    }
+
+    int Wave_HybridClose(WAVE_HYBRID_SAMPLE* sample, WAVE_ALLOCATOR* head_allocator, WAVE_ALLOCATOR* allocator)
+    {
+        if (!sample)
+            return 0;
+        if (!head_allocator)
+            head_allocator = Wave_GetDefaultAllocator();
+
+        if (sample->head)
+            head_allocator->free(head_allocator->data, sample->head, sample->head_size);
+
+        sample->head = NULL;
+        sample->head_size = 0;
+        sample->head_frames = 0;
+        sample->file = NULL;
+        return Wave_Free(&sample->wave, allocator);
+    }
+
+    int Wave_HybridVoiceStart(WAVE_HYBRID_VOICE* voice, WAVE_HYBRID_SAMPLE* sample, void* ring_memory, size_t ring_frames)
+    {
+        if ((!voice) || (!sample) || (!sample->wave.format))
+            return 0;
+        if ((sample->frame_count > sample->head_frames) && ((!ring_memory) || (!ring_frames)))
+            return 0;
+
+        memset(voice, 0, sizeof(WAVE_HYBRID_VOICE));
+        voice->sample = sample;
+        voice->ring = (unsigned char*)ring_memory;
+        voice->ring_frames = ring_frames;
+        return 1;
+    }
+
+    int Wave_HybridVoiceGetRefill(WAVE_HYBRID_VOICE* voice, uint64_t* out_offset, size_t* out_frame_count)
+    {
+        if ((!voice) || (!voice->sample))
+            return 0;
+
+        WAVE_HYBRID_SAMPLE* sample = voice->sample;
+        size_t write = voice->ring_write;
+        size_t read = WAVE_ATOMIC_LOAD(&voice->ring_read);
+        size_t tail_frames = sample->frame_count - sample->head_frames;
+
+        size_t count = voice->ring_frames - (write - read);
+        if (count > tail_frames - write)
+            count = tail_frames - write;
+
+        if (out_offset)
+            *out_offset = (uint64_t)sample->wave.sample_data_offset + (uint64_t)(sample->head_frames + write) * sample->wave.format->block_align;
+        if (out_frame_count)
+            *out_frame_count = count;
+        return 1;
+    }
+
+    // Copies into the ring at the write counter, the free space may wrap around its end
+    static void Wave_HybridVoiceCopyToRing(WAVE_HYBRID_VOICE* voice, const unsigned char* src, size_t frame_count)
+    {
+        size_t block_align = voice->sample->wave.format->block_align;
+        size_t done = 0;
+        while (done < frame_count)
+        {
+            size_t at = (voice->ring_write + done) % voice->ring_frames;
+            size_t span = voice->ring_frames - at;
+            if (span > frame_count - done)
+                span = frame_count - done;
+
+            memcpy(voice->ring + at * block_align, src + done * block_align, span * block_align);
+            done += span;
+        }
+    }
+
+    int Wave_HybridVoiceCommitRefill(WAVE_HYBRID_VOICE* voice, const void* frames, size_t frame_count)
+    {
+        if ((!voice) || (!voice->sample))
+            return 0;
+        if ((frame_count) && (!frames))
+            return 0;
+
+        size_t free_frames;
+        if ((!Wave_HybridVoiceGetRefill(voice, NULL, &free_frames)) || (frame_count > free_frames))
+            return 0;
+
+        Wave_HybridVoiceCopyToRing(voice, (const unsigned char*)frames, frame_count);
+        WAVE_ATOMIC_STORE(&voice->ring_write, voice->ring_write + frame_count);
+        return 1;
+    }
+
+    size_t Wave_HybridVoiceService(WAVE_HYBRID_VOICE* voice)
+    {
+        uint64_t offset;
+        size_t count;
+        if ((!Wave_HybridVoiceGetRefill(voice, &offset, &count)) || (!count))
+            return 0;
+
+        WAVE_HYBRID_SAMPLE* sample = voice->sample;
+        size_t block_align = sample->wave.format->block_align;
+        size_t write = voice->ring_write;
+        if (!Wave_Seek(sample->file, offset))
+            return 0;
+
+        // Read straight into the ring, in two pieces when the free space wraps
+        size_t fetched = 0;
+        while (fetched < count)
+        {
+            size_t at = (write + fetched) % voice->ring_frames;
+            size_t span = voice->ring_frames - at;
+            if (span > count - fetched)
+                span = count - fetched;
+
+            size_t got = fread(voice->ring + at * block_align, block_align, span, sample->file);
+            fetched += got;
+            if (got < span)
+                break;
+        }
+
+        WAVE_ATOMIC_STORE(&voice->ring_write, write + fetched);
+        return fetched;
+    }
+
+    size_t Wave_HybridVoiceRead(WAVE_HYBRID_VOICE* voice, void* out_frames, size_t frame_count)
+    {
+        if ((!voice) || (!voice->sample) || (!out_frames))
+            return 0;
+
+        WAVE_HYBRID_SAMPLE* sample = voice->sample;
+        size_t block_align = sample->wave.format->block_align;
+        unsigned char* dst = (unsigned char*)out_frames;
+        size_t total = 0;
+
+        if (frame_count > sample->frame_count - voice->position)
+            frame_count = sample->frame_count - voice->position;
+
+        // Head first, straight from memory
+        if (voice->position < sample->head_frames)
+        {
+            size_t count = sample->head_frames - voice->position;
+            if (count > frame_count)
+                count = frame_count;
+
+            memcpy(dst, (unsigned char*)sample->head + voice->position * block_align, count * block_align);
+            WAVE_ATOMIC_STORE(&voice->position, voice->position + count);
+            total += count;
+        }
+
+        // Then whatever the I/O thread already fetched
+        if (total < frame_count)
+        {
+            size_t read = voice->ring_read;
+            size_t available = WAVE_ATOMIC_LOAD(&voice->ring_write) - read;
+            size_t count = frame_count - total;
+            if (count > available)
+            {
+                count = available;
+                voice->underruns++;
+            }
+
+            size_t done = 0;
+            while (done < count)
+            {
+                size_t at = (read + done) % voice->ring_frames;
+                size_t span = voice->ring_frames - at;
+                if (span > count - done)
+                    span = count - done;
+
+                memcpy(dst + (total + done) * block_align, voice->ring + at * block_align, span * block_align);
+                done += span;
+            }
+
+            WAVE_ATOMIC_STORE(&voice->ring_read, read + count);
+            WAVE_ATOMIC_STORE(&voice->position, voice->position + count);
+            total += count;
+        }
+
+        return total;
+    }
+
+    size_t Wave_HybridVoiceReadFloat(WAVE_HYBRID_VOICE* voice, float* out_frames, size_t frame_count)
+    {
+        if ((!voice) || (!voice->sample) || (!out_frames))
+            return 0;
+
+        double temp[1024];
+        size_t channels = voice->sample->wave.format->channels;
+        size_t chunk_frames = sizeof(temp) / voice->sample->wave.format->block_align;
+        size_t total = 0;
+        if (!chunk_frames)
+            return 0;
+
+        while (frame_count)
+        {
+            size_t count = (frame_count < chunk_frames) ? frame_count : chunk_frames;
+            size_t read = Wave_HybridVoiceRead(voice, temp, count);
+            Wave_ConvertToFloat(temp, voice->sample->sample_format, read * channels, out_frames + total * channels);
+
+            total += read;
+            frame_count -= read;
+            if (read < count)
+                break;
+        }
+
+        return total;
+    }
+
+    size_t Wave_HybridVoiceGetBufferedFrames(WAVE_HYBRID_VOICE* voice)
+    {
+        if ((!voice) || (!voice->sample))
+            return 0;
+
+        size_t position = WAVE_ATOMIC_LOAD(&voice->position);
+        size_t head = (position < voice->sample->head_frames) ? voice->sample->head_frames - position : 0;
+        return head + (WAVE_ATOMIC_LOAD(&voice->ring_write) - WAVE_ATOMIC_LOAD(&voice->ring_read));
+    }
+
+    int Wave_SchedulerInit(WAVE_STREAM_SCHEDULER* scheduler, WAVE_STREAM_REQUEST* requests, size_t request_capacity, void* buffer, size_t buffer_size, size_t urgent_frames, size_t min_request_frames)
+    {
+        if ((!scheduler) || (!requests) || (!request_capacity) || (!buffer) || (!buffer_size))
+            return 0;
+
+        memset(scheduler, 0, sizeof(WAVE_STREAM_SCHEDULER));
+        scheduler->requests = requests;
+        scheduler->request_capacity = request_capacity;
+        scheduler->buffer = (unsigned char*)buffer;
+        scheduler->buffer_size = buffer_size;
+        scheduler->urgent_frames = urgent_frames;
+        scheduler->min_request_frames = min_request_frames;
+        scheduler->max_gap = 64 * 1024;
+        return 1;
+    }
+
+    int Wave_SchedulerSubmit(WAVE_STREAM_SCHEDULER* scheduler, WAVE_HYBRID_VOICE* voice)
+    {
+        if ((!scheduler) || (!voice) || (!voice->sample))
+            return 0;
+        if (scheduler->request_count >= scheduler->request_capacity)
+            return 0;
+
+        // Two requests of one voice would both append at its write counter
+        size_t i;
+        for (i = 0; i < scheduler->request_count; ++i)
+            if (scheduler->requests[i].voice == voice)
+                return 0;
+
+        WAVE_STREAM_REQUEST request;
+        size_t frame_count;
+        if (!Wave_HybridVoiceGetRefill(voice, &request.offset, &frame_count))
+            return 0;
+        if (!frame_count)
+            return 1;
+
+        request.voice = voice;
+        request.file = voice->sample->file;
+        request.deadline = Wave_HybridVoiceGetBufferedFrames(voice);
+        request.urgent = request.deadline < scheduler->urgent_frames;
+
+        // Small refills are left for later so reads stay large, unless the voice is about to run dry
+        if ((!request.urgent) && (frame_count < scheduler->min_request_frames))
+            return 1;
+
+        size_t block_align = voice->sample->wave.format->block_align;
+        if (frame_count > scheduler->buffer_size / block_align)
+            frame_count = scheduler->buffer_size / block_align;
+        if (!frame_count)
+            return 0;
+
+        request.size = frame_count * block_align;
+        scheduler->requests[scheduler->request_count++] = request;
+        return 1;
+    }
+
+    static int Wave_CompareStreamRequests(const void* left, const void* right)
+    {
+        const WAVE_STREAM_REQUEST* a = (const WAVE_STREAM_REQUEST*)left;
+        const WAVE_STREAM_REQUEST* b = (const WAVE_STREAM_REQUEST*)right;
+
+        if (a->urgent != b->urgent)
+            return a->urgent ? -1 : 1;
+        if ((a->urgent) && (a->deadline != b->deadline))
+            return (a->deadline < b->deadline) ? -1 : 1;
+        if (a->file != b->file)
+            return ((uintptr_t)a->file < (uintptr_t)b->file) ? -1 : 1;
+        if (a->offset != b->offset)
+            return (a->offset < b->offset) ? -1 : 1;
+        return 0;
+    }
+
+    size_t Wave_SchedulerService(WAVE_STREAM_SCHEDULER* scheduler)
+    {
+        if (!scheduler)
+            return 0;
+
+        WAVE_STREAM_REQUEST* requests = scheduler->requests;
+        size_t count = scheduler->request_count;
+        size_t delivered = 0;
+        qsort(requests, count, sizeof(WAVE_STREAM_REQUEST), Wave_CompareStreamRequests);
+
+        size_t i = 0;
+        while (i < count)
+        {
+            // Grow the batch while the next request is in the same file, close enough and fits the staging buffer
+            uint64_t start = requests[i].offset;
+            uint64_t end = start + requests[i].size;
+            size_t last = i + 1;
+            while (last < count)
+            {
+                WAVE_STREAM_REQUEST* next = &requests[last];
+                uint64_t next_end = next->offset + next->size;
+                if ((next->file != requests[i].file) || (next->urgent != requests[i].urgent))
+                    break;
+                if ((next->offset < start) || (next->offset > end + scheduler->max_gap))
+                    break;
+                if (((next_end > end) ? next_end : end) - start > scheduler->buffer_size)
+                    break;
+
+                if (next_end > end)
+                    end = next_end;
+                last++;
+            }
+
+            size_t got = 0;
+            if (Wave_Seek(requests[i].file, start))
+                got = fread(scheduler->buffer, 1, (size_t)(end - start), requests[i].file);
+
+            // Hand every voice its part, overlapping requests (e.g. two voices of one sample) share the read
+            size_t k;
+            for (k = i; k < last; ++k)
+            {
+                WAVE_STREAM_REQUEST* request = &requests[k];
+                size_t block_align = request->voice->sample->wave.format->block_align;
+                size_t at = (size_t)(request->offset - start);
+                size_t available = (got > at) ? got - at : 0;
+                if (available > request->size)
+                    available = request->size;
+
+                // A request that no longer starts at the next missing frame of its voice is stale and dropped
+                uint64_t expected;
+                if ((!Wave_HybridVoiceGetRefill(request->voice, &expected, NULL)) || (expected != request->offset))
+                    continue;
+
+                size_t frames = available / block_align;
+                if ((frames) && (Wave_HybridVoiceCommitRefill(request->voice, scheduler->buffer + at, frames)))
+                    delivered += frames;
+            }
+
+            i = last;
+        }
+
+        scheduler->request_count = 0;
+        return delivered;
+    }
+#endif // SIMPLE_WAVE_NO_STDIO
+
+#if defined(__GNUC__) || defined(__clang__)
+#define WAVE_PREFETCH(ptr) __builtin_prefetch((ptr), 0, 3)
+#else
+#define WAVE_PREFETCH(ptr) ((void)(ptr))
+#endif
+
+    size_t Wave_ParseBuffers(const WAVE_BUFFER* buffers, size_t count, WAVE* out_waves, int* out_results)
+    {
+        if ((!buffers) || (!out_waves))
+            return 0;
+
+        size_t parsed = 0;
+        size_t i;
+        for (i = 0; i < count; ++i)
+        {
+            // The canonical header and format fit in the first two cache lines
+            if (i + WAVE_PARSE_PREFETCH_DISTANCE < count)
+            {
+                const char* ahead = (const char*)buffers[i + WAVE_PARSE_PREFETCH_DISTANCE].data;
+                if (ahead)
+                {
+                    WAVE_PREFETCH(ahead);
+                    WAVE_PREFETCH(ahead + 64);
+                }
+            }
+
+            int result = Wave_ParseBuffer(buffers[i].data, buffers[i].size, &out_waves[i]);
+            if (out_results)
+                out_results[i] = result;
+            parsed += result ? 1 : 0;
+        }
+
+        return parsed;
+    }
+
+    int Wave_GetDesc(WAVE* wave, WAVE_DESC* out_desc)
+    {
+        if ((!wave) || (!out_desc) || (!wave->header) || (!wave->format) || (!wave->format_chunk))
+            return 0;
+
+        // Waves read from a stream locate their chunks in the file, the description locates them in the wav
+        uint64_t base = wave->header_offset;
+
+        memset(out_desc, 0, sizeof(WAVE_DESC));
+        out_desc->magic = WAVE_DESC_MAGIC;
+        out_desc->format_chunk_size = wave->format_chunk->size;
+        out_desc->riff_size = (uint64_t)wave->header->size + sizeof(RIFF_CHUNK);
+        out_desc->format_chunk_offset = wave->format_chunk_offset - base;
+        if (wave->data_chunk)
+        {
+            out_desc->data_chunk_offset = wave->data_chunk_offset - base;
+            out_desc->data_chunk_size = wave->data_chunk->size;
+            out_desc->sample_data_offset = wave->sample_data_offset - base;
+            out_desc->sample_data_size = wave->sample_data_size;
+        }
+        out_desc->checksum_chunk_offset = wave->checksum_chunk ? wave->checksum_chunk_offset - base : 0;
+        out_desc->format = *wave->format;
+        return 1;
+    }
+
+    // A chunk of the given id must fit, header and payload, in the buffer
+    static RIFF_CHUNK* Wave_BindChunk(char* buff, size_t size, uint64_t offset, uint32_t id)
+    {
+        if ((offset > size) || (size - offset < sizeof(RIFF_CHUNK)))
+            return NULL;
+
+        RIFF_CHUNK* chunk = (RIFF_CHUNK*)(buff + offset);
+        if ((chunk->id != id) || (offset + sizeof(RIFF_CHUNK) + chunk->size > size))
+            return NULL;
+
+        return chunk;
+    }
+
+    int Wave_BindDesc(const WAVE_DESC* desc, void* buff, size_t size, WAVE* out_wave)
+    {
+        if ((!desc) || (!buff) || (!out_wave))
+            return 0;
+        if (desc->magic != WAVE_DESC_MAGIC)
+            return 0;
+
+        memset(out_wave, 0, sizeof(WAVE));
+        if (size < sizeof(RIFF_HEADER))
+            return 0;
+
+        char* at = (char*)buff;
+        out_wave->header = (RIFF_HEADER*)at;
+        if ((!Wave_ValidateHeader(out_wave->header)) || ((uint64_t)out_wave->header->size + sizeof(RIFF_CHUNK) != desc->riff_size))
+            return 0;
+
+        out_wave->format_chunk = Wave_BindChunk(at, size, desc->format_chunk_offset, WAVE_CHUNK_FORMAT);
+        if ((!out_wave->format_chunk) || (out_wave->format_chunk->size != desc->format_chunk_size))
+            return 0;
+        out_wave->format_chunk_offset = (size_t)desc->format_chunk_offset;
+        out_wave->format = (WAVE_FORMAT*)(out_wave->format_chunk + 1);
+
+        if (desc->data_chunk_offset)
+        {
+            // Only the samples the file held when it was described must be there, the size field may claim more
+            if ((desc->data_chunk_offset > size) || (size - desc->data_chunk_offset < sizeof(RIFF_CHUNK)))
+                return 0;
+            if ((desc->sample_data_offset != desc->data_chunk_offset + sizeof(RIFF_CHUNK)) || (desc->sample_data_size > size - desc->sample_data_offset))
+                return 0;
+
+            out_wave->data_chunk = (RIFF_CHUNK*)(at + desc->data_chunk_offset);
+            if ((out_wave->data_chunk->id != WAVE_CHUNK_DATA) || (out_wave->data_chunk->size != desc->data_chunk_size))
+                return 0;
+            out_wave->data_chunk_offset = (size_t)desc->data_chunk_offset;
+            out_wave->sample_data = (void*)(out_wave->data_chunk + 1);
+            out_wave->sample_data_size = (size_t)desc->sample_data_size;
+            out_wave->sample_data_offset = (size_t)desc->sample_data_offset;
+        }
+
+        if (desc->checksum_chunk_offset)
+        {
+            out_wave->checksum_chunk = Wave_BindChunk(at, size, desc->checksum_chunk_offset, WAVE_CHUNK_CHECKSUM);
+            if (!out_wave->checksum_chunk)
+                return 0;
+            out_wave->checksum_chunk_offset = (size_t)desc->checksum_chunk_offset;
+        }
+
+        return Wave_ValidateFormat(out_wave);
+    }
+
+    RIFF_HEADER* Wave_GetHeaderAt(const WAVE* wave, void* base)
+    {
+        if ((!wave) || (!base))
+            return NULL;
+
+        return (RIFF_HEADER*)base;
+    }
+
+    RIFF_CHUNK* Wave_GetFormatChunkAt(const WAVE* wave, void* base)
+    {
+        if ((!wave) || (!base) || (!wave->format_chunk_offset))
+            return NULL;
+
+        return (RIFF_CHUNK*)((char*)base + wave->format_chunk_offset);
+    }
+
+    RIFF_CHUNK* Wave_GetDataChunkAt(const WAVE* wave, void* base)
+    {
+        if ((!wave) || (!base) || (!wave->data_chunk_offset))
+            return NULL;
+
+        return (RIFF_CHUNK*)((char*)base + wave->data_chunk_offset);
+    }
+
+    WAVE_FORMAT* Wave_GetFormatAt(const WAVE* wave, void* base)
+    {
+        RIFF_CHUNK* chunk = Wave_GetFormatChunkAt(wave, base);
+        return chunk ? (WAVE_FORMAT*)(chunk + 1) : NULL;
+    }
+
+    void* Wave_GetSampleDataAt(const WAVE* wave, void* base)
+    {
+        if ((!wave) || (!base) || (!wave->sample_data_offset))
+            return NULL;
+
+        return (char*)base + wave->sample_data_offset;
+    }
+
+    int Wave_Relocate(WAVE* wave, void* base)
+    {
+        if ((!wave) || (!base) || (!wave->format_chunk_offset) || (wave->info_only))
+            return 0;
+
+        if (wave->free_ptr == (void*)wave->header)
+            wave->free_ptr = base;
+
+        wave->header = Wave_GetHeaderAt(wave, base);
+        wave->format_chunk = Wave_GetFormatChunkAt(wave, base);
+        wave->format = Wave_GetFormatAt(wave, base);
+        wave->data_chunk = Wave_GetDataChunkAt(wave, base);
+        wave->sample_data = wave->data_chunk ? Wave_GetSampleDataAt(wave, base) : NULL;
+        wave->checksum_chunk = wave->checksum_chunk_offset ? (RIFF_CHUNK*)((char*)base + wave->checksum_chunk_offset) : NULL;
+        return 1;
+    }
+
+    int Wave_ViewInit(WAVE_FLOAT_VIEW* view, WAVE* wave, size_t page_frames, size_t cache_pages, WAVE_ALLOCATOR* allocator)
+    {
+        if ((!view) || (!wave) || (!wave->sample_data) || (!wave->format) || (!page_frames) || (!cache_pages))
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        memset(view, 0, sizeof(WAVE_FLOAT_VIEW));
+        view->wave = wave;
+        view->page_frames = page_frames;
+        view->slot_count = cache_pages;
+
+        // Pages first so they keep the alignment of the allocation
+        size_t pages_size = cache_pages * page_frames * wave->format->channels * sizeof(float);
+        view->free_ptr_size = pages_size + cache_pages * sizeof(size_t) * 2;
+        view->free_ptr = allocator->allocate(allocator->data, view->free_ptr_size);
+        if (!view->free_ptr)
+            return 0;
+
+        view->pages = (float*)view->free_ptr;
+        view->slot_pages = (size_t*)((char*)view->free_ptr + pages_size);
+        view->slot_uses = view->slot_pages + cache_pages;
+
+        size_t i;
+        for (i = 0; i < cache_pages; ++i)
+        {
+            view->slot_pages[i] = (size_t)-1;
+            view->slot_uses[i] = 0;
+        }
+
+        return 1;
+    }
+
+    const float* Wave_ViewGetPage(WAVE_FLOAT_VIEW* view, size_t page, size_t* out_frame_count)
+    {
+        if ((!view) || (!view->free_ptr))
+            return NULL;
+
+        size_t total = Wave_GetFrameCount(view->wave);
+        size_t first_frame = page * view->page_frames;
+        if ((page >= (size_t)-1 / view->page_frames) || (first_frame >= total))
+            return NULL;
+
+        size_t frame_count = total - first_frame;
+        if (frame_count > view->page_frames)
+            frame_count = view->page_frames;
+        if (out_frame_count)
+            *out_frame_count = frame_count;
+
+        // Hit, or the least recently used slot
+        size_t page_size = view->page_frames * view->wave->format->channels;
+        size_t victim = 0;
+        size_t i;
+        for (i = 0; i < view->slot_count; ++i)
+        {
+            if (view->slot_pages[i] == page)
+            {
+                view->slot_uses[i] = ++view->clock;
+                return view->pages + i * page_size;
+            }
+            if (view->slot_uses[i] < view->slot_uses[victim])
+                victim = i;
+        }
+
+        float* frames = view->pages + victim * page_size;
+        Wave_ReadFramesFloat(view->wave, first_frame, frame_count, frames);
+        view->slot_pages[victim] = page;
+        view->slot_uses[victim] = ++view->clock;
+        return frames;
+    }
+
+    const float* Wave_ViewGetFrames(WAVE_FLOAT_VIEW* view, size_t frame, size_t* out_frame_count)
+    {
+        if ((!view) || (!view->free_ptr))
+            return NULL;
+
+        size_t page_frame_count;
+        size_t offset = frame % view->page_frames;
+        const float* page = Wave_ViewGetPage(view, frame / view->page_frames, &page_frame_count);
+        if ((!page) || (offset >= page_frame_count))
+            return NULL;
+
+        if (out_frame_count)
+            *out_frame_count = page_frame_count - offset;
+        return page + offset * view->wave->format->channels;
+    }
+
+    int Wave_ViewFree(WAVE_FLOAT_VIEW* view, WAVE_ALLOCATOR* allocator)
+    {
+        if (!view)
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        if (view->free_ptr)
+        {
+            allocator->free(allocator->data, view->free_ptr, view->free_ptr_size);
+            view->free_ptr = NULL;
+            view->free_ptr_size = 0;
+            return 1;
+        }
+
+        return 0;
+    }
+
+#ifndef SIMPLE_WAVE_NO_ALLOCATORS
+#ifdef WAVE_HAS_NUMA
+#define WAVE_NUMA_MAX_NODES 64
+#define WAVE_NUMA_MAX_CPUS 1024
+#define WAVE_MPOL_BIND 2
+#define WAVE_MPOL_INTERLEAVE 3
+#define WAVE_MPOL_F_NODE 1
+#define WAVE_MPOL_F_ADDR 2
+
+    // Reads a sysfs list such as "0-3,8-11" into a bit mask
+    static int Wave_NumaReadList(const char* path, unsigned long* mask, size_t bit_count)
+    {
+        FILE* file = fopen(path, "r");
+        if (!file)
+            return 0;
+
+        char text[1024];
+        size_t size = fread(text, 1, sizeof(text) - 1, file);
+        fclose(file);
+        text[size] = 0;
+
+        size_t bits_per_word = sizeof(unsigned long) * 8;
+        memset(mask, 0, bit_count / 8);
+
+        char* at = text;
+        while ((*at >= '0') && (*at <= '9'))
+        {
+            unsigned long first = strtoul(at, &at, 10);
+            unsigned long last = first;
+            if (*at == '-')
+                last = strtoul(at + 1, &at, 10);
+
+            unsigned long i;
+            for (i = first; (i <= last) && (i < bit_count); ++i)
+                mask[i / bits_per_word] |= 1ul << (i % bits_per_word);
+
+            if (*at == ',')
+                at++;
+        }
+
+        return 1;
+    }
+
+    static void* Wave_NumaAlloc(void* data, size_t size)
+    {
+        WAVE_NUMA_POLICY* policy = (WAVE_NUMA_POLICY*)data;
+        void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+            return NULL;
+
+        // Pages are only placed when first touched, the policy must be set before that
+        unsigned long nodes[WAVE_NUMA_MAX_NODES / (sizeof(unsigned long) * 8)];
+        int mode = WAVE_MPOL_BIND;
+        if ((policy->node < 0) || (policy->node >= WAVE_NUMA_MAX_NODES))
+        {
+            if (!Wave_NumaReadList("/sys/devices/system/node/online", nodes, WAVE_NUMA_MAX_NODES))
+                return ptr;
+            mode = WAVE_MPOL_INTERLEAVE;
+        }
+        else
+        {
+            memset(nodes, 0, sizeof(nodes));
+            nodes[policy->node / (sizeof(unsigned long) * 8)] = 1ul << (policy->node % (sizeof(unsigned long) * 8));
+        }
+
+        // A failed policy still leaves usable memory, placed by the kernel default
+        syscall(SYS_mbind, ptr, size, mode, nodes, (unsigned long)WAVE_NUMA_MAX_NODES + 1, 0);
+        return ptr;
+    }
+
+    static void Wave_NumaFree(void* data, void* ptr, size_t size)
+    {
+        (void)data;
+        if (ptr)
+            munmap(ptr, size);
+    }
+#endif
+
+    int Wave_NumaGetNodeCount(void)
+    {
+#ifdef WAVE_HAS_NUMA
+        unsigned long nodes[WAVE_NUMA_MAX_NODES / (sizeof(unsigned long) * 8)];
+        if (!Wave_NumaReadList("/sys/devices/system/node/online", nodes, WAVE_NUMA_MAX_NODES))
+            return 1;
+
+        int count = 0;
+        int i;
+        for (i = 0; i < WAVE_NUMA_MAX_NODES; ++i)
+            count += (nodes[i / (sizeof(unsigned long) * 8)] >> (i % (sizeof(unsigned long) * 8))) & 1;
+        return count ? count : 1;
+#else
+        return 1;
+#endif
+    }
+
+    int Wave_NumaGetAllocator(WAVE_NUMA_POLICY* policy, int node, WAVE_ALLOCATOR* out_allocator)
+    {
+        if ((!policy) || (!out_allocator))
+            return 0;
+
+        policy->node = node;
+#ifdef WAVE_HAS_NUMA
+        out_allocator->allocate = Wave_NumaAlloc;
+        out_allocator->free = Wave_NumaFree;
+        out_allocator->data = policy;
+#else
+        *out_allocator = *Wave_GetDefaultAllocator();
+#endif
+        return 1;
+    }
+
+    int Wave_NumaGetNodeOfAddress(const void* ptr)
+    {
+#ifdef WAVE_HAS_NUMA
+        int node = -1;
+        if (syscall(SYS_get_mempolicy, &node, NULL, 0, ptr, WAVE_MPOL_F_NODE | WAVE_MPOL_F_ADDR) != 0)
+            return -1;
+        return node;
+#else
+        (void)ptr;
+        return -1;
+#endif
+    }
+
+    int Wave_NumaGetNodeOfFrame(WAVE* wave, size_t frame)
+    {
+        if ((!wave) || (!wave->sample_data) || (frame >= Wave_GetFrameCount(wave)))
+            return -1;
+
+        return Wave_NumaGetNodeOfAddress((const char*)wave->sample_data + frame * wave->format->block_align);
+    }
+
+    int Wave_NumaBindThread(int node)
+    {
+#ifdef WAVE_HAS_NUMA
+        if ((node < 0) || (node >= WAVE_NUMA_MAX_NODES))
+            return 0;
+
+        char path[64];
+        unsigned long cpus[WAVE_NUMA_MAX_CPUS / (sizeof(unsigned long) * 8)];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        if (!Wave_NumaReadList(path, cpus, WAVE_NUMA_MAX_CPUS))
+            return 0;
+
+        return syscall(SYS_sched_setaffinity, 0, sizeof(cpus), cpus) == 0;
+#else
+        (void)node;
+        return 0;
+#endif
+    }
+#endif // SIMPLE_WAVE_NO_ALLOCATORS
+
+
+#ifndef SIMPLE_WAVE_NO_STDIO
+    // Consumes size bytes of a stream that cannot seek
+    static int Wave_PipeSkip(FILE* file, uint64_t size)
+    {
+        unsigned char temp[4096];
+        while (size)
+        {
+            size_t count = (size < sizeof(temp)) ? (size_t)size : sizeof(temp);
+            if (fread(temp, 1, count, file) != count)
+                return 0;
+            size -= count;
+        }
+
+        return 1;
+    }
+
+    int Wave_PipeOpen(WAVE_PIPE* pipe, FILE* file, WAVE_ALLOCATOR* allocator)
+    {
+        if ((!pipe) || (!file))
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        memset(pipe, 0, sizeof(WAVE_PIPE));
+        WAVE* wave = &pipe->wave;
+        wave->info_only = 1;
+
+        // Same layout as Wave_LoadStreamOnlyInfo
+        wave->free_ptr_size = sizeof(RIFF_HEADER) + sizeof(RIFF_CHUNK) * 3 + sizeof(WAVE_FORMAT_EXTENSIBLE) + sizeof(WAVE_CHECKSUM);
+        wave->free_ptr = allocator->allocate(allocator->data, wave->free_ptr_size);
+        if (!wave->free_ptr)
+        {
+            wave->free_ptr_size = 0;
+            return 0;
+        }
+
+        // The RIFF size only tells an empty data chunk from an unset one, live recorders leave it unset like the data size
+        wave->header = (RIFF_HEADER*)wave->free_ptr;
+        if ((fread(wave->header, sizeof(RIFF_HEADER), 1, file) != 1) || (!Wave_ValidateHeader(wave->header)))
+        {
+            Wave_Free(wave, allocator);
+            return 0;
+        }
+
+        size_t offset = sizeof(RIFF_HEADER);
+        RIFF_CHUNK chunk;
+        while (fread(&chunk, sizeof(RIFF_CHUNK), 1, file) == 1)
+        {
+            offset += sizeof(RIFF_CHUNK);
+            uint64_t skip = chunk.size;
+
+            if (chunk.id == WAVE_CHUNK_DATA)
+            {
+                wave->data_chunk = (RIFF_CHUNK*)(wave->header + 1);
+                memcpy(wave->data_chunk, &chunk, sizeof(RIFF_CHUNK));
+                wave->data_chunk_offset = offset - sizeof(RIFF_CHUNK);
+                wave->sample_data_offset = offset;
+
+                // The size is unknown until the end of the stream, a 0 size in a sized RIFF is an empty data chunk
+                int riff_unset = (wave->header->size == 0) || (wave->header->size == 0xFFFFFFFF);
+                if ((chunk.size == 0xFFFFFFFF) || ((chunk.size == 0) && (riff_unset)))
+                    pipe->unbounded = 1;
+                else
+                    wave->sample_data_size = chunk.size;
+                pipe->data_remaining = chunk.size;
+                break;
+            }
+            else if (chunk.id == WAVE_CHUNK_FORMAT)
+            {
+                wave->format_chunk = (RIFF_CHUNK*)((char*)(wave->header + 1) + sizeof(RIFF_CHUNK));
+                memcpy(wave->format_chunk, &chunk, sizeof(RIFF_CHUNK));
+                wave->format_chunk_offset = offset - sizeof(RIFF_CHUNK);
+                wave->format = (WAVE_FORMAT*)((char*)(wave->header + 1) + sizeof(RIFF_CHUNK) * 2);
+
+                // Only the known part of the format is kept, the rest is skipped
+                size_t format_size = (chunk.size < sizeof(WAVE_FORMAT_EXTENSIBLE)) ? chunk.size : sizeof(WAVE_FORMAT_EXTENSIBLE);
+                memset(wave->format, 0, sizeof(WAVE_FORMAT_EXTENSIBLE));
+                if (fread(wave->format, 1, format_size, file) != format_size)
+                    break;
+                skip -= format_size;
+            }
+            else if ((chunk.id == WAVE_CHUNK_CHECKSUM) && (chunk.size >= sizeof(WAVE_CHECKSUM)))
+            {
+                wave->checksum_chunk = (RIFF_CHUNK*)((char*)(wave->header + 1) + sizeof(RIFF_CHUNK) * 2 + sizeof(WAVE_FORMAT_EXTENSIBLE));
+                memcpy(wave->checksum_chunk, &chunk, sizeof(RIFF_CHUNK));
+                wave->checksum_chunk_offset = offset - sizeof(RIFF_CHUNK);
+                if (fread(wave->checksum_chunk + 1, 1, sizeof(WAVE_CHECKSUM), file) != sizeof(WAVE_CHECKSUM))
+                    break;
+                skip -= sizeof(WAVE_CHECKSUM);
+            }
+
+            // If the size is odd round it
+            skip += chunk.size & 1;
+            if (!Wave_PipeSkip(file, skip))
+                break;
+            offset += (size_t)((uint64_t)chunk.size + (chunk.size & 1));
+        }
+
+        if ((!wave->data_chunk) || (!Wave_ValidateFormat(wave)))
+        {
+            Wave_Free(wave, allocator);
+            return 0;
+        }
+
+        pipe->file = file;
+        pipe->sample_format = Wave_GetSampleFormat(wave);
+        return 1;
+    }
+
+    size_t Wave_PipeRead(WAVE_PIPE* pipe, void* out_frames, size_t frame_count)
+    {
+        if ((!pipe) || (!pipe->file) || (!out_frames))
+            return 0;
+
+        size_t block_align = pipe->wave.format->block_align;
+        if ((!pipe->unbounded) && (frame_count > pipe->data_remaining / block_align))
+            frame_count = (size_t)(pipe->data_remaining / block_align);
+
+        // A frame cut by the end of the stream is dropped
+        size_t read = fread(out_frames, block_align, frame_count, pipe->file);
+        if (!pipe->unbounded)
+            pipe->data_remaining -= read * block_align;
+
+        pipe->frame_position += read;
+        return read;
+    }
+
+    size_t Wave_PipeReadFloat(WAVE_PIPE* pipe, float* out_frames, size_t frame_count)
+    {
+        if ((!pipe) || (!pipe->file) || (!out_frames))
+            return 0;
+
+        double temp[1024];
+        size_t channels = pipe->wave.format->channels;
+        size_t chunk_frames = sizeof(temp) / pipe->wave.format->block_align;
+        size_t total = 0;
+        if (!chunk_frames)
+            return 0;
+
+        while (frame_count)
+        {
+            size_t count = (frame_count < chunk_frames) ? frame_count : chunk_frames;
+            size_t read = Wave_PipeRead(pipe, temp, count);
+            Wave_ConvertToFloat(temp, pipe->sample_format, read * channels, out_frames + total * channels);
+
+            total += read;
+            frame_count -= read;
+            if (read < count)
+                break;
+        }
+
+        return total;
+    }
+
+    int Wave_PipeClose(WAVE_PIPE* pipe, WAVE_ALLOCATOR* allocator)
+    {
+        if (!pipe)
+            return 0;
+
+        pipe->file = NULL;
+        return Wave_Free(&pipe->wave, allocator);
+    }
+
+
+    int Wave_TailOpen(WAVE_TAIL* tail, const char* path, WAVE_ALLOCATOR* allocator)
+    {
+        if ((!tail) || (!path))
+            return 0;
+
+        memset(tail, 0, sizeof(WAVE_TAIL));
+        tail->notify_fd = -1;
+
+        tail->file = fopen(path, "rb");
+        if (!tail->file)
+            return 0;
+
+        fseek(tail->file, 0, SEEK_END);
+        long size = ftell(tail->file);
+        fseek(tail->file, 0, SEEK_SET);
+
+        // The data size is recomputed on every update
+        if ((!Wave_LoadStreamOnlyInfo(tail->file, size, &tail->wave, allocator)) || (!tail->wave.data_chunk))
+        {
+            Wave_Free(&tail->wave, allocator);
+            fclose(tail->file);
+            tail->file = NULL;
+            return 0;
+        }
+
+#ifdef WAVE_HAS_INOTIFY
+        tail->notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if ((tail->notify_fd >= 0) && (inotify_add_watch(tail->notify_fd, path, IN_MODIFY | IN_CLOSE_WRITE) < 0))
+        {
+            close(tail->notify_fd);
+            tail->notify_fd = -1;
+        }
+#endif
+
+        tail->sample_format = Wave_GetSampleFormat(&tail->wave);
+        Wave_TailUpdate(tail, 0);
+        return 1;
+    }
+
+    size_t Wave_TailUpdate(WAVE_TAIL* tail, int timeout_ms)
+    {
+        if ((!tail) || (!tail->file))
+            return 0;
+
+#ifdef WAVE_HAS_INOTIFY
+        // Only block when everything on disk was already delivered
+        if ((tail->notify_fd >= 0) && (tail->frame_position == tail->frame_count))
+        {
+            struct pollfd notify = { tail->notify_fd, POLLIN, 0 };
+            if ((timeout_ms != 0) && (poll(&notify, 1, timeout_ms) > 0))
+            {
+                char events[4096];
+                while (read(tail->notify_fd, events, sizeof(events)) > 0)
+                    ;
+            }
+        }
+#else
+        (void)timeout_ms;
+#endif
+
+        uint64_t size;
+        if ((fseek(tail->file, 0, SEEK_END) != 0) || (!Wave_Tell(tail->file, &size)))
+            return 0;
+        if (size < tail->wave.sample_data_offset)
+            return 0;
+
+        uint64_t data_size = size - tail->wave.sample_data_offset;
+
+        // A RIFF size covering the whole file means the recording ended, chunks after the data are not samples
+        uint32_t riff_size = 0;
+        uint32_t header_size = 0;
+        if ((Wave_Seek(tail->file, 4)) && (fread(&riff_size, sizeof(riff_size), 1, tail->file) == 1) && ((uint64_t)riff_size + 8 == size))
+        {
+            if ((Wave_Seek(tail->file, (uint64_t)tail->wave.data_chunk_offset + 4)) && (fread(&header_size, sizeof(header_size), 1, tail->file) == 1) && (header_size < data_size))
+                data_size = header_size;
+        }
+
+        tail->wave.sample_data_size = (size_t)data_size;
+        tail->wave.data_chunk->size = (uint32_t)data_size;
+        tail->frame_count = Wave_GetFrameCount(&tail->wave);
+        return tail->frame_count - tail->frame_position;
+    }
+
+    size_t Wave_TailRead(WAVE_TAIL* tail, void* out_frames, size_t frame_count)
+    {
+        if ((!tail) || (!tail->file) || (!out_frames))
+            return 0;
+
+        if (frame_count > tail->frame_count - tail->frame_position)
+            frame_count = tail->frame_count - tail->frame_position;
+        if (!frame_count)
+            return 0;
+
+        // Updates move the stream, the position is set again before every read
+        size_t block_align = tail->wave.format->block_align;
+        if (!Wave_Seek(tail->file, (uint64_t)tail->wave.sample_data_offset + (uint64_t)tail->frame_position * block_align))
+            return 0;
+
+        size_t read = fread(out_frames, block_align, frame_count, tail->file);
+        tail->frame_position += read;
+        return read;
+    }
+
+    size_t Wave_TailReadFloat(WAVE_TAIL* tail, float* out_frames, size_t frame_count)
+    {
+        if ((!tail) || (!tail->file) || (!out_frames))
+            return 0;
+
+        double temp[1024];
+        size_t channels = tail->wave.format->channels;
+        size_t chunk_frames = sizeof(temp) / tail->wave.format->block_align;
+        size_t total = 0;
+        if (!chunk_frames)
+            return 0;
+
+        while (frame_count)
+        {
+            size_t count = (frame_count < chunk_frames) ? frame_count : chunk_frames;
+            size_t read = Wave_TailRead(tail, temp, count);
+            Wave_ConvertToFloat(temp, tail->sample_format, read * channels, out_frames + total * channels);
+
+            total += read;
+            frame_count -= read;
+            if (read < count)
+                break;
+        }
+
+        return total;
+    }
+
+    int Wave_TailClose(WAVE_TAIL* tail, WAVE_ALLOCATOR* allocator)
+    {
+        if (!tail)
+            return 0;
+
+#ifdef WAVE_HAS_INOTIFY
+        if (tail->notify_fd >= 0)
+            close(tail->notify_fd);
+#endif
+        tail->notify_fd = -1;
+
+        if (tail->file)
+            fclose(tail->file);
+        tail->file = NULL;
+        return Wave_Free(&tail->wave, allocator);
+    }
+#endif // SIMPLE_WAVE_NO_STDIO
+
+
+#ifndef SIMPLE_WAVE_NO_DSP
+    // Cursor used to read and write the saved analysis, the copies keep the buffer free of alignment needs
+    typedef struct WAVE_SAVE_CURSOR
+    {
+        unsigned char* at;
+        const unsigned char* read_at;
+    } WAVE_SAVE_CURSOR;
+
+    static void Wave_SavePut(WAVE_SAVE_CURSOR* cursor, const void* data, size_t size)
+    {
+        memcpy(cursor->at, data, size);
+        cursor->at += size;
+    }
+
+    static void Wave_SaveGet(WAVE_SAVE_CURSOR* cursor, void* data, size_t size)
+    {
+        memcpy(data, cursor->read_at, size);
+        cursor->read_at += size;
+    }
+
+    static size_t Wave_LevelsSaveSize(int channels, size_t block_count)
+    {
+        size_t groups = 1;
+        size_t level;
+        for (level = 0; level < WAVE_LEVELS_STACK_DEPTH; ++level)
+            groups += (block_count >> level) & 1;
+
+        return sizeof(uint32_t) * 4 + sizeof(uint64_t) * 2 + groups * channels * (sizeof(float) + sizeof(double));
+    }
+
+    size_t Wave_LevelsSave(const WAVE_LEVELS_STATE* state, void* out_buffer, size_t buffer_size)
+    {
+        if ((!state) || (state->pending.channels <= 0))
+            return 0;
+
+        int channels = state->pending.channels;
+        size_t size = Wave_LevelsSaveSize(channels, state->block_count);
+        if (!out_buffer)
+            return size;
+        if (buffer_size < size)
+            return 0;
+
+        WAVE_SAVE_CURSOR cursor = { (unsigned char*)out_buffer, NULL };
+        uint32_t header[4] = { WAVE_LEVELS_STATE_MAGIC, WAVE_LEVELS_BLOCK_FRAMES, (uint32_t)channels, 0 };
+        uint64_t counts[2] = { state->block_count, state->pending.frame_count };
+        Wave_SavePut(&cursor, header, sizeof(header));
+        Wave_SavePut(&cursor, counts, sizeof(counts));
+
+        // The incomplete block first, then the merged groups that are present from the smallest up
+        const WAVE_LEVELS* group = &state->pending;
+        size_t level = 0;
+        while (group)
+        {
+            Wave_SavePut(&cursor, group->peak, channels * sizeof(float));
+            Wave_SavePut(&cursor, group->sum_squares, channels * sizeof(double));
+
+            group = NULL;
+            for (; level < WAVE_LEVELS_STACK_DEPTH; ++level)
+            {
+                if (state->block_count & ((size_t)1 << level))
+                {
+                    group = &state->stack[level++];
+                    break;
+                }
+            }
+        }
+
+        return size;
+    }
+
+    int Wave_LevelsLoad(WAVE_LEVELS_STATE* state, const void* buffer, size_t size)
+    {
+        if ((!state) || (!buffer) || (size < sizeof(uint32_t) * 4 + sizeof(uint64_t) * 2))
+            return 0;
+
+        WAVE_SAVE_CURSOR cursor = { NULL, (const unsigned char*)buffer };
+        uint32_t header[4];
+        uint64_t counts[2];
+        Wave_SaveGet(&cursor, header, sizeof(header));
+        Wave_SaveGet(&cursor, counts, sizeof(counts));
+
+        // The grouping of the sums depends on the block size, other block sizes would give different results
+        if ((header[0] != WAVE_LEVELS_STATE_MAGIC) || (header[1] != WAVE_LEVELS_BLOCK_FRAMES))
+            return 0;
+        if ((header[2] == 0) || (header[2] > WAVE_MAX_CHANNELS) || (counts[1] >= WAVE_LEVELS_BLOCK_FRAMES))
+            return 0;
+        if ((counts[0] >> (WAVE_LEVELS_STACK_DEPTH - 1)) || (counts[0] != (size_t)counts[0]))
+            return 0;
+
+        int channels = (int)header[2];
+        size_t block_count = (size_t)counts[0];
+        if (size != Wave_LevelsSaveSize(channels, block_count))
+            return 0;
+
+        Wave_LevelsBegin(state, channels);
+        state->block_count = block_count;
+
+        WAVE_LEVELS* group = &state->pending;
+        group->frame_count = (size_t)counts[1];
+        size_t level = 0;
+        while (group)
+        {
+            Wave_SaveGet(&cursor, group->peak, channels * sizeof(float));
+            Wave_SaveGet(&cursor, group->sum_squares, channels * sizeof(double));
+
+            group = NULL;
+            for (; level < WAVE_LEVELS_STACK_DEPTH; ++level)
+            {
+                if (block_count & ((size_t)1 << level))
+                {
+                    group = &state->stack[level];
+                    Wave_LevelsReset(group, channels);
+                    group->frame_count = ((size_t)WAVE_LEVELS_BLOCK_FRAMES) << level;
+                    level++;
+                    break;
+                }
+            }
+        }
+
+        return 1;
+    }
+
+    size_t Wave_LevelsGetFrameCount(const WAVE_LEVELS_STATE* state)
+    {
+        if (!state)
+            return 0;
+
+        return state->block_count * WAVE_LEVELS_BLOCK_FRAMES + state->pending.frame_count;
+    }
+
+    size_t Wave_TruePeakSave(const WAVE_TRUE_PEAK* meter, void* out_buffer, size_t buffer_size)
+    {
+        if ((!meter) || (meter->channels <= 0))
+            return 0;
+
+        size_t channels = (size_t)meter->channels;
+        size_t size = sizeof(uint32_t) * 2 + sizeof(uint64_t) + channels * ((WAVE_TRUE_PEAK_TAPS - 1) * sizeof(float) + sizeof(float) + sizeof(uint64_t));
+        if (!out_buffer)
+            return size;
+        if (buffer_size < size)
+            return 0;
+
+        WAVE_SAVE_CURSOR cursor = { (unsigned char*)out_buffer, NULL };
+        uint32_t header[2] = { WAVE_TRUE_PEAK_MAGIC, (uint32_t)channels };
+        uint64_t frames_processed = meter->frames_processed;
+        Wave_SavePut(&cursor, header, sizeof(header));
+        Wave_SavePut(&cursor, &frames_processed, sizeof(frames_processed));
+        Wave_SavePut(&cursor, meter->history, (WAVE_TRUE_PEAK_TAPS - 1) * channels * sizeof(float));
+        Wave_SavePut(&cursor, meter->peak, channels * sizeof(float));
+
+        size_t c;
+        for (c = 0; c < channels; ++c)
+        {
+            uint64_t peak_frame = meter->peak_frame[c];
+            Wave_SavePut(&cursor, &peak_frame, sizeof(peak_frame));
+        }
+
+        return size;
+    }
+
+    int Wave_TruePeakLoad(WAVE_TRUE_PEAK* meter, const void* buffer, size_t size)
+    {
+        if ((!meter) || (!buffer) || (size < sizeof(uint32_t) * 2 + sizeof(uint64_t)))
+            return 0;
+
+        WAVE_SAVE_CURSOR cursor = { NULL, (const unsigned char*)buffer };
+        uint32_t header[2];
+        uint64_t frames_processed;
+        Wave_SaveGet(&cursor, header, sizeof(header));
+        Wave_SaveGet(&cursor, &frames_processed, sizeof(frames_processed));
+
+        if ((header[0] != WAVE_TRUE_PEAK_MAGIC) || (header[1] == 0) || (header[1] > WAVE_MAX_CHANNELS))
+            return 0;
+
+        size_t channels = header[1];
+        if (size != sizeof(uint32_t) * 2 + sizeof(uint64_t) + channels * ((WAVE_TRUE_PEAK_TAPS - 1) * sizeof(float) + sizeof(float) + sizeof(uint64_t)))
+            return 0;
+
+        Wave_TruePeakInit(meter, (int)channels);
+        meter->frames_processed = (size_t)frames_processed;
+        Wave_SaveGet(&cursor, meter->history, (WAVE_TRUE_PEAK_TAPS - 1) * channels * sizeof(float));
+        Wave_SaveGet(&cursor, meter->peak, channels * sizeof(float));
+
+        size_t c;
+        for (c = 0; c < channels; ++c)
+        {
+            uint64_t peak_frame;
+            Wave_SaveGet(&cursor, &peak_frame, sizeof(peak_frame));
+            meter->peak_frame[c] = (size_t)peak_frame;
+        }
+
+        return 1;
+    }
+
+
+    static uint32_t Wave_Gcd(uint32_t a, uint32_t b)
+    {
+        while (b)
+        {
+            uint32_t t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    int Wave_ResampleTableInit(WAVE_RESAMPLE_TABLE* table, uint32_t in_rate, uint32_t out_rate, int taps, WAVE_ALLOCATOR* allocator)
+    {
+        if ((!table) || (!in_rate) || (!out_rate))
+            return 0;
+        if (!taps)
+            taps = WAVE_RESAMPLE_DEFAULT_TAPS;
+        if ((taps < 2) || (taps > WAVE_RESAMPLE_MAX_TAPS))
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        memset(table, 0, sizeof(WAVE_RESAMPLE_TABLE));
+        uint32_t gcd = Wave_Gcd(in_rate, out_rate);
+        table->up = out_rate / gcd;
+        table->down = in_rate / gcd;
+        table->taps = (taps + 1) & ~1; // Even so the filter center falls on a sample
+        if (table->up > WAVE_RESAMPLE_MAX_PHASES)
+            return 0;
+
+        size_t length = (size_t)table->up * table->taps;
+        table->free_ptr_size = length * sizeof(float);
+        table->free_ptr = allocator->allocate(allocator->data, table->free_ptr_size);
+        if (!table->free_ptr)
+            return 0;
+
+        // Windowed sinc at the upsampled rate, symmetric around its center sample
+        float* coefficients = (float*)table->free_ptr;
+        uint32_t larger = (table->up > table->down) ? table->up : table->down;
+        double cutoff = 0.5 * WAVE_RESAMPLE_CUTOFF / (double)larger;
+        double center = (double)(length / 2);
+        double pi = 3.14159265358979323846;
+        uint32_t p;
+        int i;
+        for (p = 0; p < table->up; ++p)
+        {
+            float* phase = coefficients + (size_t)p * table->taps;
+            double sum = 0.0;
+            for (i = 0; i < table->taps; ++i)
+            {
+                // The newest input gets the first tap of the phase, phases are stored oldest input first
+                double t = (double)p + (double)(table->taps - 1 - i) * table->up;
+                double x = t - center;
+                double sinc = (x == 0.0) ? 2.0 * cutoff : sin(2.0 * pi * cutoff * x) / (pi * x);
+                double window = 0.42 - 0.5 * cos(pi * t / center) + 0.08 * cos(2.0 * pi * t / center);
+                double value = sinc * window;
+                phase[i] = (float)value;
+                sum += value;
+            }
+
+            // Unity gain for every phase, a constant input stays constant
+            for (i = 0; i < table->taps; ++i)
+                phase[i] = (float)(phase[i] / sum);
+        }
+
+        table->coefficients = coefficients;
+        return 1;
+    }
+
+    uint64_t Wave_ResampleGetOutputLength(const WAVE_RESAMPLE_TABLE* table, uint64_t frame_count)
+    {
+        if ((!table) || (!table->down))
+            return 0;
+
+        return (frame_count * table->up + table->down - 1) / table->down;
+    }
+
+    int Wave_ResampleTableFree(WAVE_RESAMPLE_TABLE* table, WAVE_ALLOCATOR* allocator)
+    {
+        if (!table)
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        if (table->free_ptr)
+            allocator->free(allocator->data, table->free_ptr, table->free_ptr_size);
+        memset(table, 0, sizeof(WAVE_RESAMPLE_TABLE));
+        return 1;
+    }
+
+    int Wave_ResampleCacheInit(WAVE_RESAMPLE_CACHE* cache)
+    {
+        if (!cache)
+            return 0;
+
+        memset(cache, 0, sizeof(WAVE_RESAMPLE_CACHE));
+        return 1;
+    }
+
+    int Wave_ResampleCacheGet(WAVE_RESAMPLE_CACHE* cache, uint32_t in_rate, uint32_t out_rate, int taps, const WAVE_RESAMPLE_TABLE** out_table, WAVE_ALLOCATOR* allocator)
+    {
+        if ((!cache) || (!out_table) || (!in_rate) || (!out_rate))
+            return 0;
+        if (!taps)
+            taps = WAVE_RESAMPLE_DEFAULT_TAPS;
+
+        // Same reduction and tap rounding as Wave_ResampleTableInit, 44100:48000 and 88200:96000 share a table
+        uint32_t gcd = Wave_Gcd(in_rate, out_rate);
+        uint32_t up = out_rate / gcd;
+        uint32_t down = in_rate / gcd;
+        int rounded = (taps + 1) & ~1;
+        size_t i;
+        for (i = 0; i < cache->count; ++i)
+        {
+            const WAVE_RESAMPLE_TABLE* table = &cache->tables[i];
+            if ((table->up == up) && (table->down == down) && (table->taps == rounded))
+            {
+                *out_table = table;
+                return 1;
+            }
+        }
+
+        if (cache->count == WAVE_RESAMPLE_CACHE_SIZE)
+            return 0;
+        if (!Wave_ResampleTableInit(&cache->tables[cache->count], in_rate, out_rate, taps, allocator))
+            return 0;
+
+        *out_table = &cache->tables[cache->count++];
+        return 1;
+    }
+
+    int Wave_ResampleCacheFree(WAVE_RESAMPLE_CACHE* cache, WAVE_ALLOCATOR* allocator)
+    {
+        if (!cache)
+            return 0;
+
+        size_t i;
+        for (i = 0; i < cache->count; ++i)
+            Wave_ResampleTableFree(&cache->tables[i], allocator);
+        cache->count = 0;
+        return 1;
+    }
+
+    int Wave_ResamplerInit(WAVE_RESAMPLER* resampler, const WAVE_RESAMPLE_TABLE* table, int channels, WAVE_ALLOCATOR* allocator)
+    {
+        if ((!resampler) || (!table) || (!table->coefficients) || (channels <= 0) || (channels > WAVE_MAX_CHANNELS))
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        memset(resampler, 0, sizeof(WAVE_RESAMPLER));
+        resampler->buffer_capacity = (size_t)table->taps - 1 + WAVE_RESAMPLE_BLOCK_FRAMES;
+        resampler->free_ptr_size = resampler->buffer_capacity * channels * sizeof(float);
+        resampler->free_ptr = allocator->allocate(allocator->data, resampler->free_ptr_size);
+        if (!resampler->free_ptr)
+            return 0;
+
+        // Silence before the first frame, the first outputs see a zero history
+        resampler->table = table;
+        resampler->channels = channels;
+        resampler->buffer = (float*)resampler->free_ptr;
+        resampler->buffer_frames = (size_t)table->taps - 1;
+        memset(resampler->buffer, 0, resampler->buffer_frames * channels * sizeof(float));
+        return 1;
+    }
+
+    size_t Wave_ResamplerGetMaxOutput(const WAVE_RESAMPLER* resampler, size_t frame_count)
+    {
+        if (!resampler)
+            return 0;
+
+        return (size_t)(Wave_ResampleGetOutputLength(resampler->table, resampler->input_frames + frame_count) - resampler->output_frames);
+    }
+
+    // Writes the output frames the buffered input completes, up to limit frames in total
+    static size_t Wave_ResamplerRun(WAVE_RESAMPLER* resampler, float* out_frames, uint64_t limit)
+    {
+        const WAVE_RESAMPLE_TABLE* table = resampler->table;
+        size_t channels = (size_t)resampler->channels;
+        size_t taps = (size_t)table->taps;
+        uint64_t center = (uint64_t)table->up * taps / 2;
+        uint64_t buffer_end = resampler->buffer_first + resampler->buffer_frames;
+        size_t written = 0;
+
+        while (resampler->output_frames < limit)
+        {
+            // The window of output k starts at the buffer index of input n - taps + 1
+            uint64_t position = resampler->output_frames * table->down + center;
+            uint64_t first = position / table->up;
+            if (first + taps > buffer_end)
+                break;
+
+            const float* phase = table->coefficients + (size_t)(position % table->up) * taps;
+            const float* window = resampler->buffer + (size_t)(first - resampler->buffer_first) * channels;
+            float* out = out_frames + written * channels;
+            size_t c;
+            size_t i;
+
+            // Channels are the lanes, every tap is one multiply add across the frame
+            for (c = 0; c < channels; ++c)
+                out[c] = 0.0f;
+            for (i = 0; i < taps; ++i)
+            {
+                const float* frame = window + i * channels;
+                for (c = 0; c < channels; ++c)
+                    out[c] += phase[i] * frame[c];
+            }
+
+            resampler->output_frames++;
+            written++;
+        }
+
+        // Drop the frames no later output reaches
+        uint64_t next = (resampler->output_frames * table->down + center) / table->up;
+        if (next > resampler->buffer_first)
+        {
+            size_t drop = (size_t)(next - resampler->buffer_first);
+            if (drop > resampler->buffer_frames)
+                drop = resampler->buffer_frames;
+            memmove(resampler->buffer, resampler->buffer + drop * channels, (resampler->buffer_frames - drop) * channels * sizeof(float));
+            resampler->buffer_frames -= drop;
+            resampler->buffer_first += drop;
+        }
+
+        return written;
+    }
+
+    // Appends frames (silence when frames is NULL) and runs the filter on every full buffer
+    static size_t Wave_ResamplerFeed(WAVE_RESAMPLER* resampler, const float* frames, size_t frame_count, float* out_frames, uint64_t limit)
+    {
+        size_t channels = (size_t)resampler->channels;
+        size_t written = 0;
+
+        while (frame_count)
+        {
+            size_t count = resampler->buffer_capacity - resampler->buffer_frames;
+            if (count > frame_count)
+                count = frame_count;
+
+            float* at = resampler->buffer + resampler->buffer_frames * channels;
+            if (frames)
+            {
+                memcpy(at, frames, count * channels * sizeof(float));
+                frames += count * channels;
+            }
+            else
+                memset(at, 0, count * channels * sizeof(float));
+
+            resampler->buffer_frames += count;
+            frame_count -= count;
+            written += Wave_ResamplerRun(resampler, out_frames + written * channels, limit);
+        }
+
+        return written;
+    }
+
+    size_t Wave_ResamplerProcess(WAVE_RESAMPLER* resampler, const float* frames, size_t frame_count, float* out_frames)
+    {
+        if ((!resampler) || (!resampler->buffer) || (!out_frames))
+            return 0;
+        if ((frame_count) && (!frames))
+            return 0;
+
+        resampler->input_frames += frame_count;
+        return Wave_ResamplerFeed(resampler, frames, frame_count, out_frames, (uint64_t)-1);
+    }
+
+    size_t Wave_ResamplerFinish(WAVE_RESAMPLER* resampler, float* out_frames)
+    {
+        if ((!resampler) || (!resampler->buffer) || (!out_frames))
+            return 0;
+
+        // Half a filter of silence completes every output the input covers
+        uint64_t length = Wave_ResampleGetOutputLength(resampler->table, resampler->input_frames);
+        size_t written = Wave_ResamplerFeed(resampler, NULL, (size_t)resampler->table->taps, out_frames, length);
+        return written;
+    }
+
+    int Wave_ResamplerFree(WAVE_RESAMPLER* resampler, WAVE_ALLOCATOR* allocator)
+    {
+        if (!resampler)
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        if (resampler->free_ptr)
+            allocator->free(allocator->data, resampler->free_ptr, resampler->free_ptr_size);
+        memset(resampler, 0, sizeof(WAVE_RESAMPLER));
+        return 1;
+    }
+
+
+    static void Wave_VadStore(WAVE_VAD_SEGMENT* out_segments, size_t max_segments, size_t* segment_count, int channel, size_t first_frame, size_t end_frame)
+    {
+        if (*segment_count < max_segments)
+        {
+            out_segments[*segment_count].channel = channel;
+            out_segments[*segment_count].first_frame = first_frame;
+            out_segments[*segment_count].frame_count = end_frame - first_frame;
+        }
+        (*segment_count)++;
+    }
+
+    // Restarts the detector for a stream, the buffer is kept when it is large enough and only grown with an allocator
+    static int Wave_VadConfigure(WAVE_VAD* vad, int channels, uint32_t sample_rate, WAVE_ALLOCATOR* allocator)
+    {
+        if ((channels <= 0) || (channels > WAVE_MAX_CHANNELS) || (!sample_rate))
+            return 0;
+
+        size_t frame_size = (size_t)sample_rate * WAVE_VAD_FRAME_MS / 1000;
+        size_t fft_size = 64;
+        while (fft_size < frame_size)
+            fft_size *= 2;
+        if ((!frame_size) || (fft_size > WAVE_VAD_MAX_FFT_SIZE))
+            return 0;
+
+        size_t size = (frame_size * (channels + 1) + fft_size) * sizeof(float);
+        if (size > vad->free_ptr_size)
+        {
+            if (!allocator)
+                return 0;
+            if (vad->free_ptr)
+                allocator->free(allocator->data, vad->free_ptr, vad->free_ptr_size);
+            vad->free_ptr_size = size;
+            vad->free_ptr = allocator->allocate(allocator->data, size);
+            if (!vad->free_ptr)
+            {
+                vad->free_ptr_size = 0;
+                return 0;
+            }
+        }
+
+        vad->channels = channels;
+        vad->sample_rate = sample_rate;
+        vad->frame_size = frame_size;
+        vad->fft_size = fft_size;
+        vad->frame_position = 0;
+        vad->pending = (float*)vad->free_ptr;
+        vad->pending_frames = 0;
+        vad->window = vad->pending + frame_size * channels;
+        vad->twiddles = vad->window + frame_size;
+        memset(vad->state, 0, sizeof(vad->state));
+
+        size_t i;
+        for (i = 0; i < frame_size; ++i)
+            vad->window[i] = 0.5f - 0.5f * cosf(2.0f * 3.14159265f * (float)i / (float)frame_size);
+        return Wave_FFTTwiddles(vad->twiddles, fft_size);
+    }
+
+    int Wave_VadInit(WAVE_VAD* vad, int channels, uint32_t sample_rate, WAVE_ALLOCATOR* allocator)
+    {
+        if (!vad)
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        memset(vad, 0, sizeof(WAVE_VAD));
+        return Wave_VadConfigure(vad, channels, sample_rate, allocator);
+    }
+
+    // Judges the complete analysis frame in pending for every channel
+    static void Wave_VadAnalyze(WAVE_VAD* vad, WAVE_VAD_SEGMENT* out_segments, size_t max_segments, size_t* segment_count)
+    {
+        float real[WAVE_VAD_MAX_FFT_SIZE];
+        float imag[WAVE_VAD_MAX_FFT_SIZE];
+        size_t channels = (size_t)vad->channels;
+        size_t frame_size = vad->frame_size;
+        size_t first_bin = 300 * vad->fft_size / vad->sample_rate;
+        size_t last_bin = ((vad->sample_rate / 2 < 3400) ? vad->sample_rate / 2 : 3400) * vad->fft_size / vad->sample_rate;
+        size_t frame_start = vad->frame_position - frame_size;
+        size_t c, i;
+
+        if (first_bin < 1)
+            first_bin = 1;
+
+        for (c = 0; c < channels; ++c)
+        {
+            WAVE_VAD_CHANNEL* state = &vad->state[c];
+            const float* at = vad->pending + c;
+            float energy = 0.0f;
+            size_t crossings = 0;
+            float previous = at[0];
+
+            for (i = 0; i < frame_size; ++i)
+            {
+                float sample = at[i * channels];
+                energy += sample * sample;
+                crossings += (sample >= 0.0f) != (previous >= 0.0f);
+                previous = sample;
+                real[i] = sample * vad->window[i];
+                imag[i] = 0.0f;
+            }
+            for (; i < vad->fft_size; ++i)
+            {
+                real[i] = 0.0f;
+                imag[i] = 0.0f;
+            }
+
+            float decibels = 10.0f * log10f(energy / (float)frame_size + 1e-12f);
+            float zero_crossings = (float)crossings / (float)frame_size;
+
+            // Flatness, the geometric over the arithmetic mean of the power in the speech band
+            Wave_FFTWithTwiddles(real, imag, vad->fft_size, 0, vad->twiddles);
+            double log_sum = 0.0;
+            double sum = 0.0;
+            size_t bins = 0;
+            for (i = first_bin; i <= last_bin; ++i)
+            {
+                double power = (double)real[i] * real[i] + (double)imag[i] * imag[i] + 1e-20;
+                log_sum += log(power);
+                sum += power;
+                bins++;
+            }
+            float flatness = bins ? (float)(exp(log_sum / bins) / (sum / bins)) : 1.0f;
+
+            // The first frame of the stream starts the floor
+            if ((vad->frame_position == frame_size) || (decibels < state->noise_floor))
+                state->noise_floor = decibels;
+
+            int speech = (decibels > state->noise_floor + WAVE_VAD_ENERGY_MARGIN) && (decibels > WAVE_VAD_MIN_ENERGY) &&
+                         ((flatness < WAVE_VAD_MAX_FLATNESS) || (zero_crossings < WAVE_VAD_MAX_ZERO_CROSSINGS));
+
+            // The floor follows the background slowly, speech never raises it
+            if (!speech)
+                state->noise_floor += 0.05f * (decibels - state->noise_floor);
+
+            if (speech)
+            {
+                if (!state->speech_run)
+                    state->segment_start = frame_start;
+                state->speech_run++;
+                state->silence_run = 0;
+                if (state->speech_run >= WAVE_VAD_MIN_SPEECH_FRAMES)
+                    state->active = 1;
+            }
+            else
+            {
+                if ((state->active) && (++state->silence_run > WAVE_VAD_HANGOVER_FRAMES))
+                {
+                    // The segment ends with its last speech frame
+                    Wave_VadStore(out_segments, max_segments, segment_count, (int)c, state->segment_start, frame_start - (state->silence_run - 1) * frame_size);
+                    state->active = 0;
+                    state->silence_run = 0;
+                }
+                if (!state->active)
+                    state->speech_run = 0;
+            }
+        }
+    }
+
+    int Wave_VadProcess(WAVE_VAD* vad, const float* frames, size_t frame_count, WAVE_VAD_SEGMENT* out_segments, size_t max_segments, size_t* out_segment_count)
+    {
+        if ((!vad) || (!vad->pending))
+            return 0;
+        if (((frame_count) && (!frames)) || ((max_segments) && (!out_segments)))
+            return 0;
+
+        size_t channels = (size_t)vad->channels;
+        size_t segment_count = 0;
+        while (frame_count)
+        {
+            size_t count = vad->frame_size - vad->pending_frames;
+            if (count > frame_count)
+                count = frame_count;
+
+            memcpy(vad->pending + vad->pending_frames * channels, frames, count * channels * sizeof(float));
+            vad->pending_frames += count;
+            vad->frame_position += count;
+            frames += count * channels;
+            frame_count -= count;
+
+            if (vad->pending_frames == vad->frame_size)
+            {
+                Wave_VadAnalyze(vad, out_segments, max_segments, &segment_count);
+                vad->pending_frames = 0;
+            }
+        }
+
+        if (out_segment_count)
+            *out_segment_count = segment_count;
+        return 1;
+    }
+
+    int Wave_VadFinish(WAVE_VAD* vad, WAVE_VAD_SEGMENT* out_segments, size_t max_segments, size_t* out_segment_count)
+    {
+        if ((!vad) || (!vad->pending))
+            return 0;
+        if ((max_segments) && (!out_segments))
+            return 0;
+
+        // The incomplete analysis frame is dropped, open segments end with their last speech frame
+        size_t analysed = vad->frame_position - vad->pending_frames;
+        size_t segment_count = 0;
+        int c;
+        for (c = 0; c < vad->channels; ++c)
+        {
+            WAVE_VAD_CHANNEL* state = &vad->state[c];
+            if (state->active)
+                Wave_VadStore(out_segments, max_segments, &segment_count, c, state->segment_start, analysed - state->silence_run * vad->frame_size);
+        }
+
+        if (out_segment_count)
+            *out_segment_count = segment_count;
+        return Wave_VadConfigure(vad, vad->channels, vad->sample_rate, NULL);
+    }
+
+#ifndef SIMPLE_WAVE_NO_STDIO
+    int Wave_VadProcessReader(WAVE_VAD* vad, WAVE_READER* reader, WAVE_VAD_SEGMENT* out_segments, size_t max_segments, size_t* out_segment_count)
+    {
+        if ((!vad) || (!vad->pending) || (!reader) || (!reader->file))
+            return 0;
+        if ((max_segments) && (!out_segments))
+            return 0;
+
+        // Reuses the buffer, readers with longer frames than the detector was made for are refused
+        if (!Wave_VadConfigure(vad, Wave_GetChannelCount(&reader->wave), (uint32_t)Wave_GetSampleFrequency(&reader->wave), NULL))
+            return 0;
+
+        float temp[64 * WAVE_MAX_CHANNELS];
+        size_t chunk_frames = sizeof(temp) / sizeof(float) / vad->channels;
+        size_t segment_count = 0;
+        for (;;)
+        {
+            size_t read = Wave_ReaderReadFloat(reader, temp, chunk_frames);
+            if (!read)
+                break;
+
+            size_t found = 0;
+            size_t stored = (segment_count < max_segments) ? segment_count : max_segments;
+            Wave_VadProcess(vad, temp, read, out_segments ? out_segments + stored : NULL, max_segments - stored, &found);
+            segment_count += found;
+        }
+
+        size_t found = 0;
+        size_t stored = (segment_count < max_segments) ? segment_count : max_segments;
+        Wave_VadFinish(vad, out_segments ? out_segments + stored : NULL, max_segments - stored, &found);
+        segment_count += found;
+
+        if (out_segment_count)
+            *out_segment_count = segment_count;
+        return 1;
+    }
+
+    int Wave_VadProcessReaders(WAVE_READER* readers, size_t reader_count, WAVE_VAD_SEGMENT* out_segments, size_t max_segments, size_t* out_segment_counts, WAVE_ALLOCATOR* allocator)
+    {
+        if ((!readers) || ((max_segments) && (!out_segments)))
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        WAVE_VAD vad;
+        memset(&vad, 0, sizeof(WAVE_VAD));
+
+        size_t stored = 0;
+        size_t i;
+        int result = 1;
+        for (i = 0; i < reader_count; ++i)
+        {
+            size_t found = 0;
+
+            // Grows the shared buffer only for readers needing more than any before
+            if (!Wave_VadConfigure(&vad, Wave_GetChannelCount(&readers[i].wave), (uint32_t)Wave_GetSampleFrequency(&readers[i].wave), allocator))
+                result = 0;
+            else if (!Wave_VadProcessReader(&vad, &readers[i], out_segments ? out_segments + stored : NULL, max_segments - stored, &found))
+                result = 0;
+
+            if (out_segment_counts)
+                out_segment_counts[i] = found;
+            stored += (found < max_segments - stored) ? found : max_segments - stored;
+        }
+
+        Wave_VadFree(&vad, allocator);
+        return result;
+    }
+#endif // SIMPLE_WAVE_NO_STDIO
+
+    int Wave_VadFree(WAVE_VAD* vad, WAVE_ALLOCATOR* allocator)
+    {
+        if (!vad)
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        if (vad->free_ptr)
+            allocator->free(allocator->data, vad->free_ptr, vad->free_ptr_size);
+        memset(vad, 0, sizeof(WAVE_VAD));
+        return 1;
+    }
+
+
+    static void Wave_StereoGetSumsResult(const WAVE_STEREO_SUMS* sums, size_t first_frame, WAVE_STEREO_RESULT* out_result)
+    {
+        double mid = (sums->left + sums->right + 2.0 * sums->product) * 0.25;
+        double side = (sums->left + sums->right - 2.0 * sums->product) * 0.25;
+        double stereo = (sums->left + sums->right) * 0.5;
+
+        out_result->first_frame = first_frame;
+        out_result->frame_count = sums->frame_count;
+        out_result->correlation = 0.0f;
+        out_result->balance_db = 0.0f;
+        out_result->side_db = 0.0f;
+        out_result->mono_db = 0.0f;
+
+        // Silence is reported as neutral, a silent channel or fold-down as -inf
+        if ((sums->left > 0.0) && (sums->right > 0.0))
+        {
+            out_result->correlation = (float)(sums->product / sqrt(sums->left * sums->right));
+            out_result->balance_db = (float)(10.0 * log10(sums->left / sums->right));
+        }
+        else if (sums->left > 0.0)
+            out_result->balance_db = HUGE_VALF;
+        else if (sums->right > 0.0)
+            out_result->balance_db = -HUGE_VALF;
+
+        if (stereo > 0.0)
+        {
+            out_result->side_db = (mid > 0.0) ? (float)(10.0 * log10(side / mid)) : HUGE_VALF;
+            out_result->mono_db = (mid > 0.0) ? (float)(10.0 * log10(mid / stereo)) : -HUGE_VALF;
+            if (side <= 0.0)
+                out_result->side_db = -HUGE_VALF;
+        }
+    }
+
+    int Wave_StereoInit(WAVE_STEREO_METER* meter, int channels, int left, int right, size_t window_frames)
+    {
+        if ((!meter) || (channels <= 0) || (channels > WAVE_MAX_CHANNELS))
+            return 0;
+        if ((left < 0) || (left >= channels) || (right < 0) || (right >= channels))
+            return 0;
+
+        memset(meter, 0, sizeof(WAVE_STEREO_METER));
+        meter->channels = channels;
+        meter->left = left;
+        meter->right = right;
+        meter->window_frames = window_frames;
+        return 1;
+    }
+
+    int Wave_StereoProcess(WAVE_STEREO_METER* meter, const float* frames, size_t frame_count, WAVE_STEREO_RESULT* out_windows, size_t max_windows, size_t* out_window_count)
+    {
+        if ((!meter) || (meter->channels <= 0))
+            return 0;
+        if (((frame_count) && (!frames)) || ((max_windows) && (!out_windows)))
+            return 0;
+
+        size_t channels = (size_t)meter->channels;
+        size_t window_count = 0;
+        while (frame_count)
+        {
+            size_t count = frame_count;
+            if ((meter->window_frames) && (count > meter->window_frames - meter->window.frame_count))
+                count = meter->window_frames - meter->window.frame_count;
+
+            // Independent sums per block, no dependency between frames beyond the three accumulators
+            const float* left = frames + meter->left;
+            const float* right = frames + meter->right;
+            double sum_left = 0.0, sum_right = 0.0, sum_product = 0.0;
+            size_t i;
+            for (i = 0; i < count; ++i)
+            {
+                double l = left[i * channels];
+                double r = right[i * channels];
+                sum_left += l * l;
+                sum_right += r * r;
+                sum_product += l * r;
+            }
+
+            meter->window.left += sum_left;
+            meter->window.right += sum_right;
+            meter->window.product += sum_product;
+            meter->window.frame_count += count;
+            meter->total.left += sum_left;
+            meter->total.right += sum_right;
+            meter->total.product += sum_product;
+            meter->total.frame_count += count;
+            meter->frame_position += count;
+            frames += count * channels;
+            frame_count -= count;
+
+            if ((meter->window_frames) && (meter->window.frame_count == meter->window_frames))
+            {
+                if (window_count < max_windows)
+                    Wave_StereoGetSumsResult(&meter->window, meter->frame_position - meter->window_frames, &out_windows[window_count]);
+                window_count++;
+                memset(&meter->window, 0, sizeof(WAVE_STEREO_SUMS));
+            }
+        }
+
+        if (out_window_count)
+            *out_window_count = window_count;
+        return 1;
+    }
+
+    int Wave_StereoProcessWave(WAVE_STEREO_METER* meter, WAVE* wave, WAVE_STEREO_RESULT* out_windows, size_t max_windows, size_t* out_window_count)
+    {
+        if ((!meter) || (!wave) || (!wave->sample_data))
+            return 0;
+        if (Wave_GetChannelCount(wave) != meter->channels)
+            return 0;
+
+        float temp[64 * WAVE_MAX_CHANNELS];
+        size_t chunk_frames = sizeof(temp) / sizeof(float) / meter->channels;
+        size_t total = Wave_GetFrameCount(wave);
+        size_t window_count = 0;
+        size_t at;
+        for (at = 0; at < total; at += chunk_frames)
+        {
+            size_t count = Wave_ReadFramesFloat(wave, at, chunk_frames, temp);
+            size_t stored = (window_count < max_windows) ? window_count : max_windows;
+            size_t found = 0;
+            if (!Wave_StereoProcess(meter, temp, count, out_windows ? out_windows + stored : NULL, max_windows - stored, &found))
+                return 0;
+            window_count += found;
+        }
+
+        if (out_window_count)
+            *out_window_count = window_count;
+        return 1;
+    }
+
+    int Wave_StereoFinish(WAVE_STEREO_METER* meter, WAVE_STEREO_RESULT* out_windows, size_t max_windows, size_t* out_window_count)
+    {
+        if ((!meter) || ((max_windows) && (!out_windows)))
+            return 0;
+
+        size_t window_count = 0;
+        if (meter->window.frame_count)
+        {
+            if (max_windows)
+                Wave_StereoGetSumsResult(&meter->window, meter->frame_position - meter->window.frame_count, &out_windows[0]);
+            window_count = 1;
+            memset(&meter->window, 0, sizeof(WAVE_STEREO_SUMS));
+        }
+
+        if (out_window_count)
+            *out_window_count = window_count;
+        return 1;
+    }
+
+    int Wave_StereoGetResult(WAVE_STEREO_METER* meter, WAVE_STEREO_RESULT* out_result)
+    {
+        if ((!meter) || (!out_result) || (meter->channels <= 0))
+            return 0;
+
+        Wave_StereoGetSumsResult(&meter->total, 0, out_result);
+        return 1;
+    }
+
+
+    // Raw sample values as doubles, exact for every format, overs of float formats are folded to full scale
+    static void Wave_ReadRawFrames(WAVE* wave, WAVE_SAMPLE_FORMAT sample_format, size_t first_frame, size_t frame_count, double* out_values)
+    {
+        const unsigned char* src = (const unsigned char*)wave->sample_data + first_frame * wave->format->block_align;
+        size_t count = frame_count * wave->format->channels;
+        size_t i;
+
+        switch (sample_format)
+        {
+            case WAVE_SAMPLE_FORMAT_U8:
+                for (i = 0; i < count; ++i)
+                    out_values[i] = src[i];
+                break;
+            case WAVE_SAMPLE_FORMAT_S16:
+                for (i = 0; i < count; ++i)
+                {
+                    int16_t value;
+                    memcpy(&value, src + i * sizeof(value), sizeof(value));
+                    out_values[i] = value;
+                }
+                break;
+            case WAVE_SAMPLE_FORMAT_S32:
+                for (i = 0; i < count; ++i)
+                {
+                    int32_t value;
+                    memcpy(&value, src + i * sizeof(value), sizeof(value));
+                    out_values[i] = value;
+                }
+                break;
+            case WAVE_SAMPLE_FORMAT_F32:
+                for (i = 0; i < count; ++i)
+                {
+                    float value;
+                    memcpy(&value, src + i * sizeof(value), sizeof(value));
+                    out_values[i] = (value > 1.0f) ? 1.0 : ((value < -1.0f) ? -1.0 : value);
+                }
+                break;
+            case WAVE_SAMPLE_FORMAT_F64:
+                for (i = 0; i < count; ++i)
+                {
+                    double value;
+                    memcpy(&value, src + i * sizeof(value), sizeof(value));
+                    out_values[i] = (value > 1.0) ? 1.0 : ((value < -1.0) ? -1.0 : value);
+                }
+                break;
+            default:
+                memset(out_values, 0, count * sizeof(double));
+                break;
+        }
+    }
+
+    static int Wave_CompareFaultEvents(const void* a, const void* b)
+    {
+        const WAVE_FAULT_EVENT* left = (const WAVE_FAULT_EVENT*)a;
+        const WAVE_FAULT_EVENT* right = (const WAVE_FAULT_EVENT*)b;
+        if (left->first_frame != right->first_frame)
+            return (left->first_frame < right->first_frame) ? -1 : 1;
+        return left->channel - right->channel;
+    }
+
+    // Per channel runs of identical values, each range only reports the runs starting inside it
+    typedef struct WAVE_FAULT_SCAN
+    {
+        double low;
+        double high;
+        double zero;
+        double run_value[WAVE_MAX_CHANNELS];
+        size_t run_start[WAVE_MAX_CHANNELS];
+        int run_owned[WAVE_MAX_CHANNELS];
+        size_t owned_count;
+
+        WAVE_FAULT_EVENT* out_events;
+        size_t max_events;
+        size_t event_count;
+        int heap; // Set once the stored events overflowed and were arranged as a heap, the last one sorting at the root
+    } WAVE_FAULT_SCAN;
+
+    // Restores the heap below index, an event that sorts later goes above the ones that sort earlier
+    static void Wave_FaultSiftDown(WAVE_FAULT_EVENT* events, size_t count, size_t index)
+    {
+        for (;;)
+        {
+            size_t largest = index;
+            size_t left = index * 2 + 1;
+            size_t right = left + 1;
+            if ((left < count) && (Wave_CompareFaultEvents(&events[left], &events[largest]) > 0))
+                largest = left;
+            if ((right < count) && (Wave_CompareFaultEvents(&events[right], &events[largest]) > 0))
+                largest = right;
+            if (largest == index)
+                return;
+
+            WAVE_FAULT_EVENT temp = events[index];
+            events[index] = events[largest];
+            events[largest] = temp;
+            index = largest;
+        }
+    }
+
+    static void Wave_FaultCloseRun(WAVE_FAULT_SCAN* scan, size_t channel, size_t end_frame, size_t total)
+    {
+        if (!scan->run_owned[channel])
+            return;
+
+        double value = scan->run_value[channel];
+        size_t first_frame = scan->run_start[channel];
+        WAVE_FAULT fault = WAVE_FAULT_STUCK;
+        size_t min_frames = WAVE_FAULT_MIN_STUCK_FRAMES;
+        if ((value == scan->low) || (value == scan->high))
+        {
+            fault = WAVE_FAULT_CLIP;
+            min_frames = WAVE_FAULT_MIN_CLIP_FRAMES;
+        }
+        else if (value == scan->zero)
+        {
+            fault = WAVE_FAULT_DROPOUT;
+            min_frames = WAVE_FAULT_MIN_DROPOUT_FRAMES;
+            if ((first_frame == 0) || (end_frame == total))
+                min_frames = (size_t)-1;
+        }
+
+        if (end_frame - first_frame >= min_frames)
+        {
+            WAVE_FAULT_EVENT event;
+            event.fault = fault;
+            event.channel = (int)channel;
+            event.first_frame = first_frame;
+            event.frame_count = end_frame - first_frame;
+
+            if (scan->event_count < scan->max_events)
+                scan->out_events[scan->event_count] = event;
+            else if (scan->max_events)
+            {
+                // Runs close out of start order, keep the max_events that start first: the stored event starting last makes room
+                size_t i;
+                if (!scan->heap)
+                {
+                    for (i = scan->max_events / 2; i-- > 0;)
+                        Wave_FaultSiftDown(scan->out_events, scan->max_events, i);
+                    scan->heap = 1;
+                }
+                if (Wave_CompareFaultEvents(&event, &scan->out_events[0]) < 0)
+                {
+                    scan->out_events[0] = event;
+                    Wave_FaultSiftDown(scan->out_events, scan->max_events, 0);
+                }
+            }
+            scan->event_count++;
+        }
+
+        scan->run_owned[channel] = 0;
+        scan->owned_count--;
+    }
+
+    int Wave_DetectFaults(WAVE* wave, size_t first_frame, size_t frame_count, WAVE_FAULT_EVENT* out_events, size_t max_events, size_t* out_event_count)
+    {
+        if ((!wave) || (!wave->sample_data) || (!wave->format) || (!wave->format->channels))
+            return 0;
+        if (wave->format->channels > WAVE_MAX_CHANNELS)
+            return 0;
+        if ((max_events) && (!out_events))
+            return 0;
+
+        WAVE_FAULT_SCAN scan;
+        memset(&scan, 0, sizeof(WAVE_FAULT_SCAN));
+        scan.low = -1.0;
+        scan.high = 1.0;
+        scan.out_events = out_events;
+        scan.max_events = max_events;
+
+        WAVE_SAMPLE_FORMAT sample_format = Wave_GetSampleFormat(wave);
+        switch (sample_format)
+        {
+            case WAVE_SAMPLE_FORMAT_U8:
+                scan.low = 0.0;
+                scan.high = 255.0;
+                scan.zero = 128.0;
+                break;
+            case WAVE_SAMPLE_FORMAT_S16:
+                scan.low = -32768.0;
+                scan.high = 32767.0;
+                break;
+            case WAVE_SAMPLE_FORMAT_S32:
+                scan.low = -2147483648.0;
+                scan.high = 2147483647.0;
+                break;
+            case WAVE_SAMPLE_FORMAT_F32:
+            case WAVE_SAMPLE_FORMAT_F64:
+                break;
+            default:
+                return 0;
+        }
+
+        size_t total = Wave_GetFrameCount(wave);
+        if (first_frame > total)
+            first_frame = total;
+        if (frame_count > total - first_frame)
+            frame_count = total - first_frame;
+
+        size_t end_frame = first_frame + frame_count;
+        size_t channels = wave->format->channels;
+        double values[64 * WAVE_MAX_CHANNELS];
+        size_t chunk_frames = sizeof(values) / sizeof(double) / channels;
+        size_t frame = first_frame;
+        size_t c;
+
+        // A run continuing from the frame before the range belongs to the range that saw it start
+        if (first_frame < end_frame)
+        {
+            Wave_ReadRawFrames(wave, sample_format, first_frame, 1, values);
+            if (first_frame)
+                Wave_ReadRawFrames(wave, sample_format, first_frame - 1, 1, values + channels);
+            for (c = 0; c < channels; ++c)
+            {
+                scan.run_value[c] = values[c];
+                scan.run_start[c] = first_frame;
+                scan.run_owned[c] = (!first_frame) || (values[channels + c] != values[c]);
+                scan.owned_count += scan.run_owned[c];
+            }
+            frame++;
+        }
+
+        // Past the end of the range only the runs it owns are followed to their end
+        while ((frame < total) && ((frame < end_frame) || (scan.owned_count)))
+        {
+            size_t count = (total - frame < chunk_frames) ? total - frame : chunk_frames;
+            Wave_ReadRawFrames(wave, sample_format, frame, count, values);
+
+            size_t i;
+            for (i = 0; (i < count) && ((frame < end_frame) || (scan.owned_count)); ++i, ++frame)
+            {
+                const double* at = values + i * channels;
+                for (c = 0; c < channels; ++c)
+                {
+                    if (at[c] == scan.run_value[c])
+                        continue;
+
+                    Wave_FaultCloseRun(&scan, c, frame, total);
+                    scan.run_value[c] = at[c];
+                    scan.run_start[c] = frame;
+                    scan.run_owned[c] = frame < end_frame;
+                    scan.owned_count += scan.run_owned[c];
+                }
+            }
+        }
+
+        // The end of the wave closes the runs still open
+        for (c = 0; (frame == total) && (c < channels); ++c)
+            Wave_FaultCloseRun(&scan, c, total, total);
+
+        // Runs are reported when they end, the order of their starts is restored
+        if (out_events)
+            qsort(out_events, (scan.event_count < max_events) ? scan.event_count : max_events, sizeof(WAVE_FAULT_EVENT), Wave_CompareFaultEvents);
+
+        if (out_event_count)
+            *out_event_count = scan.event_count;
+        return 1;
+    }
+
+    int Wave_DetectFaultsBatch(WAVE* waves, size_t wave_count, WAVE_FAULT_EVENT* out_events, size_t max_events, size_t* out_event_counts)
+    {
+        if ((!waves) || ((max_events) && (!out_events)))
+            return 0;
+
+        size_t stored = 0;
+        size_t i;
+        int result = 1;
+        for (i = 0; i < wave_count; ++i)
+        {
+            size_t found = 0;
+            if (!Wave_DetectFaults(&waves[i], 0, Wave_GetFrameCount(&waves[i]), out_events ? out_events + stored : NULL, max_events - stored, &found))
+                result = 0;
+
+            if (out_event_counts)
+                out_event_counts[i] = found;
+            stored += (found < max_events - stored) ? found : max_events - stored;
+        }
+
+        return result;
+    }
+
+
+    // Mono downmix averaged over decimation frames, positions outside the wave are silent
+    static void Wave_ReadDecimated(WAVE* wave, int64_t first, size_t count, size_t decimation, float* out_samples)
+    {
+        float temp[WAVE_ALIGN_MAX_DECIMATION];
+        size_t chunk = sizeof(temp) / sizeof(float) / decimation;
+        float scale = 1.0f / (float)decimation;
+
+        while ((count) && (first < 0))
+        {
+            *out_samples++ = 0.0f;
+            first++;
+            count--;
+        }
+
+        while (count)
+        {
+            size_t n = (count < chunk) ? count : chunk;
+            Wave_ReadMono(wave, (size_t)first * decimation, n * decimation, temp);
+
+            size_t i, j;
+            for (i = 0; i < n; ++i)
+            {
+                float sum = 0.0f;
+                for (j = 0; j < decimation; ++j)
+                    sum += temp[i * decimation + j];
+                out_samples[i] = sum * scale;
+            }
+
+            first += n;
+            out_samples += n;
+            count -= n;
+        }
+    }
+
+    int Wave_AlignInit(WAVE_ALIGN* align, WAVE* a, WAVE* b, size_t max_lag, size_t decimation, WAVE_ALLOCATOR* allocator)
+    {
+        if (!align)
+            return 0;
+
+        memset(align, 0, sizeof(WAVE_ALIGN));
+        if ((!a) || (!b) || (!a->sample_data) || (!b->sample_data))
+            return 0;
+        if ((Wave_GetChannelCount(a) <= 0) || (Wave_GetChannelCount(a) > WAVE_MAX_CHANNELS))
+            return 0;
+        if ((Wave_GetChannelCount(b) <= 0) || (Wave_GetChannelCount(b) > WAVE_MAX_CHANNELS))
+            return 0;
+        if ((!decimation) || (decimation > WAVE_ALIGN_MAX_DECIMATION))
+            return 0;
+        if (!allocator)
+            allocator = Wave_GetDefaultAllocator();
+
+        align->allocator = *allocator;
+        align->a = a;
+        align->b = b;
+        align->decimation = decimation;
+        align->max_lag = (max_lag + decimation - 1) / decimation;
+
+        // Segments leave room for every lag so the circular correlation never wraps
+        align->fft_size = WAVE_ALIGN_MIN_FFT_SIZE;
+        while (align->fft_size < 4 * align->max_lag + 4)
+            align->fft_size *= 2;
+        align->segment_frames = align->fft_size - 2 * align->max_lag;
+
+        size_t frame_count = (Wave_GetFrameCount(a) + decimation - 1) / decimation;
+        align->segment_count = (frame_count + align->segment_frames - 1) / align->segment_frames;
+        align->block_count = (align->segment_count + WAVE_ALIGN_BLOCK_SEGMENTS - 1) / WAVE_ALIGN_BLOCK_SEGMENTS;
+
+        size_t correlation_size = Wave_AlignGetBlockLength(align) * sizeof(double);
+        align->free_ptr_size = correlation_size + align->fft_size * sizeof(float);
+        align->free_ptr = allocator->allocate(allocator->data, align->free_ptr_size);
+        if (!align->free_ptr)
+            return 0;
+
+        align->correlation = (double*)align->free_ptr;
+        align->twiddles = (float*)((char*)align->free_ptr + correlation_size);
+        memset(align->correlation, 0, correlation_size);
+        return Wave_FFTTwiddles(align->twiddles, align->fft_size);
+    }
+
+    size_t Wave_AlignGetBlockLength(const WAVE_ALIGN* align)
+    {
+        if (!align)
+            return 0;
+
+        return 2 * align->max_lag + 3;
+    }
+
+    int Wave_AlignComputeBlock(const WAVE_ALIGN* align, size_t block, double* out_block)
+    {
+        if ((!align) || (!align->correlation) || (!out_block) || (block >= align->block_count))
+            return 0;
+
+        size_t size = align->fft_size;
+        size_t lags = 2 * align->max_lag + 1;
+        size_t scratch_size = size * 2 * sizeof(float);
+        float* real = (float*)align->allocator.allocate(align->allocator.data, scratch_size);
+        if (!real)
+            return 0;
+        float* imag = real + size;
+
+        memset(out_block, 0, Wave_AlignGetBlockLength(align) * sizeof(double));
+
+        size_t segment = block * WAVE_ALIGN_BLOCK_SEGMENTS;
+        size_t end = segment + WAVE_ALIGN_BLOCK_SEGMENTS;
+        if (end > align->segment_count)
+            end = align->segment_count;
+
+        for (; segment < end; ++segment)
+        {
+            // Both real signals share one complex transform, a in the real part and b in the imaginary part
+            int64_t start = (int64_t)(segment * align->segment_frames);
+            size_t window = align->segment_frames + 2 * align->max_lag;
+            Wave_ReadDecimated(align->a, start, align->segment_frames, align->decimation, real);
+            Wave_ReadDecimated(align->b, start - (int64_t)align->max_lag, window, align->decimation, imag);
+            memset(real + align->segment_frames, 0, (size - align->segment_frames) * sizeof(float));
+            memset(imag + window, 0, (size - window) * sizeof(float));
+
+            size_t i;
+            double energy_a = 0.0, energy_b = 0.0;
+            for (i = 0; i < align->segment_frames; ++i)
+            {
+                energy_a += (double)real[i] * real[i];
+                energy_b += (double)imag[i + align->max_lag] * imag[i + align->max_lag];
+            }
+
+            Wave_FFTWithTwiddles(real, imag, size, 0, align->twiddles);
+
+            // Split the spectra and form conj(A) * B, the spectrum of a real signal is mirrored
+            for (i = 0; i <= size / 2; ++i)
+            {
+                size_t m = (size - i) & (size - 1);
+                float ar = 0.5f * (real[i] + real[m]);
+                float ai = 0.5f * (imag[i] - imag[m]);
+                float br = 0.5f * (imag[i] + imag[m]);
+                float bi = -0.5f * (real[i] - real[m]);
+                float cr = ar * br + ai * bi;
+                float ci = ar * bi - ai * br;
+                real[i] = cr;
+                imag[i] = ci;
+                real[m] = cr;
+                imag[m] = -ci;
+            }
+
+            Wave_FFTWithTwiddles(real, imag, size, 1, align->twiddles);
+
+            float scale = 1.0f / (float)size;
+            for (i = 0; i < lags; ++i)
+                out_block[i] += real[i] * scale;
+            out_block[lags] += energy_a;
+            out_block[lags + 1] += energy_b;
+        }
+
+        align->allocator.free(align->allocator.data, real, scratch_size);
+        return 1;
+    }
+
+    int Wave_AlignAccumulate(WAVE_ALIGN* align, size_t block, const double* block_result)
+    {
+        if ((!align) || (!align->correlation) || (!block_result))
+            return 0;
+        if (block != align->blocks_accumulated)
+            return 0;
+
+        size_t length = Wave_AlignGetBlockLength(align);
+        size_t i;
+        for (i = 0; i < length; ++i)
+            align->correlation[i] += block_result[i];
+
+        align->blocks_accumulated++;
+        return 1;
+    }
+
+    int Wave_AlignGetResult(const WAVE_ALIGN* align, WAVE_ALIGN_RESULT* out_result)
+    {
+        if ((!align) || (!align->correlation) || (!out_result))
+            return 0;
+
+        const double* correlation = align->correlation;
+        size_t lags = 2 * align->max_lag + 1;
+        size_t best = 0;
+        size_t i;
+        for (i = 1; i < lags; ++i)
+        {
+            if (correlation[i] > correlation[best])
+                best = i;
+        }
+
+        // Vertex of the parabola through the peak and its neighbours
+        double offset = 0.0;
+        if ((best > 0) && (best + 1 < lags))
+        {
+            double left = correlation[best - 1];
+            double center = correlation[best];
+            double right = correlation[best + 1];
+            double curvature = left - 2.0 * center + right;
+            if (curvature < 0.0)
+                offset = 0.5 * (left - right) / curvature;
+        }
+
+        double energy = sqrt(correlation[lags] * correlation[lags + 1]);
+        out_result->lag = ((double)best - (double)align->max_lag + offset) * (double)align->decimation;
+        out_result->correlation = (energy > 0.0) ? (float)(correlation[best] / energy) : 0.0f;
+        return 1;
+    }
+
+    int Wave_AlignFree(WAVE_ALIGN* align)
+    {
+        if (!align)
+            return 0;
+
+        if (align->free_ptr)
+            align->allocator.free(align->allocator.data, align->free_ptr, align->free_ptr_size);
+        memset(align, 0, sizeof(WAVE_ALIGN));
+        return 1;
+    }
+
+    int Wave_AlignWaves(WAVE* a, WAVE* b, size_t max_lag, size_t decimation, WAVE_ALIGN_RESULT* out_result, WAVE_ALLOCATOR* allocator)
+    {
+        if (!out_result)
+            return 0;
+
+        WAVE_ALIGN align;
+        if (!Wave_AlignInit(&align, a, b, max_lag, decimation, allocator))
+        {
+            Wave_AlignFree(&align);
+            return 0;
+        }
+
+        size_t block_size = Wave_AlignGetBlockLength(&align) * sizeof(double);
+        double* block_result = (double*)align.allocator.allocate(align.allocator.data, block_size);
+        int result = block_result != NULL;
+
+        size_t block;
+        for (block = 0; (result) && (block < align.block_count); ++block)
+            result = Wave_AlignComputeBlock(&align, block, block_result) && Wave_AlignAccumulate(&align, block, block_result);
+
+        if (block_result)
+            align.allocator.free(align.allocator.data, block_result, block_size);
+        if (result)
+            result = Wave_AlignGetResult(&align, out_result);
+
+        Wave_AlignFree(&align);
+        return result;
+    }
+#endif // SIMPLE_WAVE_NO_DSP
+
+#endif // SIMPLE_WAVE_IMPLEMENTATION
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,154 @@
+// Throughput baseline of the hot paths, single threaded.
+// Run without arguments to print the numbers, or with --check <baseline file> [tolerance] to fail when a path
+// runs more than tolerance (default 4) times slower than the recorded baseline.
+
+#define SIMPLE_WAVE_IMPLEMENTATION
+#include "simple_wave.h"
+
+#include "test.h"
+
+#include <time.h>
+
+#define BENCH_FRAMES (1 << 18)
+#define BENCH_CHANNELS 2
+#define BENCH_SECONDS 0.2
+
+typedef struct BENCH_RESULT
+{
+    const char* name;
+    double value; // MB/s of float samples, higher is better
+} BENCH_RESULT;
+
+static double Bench_Now(void)
+{
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+}
+
+static float bench_floats[BENCH_FRAMES * BENCH_CHANNELS];
+static int16_t bench_s16[BENCH_FRAMES * BENCH_CHANNELS];
+
+// Every bench processes the same BENCH_FRAMES stereo frames per iteration
+#define BENCH_RUN(result, label, body)                                                            \
+    do                                                                                            \
+    {                                                                                             \
+        BENCH_RESULT* bench_result = (result);                                                    \
+        size_t iterations = 0;                                                                    \
+        double start = Bench_Now();                                                               \
+        double elapsed;                                                                           \
+        do                                                                                        \
+        {                                                                                         \
+            body;                                                                                 \
+            ++iterations;                                                                         \
+            elapsed = Bench_Now() - start;                                                        \
+        } while (elapsed < BENCH_SECONDS);                                                        \
+        bench_result->name = (label);                                                             \
+        bench_result->value = (double)iterations * sizeof(bench_floats) / (1024.0 * 1024.0) / elapsed; \
+    } while (0)
+
+static size_t Bench_Run(BENCH_RESULT* results)
+{
+    size_t count = 0;
+    size_t i;
+
+    for (i = 0; i < BENCH_FRAMES * BENCH_CHANNELS; ++i)
+        bench_floats[i] = Test_RandomFloat() * 0.5f;
+    Wave_ConvertFromFloat(bench_floats, BENCH_FRAMES * BENCH_CHANNELS, WAVE_SAMPLE_FORMAT_S16, bench_s16);
+
+    BENCH_RUN(&results[count++], "convert_to_float_s16", Wave_ConvertToFloat(bench_s16, WAVE_SAMPLE_FORMAT_S16, BENCH_FRAMES * BENCH_CHANNELS, bench_floats));
+    BENCH_RUN(&results[count++], "convert_from_float_s16", Wave_ConvertFromFloat(bench_floats, BENCH_FRAMES * BENCH_CHANNELS, WAVE_SAMPLE_FORMAT_S16, bench_s16));
+
+    WAVE_HASH hash;
+    BENCH_RUN(&results[count++], "hash", (Wave_HashBegin(&hash), Wave_HashUpdate(&hash, bench_floats, sizeof(bench_floats)), (void)Wave_HashEnd(&hash)));
+
+    // A wav in memory and on disk for the parse, reader and writer paths
+    FILE* file = tmpfile();
+    WAVE_WRITER writer;
+    if ((!file) || (!Wave_WriterBegin(&writer, file, WAVE_SAMPLE_FORMAT_S16, BENCH_CHANNELS, 48000)) || (!Wave_WriterWrite(&writer, bench_s16, BENCH_FRAMES)) || (!Wave_WriterEnd(&writer)))
+        return count;
+
+    long size = 0;
+    void* buffer = Test_ReadAll(file, &size);
+    WAVE wave;
+    if ((!buffer) || (!Wave_ParseBuffer(buffer, (size_t)size, &wave)))
+        return count;
+
+    BENCH_RUN(&results[count++], "read_frames_float_s16", Wave_ReadFramesFloat(&wave, 0, BENCH_FRAMES, bench_floats));
+
+    // Levels of the same wave, streamed and as per-block partials combined in order
+    WAVE_LEVELS_STATE levels_state;
+    WAVE_LEVELS levels;
+    static WAVE_LEVELS blocks[BENCH_FRAMES / WAVE_LEVELS_BLOCK_FRAMES];
+    BENCH_RUN(&results[count++], "levels_s16", (Wave_LevelsBegin(&levels_state, BENCH_CHANNELS), Wave_LevelsProcessWave(&levels_state, &wave), Wave_LevelsGetResult(&levels_state, &levels)));
+    BENCH_RUN(&results[count++], "levels_blocks_s16",
+              (Wave_LevelsComputeBlocks(&wave, 0, BENCH_FRAMES / WAVE_LEVELS_BLOCK_FRAMES, blocks), Wave_LevelsBegin(&levels_state, BENCH_CHANNELS),
+               Wave_LevelsCombine(&levels_state, blocks, BENCH_FRAMES / WAVE_LEVELS_BLOCK_FRAMES), Wave_LevelsGetResult(&levels_state, &levels)));
+
+    WAVE_READER reader;
+    BENCH_RUN(&results[count++], "reader_float_s16",
+              (fseek(file, 0, SEEK_SET), Wave_ReaderOpen(&reader, file, size, NULL), (void)Wave_ReaderReadFloat(&reader, bench_floats, BENCH_FRAMES), Wave_ReaderClose(&reader, NULL)));
+
+    FILE* output = tmpfile();
+    if (output)
+    {
+        BENCH_RUN(&results[count++], "writer_float_s16",
+                  (fseek(output, 0, SEEK_SET), Wave_WriterBegin(&writer, output, WAVE_SAMPLE_FORMAT_S16, BENCH_CHANNELS, 48000), Wave_WriterWriteFloat(&writer, bench_floats, BENCH_FRAMES), Wave_WriterEnd(&writer)));
+        fclose(output);
+    }
+
+    free(buffer);
+    fclose(file);
+    return count;
+}
+
+static int Bench_Check(const BENCH_RESULT* results, size_t count, const char* path, double tolerance)
+{
+    FILE* file = fopen(path, "r");
+    char name[64];
+    double baseline;
+    int failed = 0;
+
+    if (!file)
+    {
+        fprintf(stderr, "cannot open the baseline %s\n", path);
+        return 1;
+    }
+
+    while (fscanf(file, "%63s %lf", name, &baseline) == 2)
+    {
+        size_t i;
+        for (i = 0; i < count; ++i)
+        {
+            if (strcmp(results[i].name, name) != 0)
+                continue;
+            if (results[i].value * tolerance < baseline)
+            {
+                fprintf(stderr, "%s regressed: %.1f MB/s, baseline %.1f MB/s\n", name, results[i].value, baseline);
+                failed = 1;
+            }
+            break;
+        }
+        if (i == count)
+        {
+            fprintf(stderr, "%s has a baseline but was not measured\n", name);
+            failed = 1;
+        }
+    }
+
+    fclose(file);
+    return failed;
+}
+
+int main(int argc, char** argv)
+{
+    BENCH_RESULT results[16];
+    size_t count = Bench_Run(results);
+    size_t i;
+
+    for (i = 0; i < count; ++i)
+        printf("%s %.1f\n", results[i].name, results[i].value);
+
+    if ((argc >= 3) && (strcmp(argv[1], "--check") == 0))
+        return Bench_Check(results, count, argv[2], (argc >= 4) ? atof(argv[3]) : 4.0);
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+// Conversion throughput for every pair of worker node and buffer node, plus a buffer interleaved across the nodes.
+// On a multi-node machine the diagonal (local memory) should beat the other cells, run it pinned to an otherwise idle machine.
+
+#define SIMPLE_WAVE_NUMA
+#define SIMPLE_WAVE_IMPLEMENTATION
+#include "simple_wave.h"
+
+#include "test.h"
+
+#include <time.h>
+
+#define BENCH_SAMPLES (1 << 24)
+#define BENCH_SECONDS 0.5
+
+static double Bench_Now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+// MB/s of S16 samples converted to floats, both buffers allocated with the allocator
+static double Bench_Convert(WAVE_ALLOCATOR* allocator)
+{
+    int16_t* samples = (int16_t*)allocator->allocate(allocator->data, BENCH_SAMPLES * sizeof(int16_t));
+    float* floats = (float*)allocator->allocate(allocator->data, BENCH_SAMPLES * sizeof(float));
+    if ((!samples) || (!floats))
+        return 0.0;
+
+    size_t i;
+    for (i = 0; i < BENCH_SAMPLES; ++i)
+        samples[i] = (int16_t)Test_Random();
+
+    size_t iterations = 0;
+    double start = Bench_Now();
+    double elapsed;
+    do
+    {
+        Wave_ConvertToFloat(samples, WAVE_SAMPLE_FORMAT_S16, BENCH_SAMPLES, floats);
+        ++iterations;
+        elapsed = Bench_Now() - start;
+    } while (elapsed < BENCH_SECONDS);
+
+    allocator->free(allocator->data, floats, BENCH_SAMPLES * sizeof(float));
+    allocator->free(allocator->data, samples, BENCH_SAMPLES * sizeof(int16_t));
+    return (double)iterations * BENCH_SAMPLES * sizeof(int16_t) / (1024.0 * 1024.0) / elapsed;
+}
+
+int main(void)
+{
+    int nodes = Wave_NumaGetNodeCount();
+    int worker, memory;
+
+    printf("%d node(s), rows are the worker node, columns the buffer node, MB/s\n", nodes);
+    if (nodes < 2)
+        printf("single node machine, only the local cell is measured\n");
+
+    printf("worker");
+    for (memory = 0; memory < nodes; ++memory)
+        printf(" %9d", memory);
+    printf(" interleave\n");
+
+    for (worker = 0; worker < nodes; ++worker)
+    {
+        WAVE_NUMA_POLICY policy;
+        WAVE_ALLOCATOR allocator;
+
+        if (!Wave_NumaBindThread(worker))
+            printf("cannot bind to node %d, results are not placed\n", worker);
+
+        printf("%6d", worker);
+        for (memory = 0; memory < nodes; ++memory)
+        {
+            if (!Wave_NumaGetAllocator(&policy, memory, &allocator))
+                return 1;
+            printf(" %9.1f", Bench_Convert(&allocator));
+        }
+
+        // A negative node interleaves the pages across every node
+        if (!Wave_NumaGetAllocator(&policy, -1, &allocator))
+            return 1;
+        printf(" %10.1f\n", Bench_Convert(&allocator));
+    }
+
+    return 0;
+}
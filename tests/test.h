@@ -0,0 +1,79 @@
+#pragma once
+
+// Minimal helpers shared by the tests, every test is a standalone program returning non zero on failure
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TEST_UNUSED __attribute__((unused))
+#else
+#define TEST_UNUSED
+#endif
+
+static int test_failures TEST_UNUSED = 0;
+
+#define TEST_CHECK(cond)                                                                  \
+    do                                                                                    \
+    {                                                                                     \
+        if (!(cond))                                                                      \
+        {                                                                                 \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);      \
+            ++test_failures;                                                              \
+        }                                                                                 \
+    } while (0)
+
+#define TEST_RESULT() ((test_failures == 0) ? 0 : (fprintf(stderr, "%d checks failed\n", test_failures), 1))
+
+// Deterministic xorshift, tests must not depend on the C library rand
+static uint32_t test_random_state = 0x12345678u;
+
+static TEST_UNUSED uint32_t Test_Random(void)
+{
+    test_random_state ^= test_random_state << 13;
+    test_random_state ^= test_random_state >> 17;
+    test_random_state ^= test_random_state << 5;
+    return test_random_state;
+}
+
+// Returns a float in [-1, 1) with at most 24 significant bits
+static TEST_UNUSED float Test_RandomFloat(void)
+{
+    return (float)(int32_t)(Test_Random() & 0xFFFFFF) * (1.0f / 8388608.0f) - 1.0f;
+}
+
+// Reads the whole stream into a malloc'ed buffer and rewinds it
+static TEST_UNUSED void* Test_ReadAll(FILE* file, long* out_size)
+{
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    void* buffer = malloc(size > 0 ? (size_t)size : 1);
+    if ((buffer) && (size > 0) && (fread(buffer, 1, (size_t)size, file) != (size_t)size))
+    {
+        free(buffer);
+        buffer = NULL;
+    }
+
+    fseek(file, 0, SEEK_SET);
+    *out_size = size;
+    return buffer;
+}
+
+// Opens a temporary stream holding the given bytes, positioned at the start
+static TEST_UNUSED FILE* Test_OpenBytes(const void* bytes, size_t size)
+{
+    FILE* file = tmpfile();
+    if (!file)
+        return NULL;
+    if ((size) && (fwrite(bytes, 1, size, file) != size))
+    {
+        fclose(file);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_SET);
+    return file;
+}
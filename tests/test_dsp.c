@@ -0,0 +1,426 @@
+// Behavior of the DSP subsystem on signals with a known answer
+
+#define SIMPLE_WAVE_IMPLEMENTATION
+#include "simple_wave.h"
+
+#include "test.h"
+
+#define TEST_PI 3.14159265358979323846
+
+// A float wave parsed from a buffer the caller frees
+static void* Test_MakeWave(const float* frames, size_t frame_count, int channels, int samples_per_sec, WAVE* out_wave)
+{
+    FILE* file = tmpfile();
+    WAVE_WRITER writer;
+    long size = 0;
+
+    TEST_CHECK(Wave_WriterBegin(&writer, file, WAVE_SAMPLE_FORMAT_F32, channels, samples_per_sec));
+    TEST_CHECK(Wave_WriterWriteFloat(&writer, frames, frame_count));
+    TEST_CHECK(Wave_WriterEnd(&writer));
+
+    void* buffer = Test_ReadAll(file, &size);
+    TEST_CHECK(Wave_ParseBuffer(buffer, (size_t)size, out_wave));
+    fclose(file);
+    return buffer;
+}
+
+// Clip mix computed frame by frame, in clip order like the renderer
+static void Test_MixReference(const WAVE_CLIP* clip, const float* source, int source_channels, float* out_frames, int channels)
+{
+    size_t i;
+    int c;
+    for (i = 0; i < clip->frame_count; ++i)
+    {
+        float gain = clip->gain;
+        if (i < clip->fade_in_frames)
+            gain *= (float)i / (float)clip->fade_in_frames;
+        if (clip->frame_count - i <= clip->fade_out_frames)
+            gain *= (float)(clip->frame_count - i - 1) / (float)clip->fade_out_frames;
+
+        const float* src = source + (clip->source_frame + i) * (size_t)source_channels;
+        float* dst = out_frames + (clip->position + i) * (size_t)channels;
+        for (c = 0; c < channels; ++c)
+            dst[c] += ((source_channels == 1) ? src[0] : src[c]) * gain;
+    }
+}
+
+static void Test_Timeline(void)
+{
+    enum { mono_frames = 3000, stereo_frames = 12000, total = 15000 };
+    float* mono = (float*)malloc(mono_frames * sizeof(float));
+    float* stereo = (float*)malloc(stereo_frames * 2 * sizeof(float));
+    float* expected = (float*)calloc(total * 2, sizeof(float));
+    float* rendered = (float*)malloc(total * 2 * sizeof(float));
+    float* slabs = (float*)malloc(total * 2 * sizeof(float));
+    size_t i;
+
+    for (i = 0; i < mono_frames; ++i)
+        mono[i] = Test_RandomFloat() * 0.5f;
+    for (i = 0; i < stereo_frames * 2; ++i)
+        stereo[i] = Test_RandomFloat() * 0.5f;
+
+    WAVE mono_wave, stereo_wave;
+    void* mono_buffer = Test_MakeWave(mono, mono_frames, 1, 48000, &mono_wave);
+    void* stereo_buffer = Test_MakeWave(stereo, stereo_frames, 2, 48000, &stereo_wave);
+
+    // Overlapping clips crossing index buckets, with fades and a mono source spread on both channels
+    WAVE_CLIP clips[4];
+    memset(clips, 0, sizeof(clips));
+    clips[0].wave = &stereo_wave; clips[0].position = 300;  clips[0].source_frame = 0;   clips[0].frame_count = 11000; clips[0].gain = 1.0f; clips[0].fade_in_frames = 100; clips[0].fade_out_frames = 50;
+    clips[1].wave = &mono_wave;   clips[1].position = 100;  clips[1].source_frame = 10;  clips[1].frame_count = 2500;  clips[1].gain = 0.5f;
+    clips[2].wave = &mono_wave;   clips[2].position = 4090; clips[2].source_frame = 0;   clips[2].frame_count = 3000;  clips[2].gain = -0.25f; clips[2].fade_out_frames = 3000;
+    clips[3].wave = &stereo_wave; clips[3].position = 13000; clips[3].source_frame = 10000; clips[3].frame_count = 2000; clips[3].gain = 2.0f;
+    for (i = 0; i < 4; ++i)
+        Test_MixReference(&clips[i], (clips[i].wave == &mono_wave) ? mono : stereo, Wave_GetChannelCount(clips[i].wave), expected, 2);
+
+    WAVE_TIMELINE timeline;
+    TEST_CHECK(Wave_TimelineInit(&timeline, clips, 4, 2, NULL));
+    TEST_CHECK(timeline.frame_count == total);
+    TEST_CHECK(Wave_TimelineRender(&timeline, 0, total, rendered));
+    for (i = 0; i < total * 2; ++i)
+    {
+        float error = rendered[i] - expected[i];
+        if ((error > 1e-6f) || (error < -1e-6f))
+            break;
+    }
+    TEST_CHECK(i == total * 2);
+
+    // Slabs rendered separately give the same samples, and frames past the end are silent
+    size_t slab, first, count;
+    for (slab = 0; slab < 3; ++slab)
+    {
+        TEST_CHECK(Wave_TimelineGetSlab(&timeline, slab, 3, &first, &count));
+        TEST_CHECK(Wave_TimelineRender(&timeline, first, count, slabs + first * 2));
+    }
+    TEST_CHECK(memcmp(slabs, rendered, total * 2 * sizeof(float)) == 0);
+    TEST_CHECK(Wave_TimelineRender(&timeline, total - 10, 20, slabs));
+    TEST_CHECK(memcmp(slabs, rendered + (total - 10) * 2, 10 * 2 * sizeof(float)) == 0);
+    for (i = 20; i < 40; ++i)
+        TEST_CHECK(slabs[i] == 0.0f);
+
+    // The writer receives the same frames
+    FILE* file = tmpfile();
+    WAVE_WRITER writer;
+    WAVE mix;
+    long size = 0;
+    TEST_CHECK(Wave_WriterBegin(&writer, file, WAVE_SAMPLE_FORMAT_F32, 2, 48000));
+    TEST_CHECK(Wave_TimelineRenderToWriter(&timeline, &writer, NULL));
+    TEST_CHECK(Wave_WriterEnd(&writer));
+    void* mix_buffer = Test_ReadAll(file, &size);
+    TEST_CHECK(Wave_ParseBuffer(mix_buffer, (size_t)size, &mix));
+    TEST_CHECK((Wave_GetFrameCount(&mix) == total) && (memcmp(mix.sample_data, rendered, total * 2 * sizeof(float)) == 0));
+    TEST_CHECK(Wave_TimelineFree(&timeline, NULL));
+
+    // Clips running past their source or past the largest frame index are rejected
+    WAVE_CLIP bad = clips[1];
+    bad.source_frame = (size_t)-1;
+    TEST_CHECK(!Wave_TimelineInit(&timeline, &bad, 1, 2, NULL));
+    bad = clips[1];
+    bad.position = (size_t)-1 - 10;
+    TEST_CHECK(!Wave_TimelineInit(&timeline, &bad, 1, 2, NULL));
+
+    free(mix_buffer);
+    fclose(file);
+    free(stereo_buffer);
+    free(mono_buffer);
+    free(slabs);
+    free(rendered);
+    free(expected);
+    free(stereo);
+    free(mono);
+}
+
+// BS.1770 true peak of an fs/4 sine sampled 45 degrees off its crests, within the EBU Tech 3341 tolerance
+static void Test_TruePeak(void)
+{
+    enum { frame_count = 4800 };
+    float* frames = (float*)calloc(frame_count, sizeof(float));
+    WAVE_TRUE_PEAK meter;
+    size_t i, frame = 0;
+
+    // Samples reach 0.5 * sqrt(0.5), about -9 dBFS, while the signal between them reaches 0.5, about -6 dBFS
+    for (i = 0; i < frame_count; ++i)
+        frames[i] = 0.5f * (float)sin(TEST_PI * 0.5 * (double)i + TEST_PI * 0.25);
+    TEST_CHECK(Wave_TruePeakInit(&meter, 1));
+    TEST_CHECK(Wave_TruePeakProcess(&meter, frames, frame_count));
+    TEST_CHECK(Wave_TruePeakFinish(&meter));
+    float expected = (float)(20.0 * log10(0.5));
+    float decibels = Wave_TruePeakGetDecibels(&meter, 0, &frame);
+    TEST_CHECK((decibels < expected + 0.2f) && (decibels > expected - 0.4f));
+    TEST_CHECK(frame < frame_count);
+
+    // An impulse is reported at its own frame
+    memset(frames, 0, frame_count * sizeof(float));
+    frames[1000] = -0.5f;
+    TEST_CHECK(Wave_TruePeakInit(&meter, 1));
+    TEST_CHECK(Wave_TruePeakProcess(&meter, frames, frame_count));
+    TEST_CHECK(Wave_TruePeakFinish(&meter));
+    Wave_TruePeakGetDecibels(&meter, 0, &frame);
+    TEST_CHECK(frame == 1000);
+
+    // An impulse on the last frame only reaches the main tap in Finish, and is reported at the last frame
+    memset(frames, 0, frame_count * sizeof(float));
+    frames[frame_count - 1] = 0.5f;
+    TEST_CHECK(Wave_TruePeakInit(&meter, 1));
+    TEST_CHECK(Wave_TruePeakProcess(&meter, frames, frame_count));
+    TEST_CHECK(Wave_TruePeakGetDecibels(&meter, 0, NULL) < expected - 6.0f);
+    TEST_CHECK(Wave_TruePeakFinish(&meter));
+    decibels = Wave_TruePeakGetDecibels(&meter, 0, &frame);
+    TEST_CHECK((decibels < expected + 0.2f) && (decibels > expected - 0.4f));
+    TEST_CHECK(frame == frame_count - 1);
+
+    free(frames);
+}
+
+// Decaying noise bursts on silence are found on the hop grid just before they start, and once each
+static void Test_Onsets(void)
+{
+    enum { frame_count = 96000, burst_frames = 4000, size = 1024 };
+    static const size_t bursts[4] = { 10000, 30000, 51234, 70000 };
+    float* frames = (float*)calloc(frame_count, sizeof(float));
+    size_t onsets[16], count = 0, first_count = 0, i, b;
+
+    for (b = 0; b < 4; ++b)
+        for (i = 0; i < burst_frames; ++i)
+            frames[bursts[b] + i] = Test_RandomFloat() * 0.8f * expf(-(float)i / 800.0f);
+
+    WAVE wave;
+    void* buffer = Test_MakeWave(frames, frame_count, 1, 48000, &wave);
+    TEST_CHECK(Wave_DetectOnsets(&wave, 0, frame_count, 0.05f, onsets, 16, &count));
+    TEST_CHECK(count == 4);
+    for (b = 0; (b < 4) && (b < count); ++b)
+        TEST_CHECK((onsets[b] <= bursts[b]) && (bursts[b] - onsets[b] < WAVE_ONSET_HOP_SIZE));
+
+    // Two ranges give the onsets of the single pass
+    size_t split[16];
+    TEST_CHECK(Wave_DetectOnsets(&wave, 0, 40000, 0.05f, split, 16, &first_count));
+    TEST_CHECK(Wave_DetectOnsets(&wave, 40000, frame_count - 40000, 0.05f, split + first_count, 16 - first_count, &count));
+    TEST_CHECK((first_count + count == 4) && (memcmp(split, onsets, 4 * sizeof(size_t)) == 0));
+
+    // Precomputed twiddles give the transform of Wave_FFT, and the inverse restores the input scaled by size
+    float input[size], real[size], imag[size], twiddle_real[size], twiddle_imag[size], twiddles[size];
+    for (i = 0; i < size; ++i)
+    {
+        input[i] = real[i] = twiddle_real[i] = Test_RandomFloat();
+        imag[i] = twiddle_imag[i] = 0.0f;
+    }
+    TEST_CHECK(Wave_FFTTwiddles(twiddles, size));
+    TEST_CHECK(Wave_FFT(real, imag, size, 0));
+    TEST_CHECK(Wave_FFTWithTwiddles(twiddle_real, twiddle_imag, size, 0, twiddles));
+    for (i = 0; i < size; ++i)
+        if ((fabsf(real[i] - twiddle_real[i]) > 1e-3f) || (fabsf(imag[i] - twiddle_imag[i]) > 1e-3f))
+            break;
+    TEST_CHECK(i == size);
+    TEST_CHECK(Wave_FFTWithTwiddles(twiddle_real, twiddle_imag, size, 1, twiddles));
+    for (i = 0; i < size; ++i)
+        if ((fabsf(twiddle_real[i] / (float)size - input[i]) > 1e-5f) || (fabsf(twiddle_imag[i] / (float)size) > 1e-5f))
+            break;
+    TEST_CHECK(i == size);
+    TEST_CHECK(!Wave_FFTTwiddles(twiddles, 1000));
+
+    free(buffer);
+    free(frames);
+}
+
+// 44.1k and 48k converted both ways give the exact frame count and the same sine, aligned, whatever the block split
+static void Test_Resample(void)
+{
+    static const uint32_t rates[2][2] = { { 44100, 48000 }, { 48000, 44100 } };
+    enum { seconds = 2, extra = 37, tone = 1000 };
+    WAVE_RESAMPLE_CACHE cache;
+    size_t r, i;
+
+    TEST_CHECK(Wave_ResampleCacheInit(&cache));
+    for (r = 0; r < 2; ++r)
+    {
+        uint32_t in_rate = rates[r][0], out_rate = rates[r][1];
+        size_t frame_count = in_rate * seconds + extra;
+        float* frames = (float*)malloc(frame_count * 2 * sizeof(float));
+        for (i = 0; i < frame_count; ++i)
+        {
+            frames[i * 2] = 0.5f * (float)sin(2.0 * TEST_PI * tone * (double)i / in_rate);
+            frames[i * 2 + 1] = -frames[i * 2];
+        }
+
+        const WAVE_RESAMPLE_TABLE* table = NULL;
+        const WAVE_RESAMPLE_TABLE* again = NULL;
+        TEST_CHECK(Wave_ResampleCacheGet(&cache, in_rate, out_rate, 0, &table, NULL));
+        TEST_CHECK(Wave_ResampleCacheGet(&cache, in_rate * 2, out_rate * 2, 0, &again, NULL));
+        TEST_CHECK((table != NULL) && (table == again) && (cache.count == r + 1));
+
+        uint64_t expected = ((uint64_t)frame_count * out_rate + in_rate - 1) / in_rate;
+        TEST_CHECK(Wave_ResampleGetOutputLength(table, frame_count) == expected);
+
+        // Uneven blocks, some shorter than the filter
+        WAVE_RESAMPLER resampler;
+        float* out = (float*)malloc(((size_t)expected + 1) * 2 * sizeof(float));
+        size_t at = 0, written = 0, block = 1;
+        TEST_CHECK(Wave_ResamplerInit(&resampler, table, 2, NULL));
+        while (at < frame_count)
+        {
+            size_t count = (block < frame_count - at) ? block : frame_count - at;
+            TEST_CHECK(Wave_ResamplerGetMaxOutput(&resampler, count) + written <= expected);
+            written += Wave_ResamplerProcess(&resampler, frames + at * 2, count, out + written * 2);
+            at += count;
+            block = block * 3 + 7;
+        }
+        written += Wave_ResamplerFinish(&resampler, out + written * 2);
+        TEST_CHECK(written == expected);
+        TEST_CHECK(Wave_ResamplerFree(&resampler, NULL));
+
+        // Away from the edges every output frame is the sine sampled at the new rate, same frequency, amplitude and phase
+        double in_phase = 0.0, quadrature = 0.0, error = 0.0;
+        size_t first = out_rate / 10, last = written - out_rate / 10;
+        for (i = first; i < last; ++i)
+        {
+            double angle = 2.0 * TEST_PI * tone * (double)i / out_rate;
+            in_phase += out[i * 2] * sin(angle);
+            quadrature += out[i * 2] * cos(angle);
+            if (fabs(out[i * 2] - 0.5 * sin(angle)) > error)
+                error = fabs(out[i * 2] - 0.5 * sin(angle));
+            if (out[i * 2] != -out[i * 2 + 1])
+                error = 1.0;
+        }
+        double amplitude = 2.0 * sqrt(in_phase * in_phase + quadrature * quadrature) / (double)(last - first);
+        TEST_CHECK(fabs(amplitude - 0.5) < 0.005);
+        TEST_CHECK(error < 0.005);
+
+        free(out);
+        free(frames);
+    }
+
+    TEST_CHECK(Wave_ResampleCacheFree(&cache, NULL));
+}
+
+// Left only, mono, anti-phase and right 6 dB down sections each fill one window with their known readings
+static void Test_Stereo(void)
+{
+    enum { section = 4800, sections = 4, frame_count = section * sections };
+    static const float gains[sections] = { 0.0f, 1.0f, -1.0f, 0.5f };
+    float* frames = (float*)malloc(frame_count * 2 * sizeof(float));
+    WAVE_STEREO_RESULT windows[8], streamed[8], total;
+    WAVE_STEREO_METER meter;
+    size_t count = 0, found = 0, i;
+
+    for (i = 0; i < frame_count; ++i)
+    {
+        float value = Test_RandomFloat() * 0.5f;
+        frames[i * 2] = value;
+        frames[i * 2 + 1] = value * gains[i / section];
+    }
+
+    WAVE wave;
+    void* buffer = Test_MakeWave(frames, frame_count, 2, 48000, &wave);
+    TEST_CHECK(Wave_StereoInit(&meter, 2, 0, 1, section));
+    TEST_CHECK(Wave_StereoProcessWave(&meter, &wave, windows, 8, &count));
+    TEST_CHECK(count == sections);
+    TEST_CHECK(Wave_StereoFinish(&meter, windows + count, 8 - count, &found));
+    TEST_CHECK(found == 0);
+
+    // Left only: no correlation, all on the left, as much side as mid, the fold-down 3 dB down
+    TEST_CHECK((windows[0].first_frame == 0) && (windows[0].frame_count == section));
+    TEST_CHECK((windows[0].correlation == 0.0f) && (windows[0].balance_db == HUGE_VALF));
+    TEST_CHECK(fabsf(windows[0].side_db) < 1e-4f);
+    TEST_CHECK(fabsf(windows[0].mono_db + 3.0103f) < 1e-3f);
+
+    // Mono: full correlation, centered, no side, no fold-down loss
+    TEST_CHECK(windows[1].first_frame == section);
+    TEST_CHECK((fabsf(windows[1].correlation - 1.0f) < 1e-6f) && (fabsf(windows[1].balance_db) < 1e-4f));
+    TEST_CHECK((windows[1].side_db == -HUGE_VALF) && (fabsf(windows[1].mono_db) < 1e-4f));
+
+    // Anti-phase: opposite correlation, centered, all side, the fold-down cancels
+    TEST_CHECK((fabsf(windows[2].correlation + 1.0f) < 1e-6f) && (fabsf(windows[2].balance_db) < 1e-4f));
+    TEST_CHECK((windows[2].side_db == HUGE_VALF) && (windows[2].mono_db == -HUGE_VALF));
+
+    // Right 6 dB down, still in phase
+    TEST_CHECK((fabsf(windows[3].correlation - 1.0f) < 1e-6f) && (fabsf(windows[3].balance_db - 6.0206f) < 1e-3f));
+    TEST_CHECK(fabsf(windows[3].side_db - 10.0f * log10f(1.0f / 9.0f)) < 1e-3f);
+
+    TEST_CHECK(Wave_StereoGetResult(&meter, &total));
+    TEST_CHECK((total.first_frame == 0) && (total.frame_count == frame_count));
+    TEST_CHECK((total.correlation > 0.0f) && (total.correlation < 1.0f) && (total.balance_db > 0.0f));
+
+    // Uneven blocks, a partial window left for Finish
+    size_t at = 0, block = 3;
+    TEST_CHECK(Wave_StereoInit(&meter, 2, 0, 1, section));
+    count = 0;
+    while (at < frame_count - 100)
+    {
+        size_t length = (block < frame_count - 100 - at) ? block : frame_count - 100 - at;
+        TEST_CHECK(Wave_StereoProcess(&meter, frames + at * 2, length, streamed + count, 8 - count, &found));
+        count += found;
+        at += length;
+        block = block * 2 + 1;
+    }
+    TEST_CHECK(count == sections - 1);
+    TEST_CHECK(Wave_StereoFinish(&meter, streamed + count, 8 - count, &found));
+    TEST_CHECK((found == 1) && (streamed[count].first_frame == section * (sections - 1)) && (streamed[count].frame_count == section - 100));
+    for (i = 0; i < sections - 1; ++i)
+        TEST_CHECK((streamed[i].first_frame == windows[i].first_frame) && (fabsf(streamed[i].correlation - windows[i].correlation) < 1e-5f));
+
+    free(buffer);
+    free(frames);
+}
+
+// Noise and a copy delayed by a known lag are aligned to that lag, with its sign, at full rate and decimated
+static void Test_Align(void)
+{
+    enum { frame_count = 200000, lag = 1234, max_lag = 2000 };
+    float* a = (float*)malloc(frame_count * sizeof(float));
+    float* b = (float*)calloc(frame_count, sizeof(float));
+    WAVE_ALIGN_RESULT result, swapped, decimated;
+    size_t i;
+
+    for (i = 0; i < frame_count; ++i)
+        a[i] = Test_RandomFloat() * 0.5f;
+    for (i = lag; i < frame_count; ++i)
+        b[i] = a[i - lag];
+
+    WAVE wave_a, wave_b;
+    void* buffer_a = Test_MakeWave(a, frame_count, 1, 16000, &wave_a);
+    void* buffer_b = Test_MakeWave(b, frame_count, 1, 16000, &wave_b);
+
+    // b starts lag frames after a, a is ahead of b by as much
+    TEST_CHECK(Wave_AlignWaves(&wave_a, &wave_b, max_lag, 1, &result, NULL));
+    TEST_CHECK((fabs(result.lag - lag) < 0.01) && (result.correlation > 0.95f));
+    TEST_CHECK(Wave_AlignWaves(&wave_b, &wave_a, max_lag, 1, &swapped, NULL));
+    TEST_CHECK((fabs(swapped.lag + lag) < 0.01) && (swapped.correlation > 0.95f));
+    TEST_CHECK(Wave_AlignWaves(&wave_a, &wave_b, max_lag, 4, &decimated, NULL));
+    TEST_CHECK(fabs(decimated.lag - lag) < 4.0);
+
+    // Out of range, the peak is elsewhere and weak
+    TEST_CHECK(Wave_AlignWaves(&wave_a, &wave_b, lag / 2, 1, &swapped, NULL));
+    TEST_CHECK(swapped.correlation < 0.1f);
+
+    // Blocks computed out of order and accumulated in order give the single call
+    WAVE_ALIGN align;
+    TEST_CHECK(Wave_AlignInit(&align, &wave_a, &wave_b, max_lag, 1, NULL));
+    TEST_CHECK(align.block_count > 1);
+    size_t length = Wave_AlignGetBlockLength(&align);
+    double* blocks = (double*)malloc(align.block_count * length * sizeof(double));
+    for (i = align.block_count; i > 0; --i)
+        TEST_CHECK(Wave_AlignComputeBlock(&align, i - 1, blocks + (i - 1) * length));
+    for (i = 0; i < align.block_count; ++i)
+        TEST_CHECK(Wave_AlignAccumulate(&align, i, blocks + i * length));
+    TEST_CHECK(Wave_AlignGetResult(&align, &swapped));
+    TEST_CHECK((swapped.lag == result.lag) && (swapped.correlation == result.correlation));
+    TEST_CHECK(Wave_AlignFree(&align));
+
+    free(blocks);
+    free(buffer_b);
+    free(buffer_a);
+    free(b);
+    free(a);
+}
+
+int main(void)
+{
+    Test_Timeline();
+    Test_TruePeak();
+    Test_Onsets();
+    Test_Resample();
+    Test_Stereo();
+    Test_Align();
+
+    return TEST_RESULT();
+}
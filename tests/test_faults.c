@@ -0,0 +1,92 @@
+// Fault events must come out sorted, identical when the wave is scanned in ranges, and truncated to the earliest ones
+
+#define SIMPLE_WAVE_IMPLEMENTATION
+#include "simple_wave.h"
+
+#include "test.h"
+
+#define TEST_CHANNELS 3
+#define TEST_FRAMES 200000
+#define TEST_MAX_EVENTS 4096
+
+static int16_t test_samples[TEST_FRAMES * TEST_CHANNELS];
+static WAVE_FAULT_EVENT test_all[TEST_MAX_EVENTS];
+static WAVE_FAULT_EVENT test_some[TEST_MAX_EVENTS];
+
+// Noise with clipped, stuck and silent runs of random lengths, some long enough to close long after later ones
+static void Test_FillFaults(void)
+{
+    size_t i, c;
+    for (i = 0; i < TEST_FRAMES * TEST_CHANNELS; ++i)
+        test_samples[i] = (int16_t)(Test_Random() % 20000) - 10000;
+
+    for (c = 0; c < TEST_CHANNELS; ++c)
+    {
+        size_t frame = 1000 + Test_Random() % 1000;
+        while (frame < TEST_FRAMES - 1000)
+        {
+            size_t length = (Test_Random() & 15) ? 2 + Test_Random() % 60 : 5000 + Test_Random() % 20000;
+            int16_t value;
+            switch (Test_Random() % 3)
+            {
+                case 0: value = (Test_Random() & 1) ? 32767 : -32768; break;
+                case 1: value = (int16_t)(1000 + Test_Random() % 1000); break;
+                default: value = 0; break;
+            }
+
+            for (i = frame; (i < frame + length) && (i < TEST_FRAMES - 1000); ++i)
+                test_samples[i * TEST_CHANNELS + c] = value;
+            frame += length + 1 + Test_Random() % 3000;
+        }
+    }
+}
+
+int main(void)
+{
+    Test_FillFaults();
+
+    FILE* file = tmpfile();
+    WAVE_WRITER writer;
+    TEST_CHECK(Wave_WriterBegin(&writer, file, WAVE_SAMPLE_FORMAT_S16, TEST_CHANNELS, 48000));
+    TEST_CHECK(Wave_WriterWrite(&writer, test_samples, TEST_FRAMES));
+    TEST_CHECK(Wave_WriterEnd(&writer));
+
+    long size = 0;
+    void* buffer = Test_ReadAll(file, &size);
+    WAVE wave;
+    TEST_CHECK(Wave_ParseBuffer(buffer, (size_t)size, &wave));
+
+    size_t count = 0, found = 0, i;
+    TEST_CHECK(Wave_DetectFaults(&wave, 0, TEST_FRAMES, test_all, TEST_MAX_EVENTS, &count));
+    TEST_CHECK((count > 100) && (count < TEST_MAX_EVENTS));
+    for (i = 1; i < count; ++i)
+        TEST_CHECK((test_all[i - 1].first_frame < test_all[i].first_frame) ||
+                   ((test_all[i - 1].first_frame == test_all[i].first_frame) && (test_all[i - 1].channel < test_all[i].channel)));
+
+    // Ranges concatenated in order give the single pass
+    size_t range;
+    for (range = 777; range < TEST_FRAMES; range = range * 5 + 1)
+    {
+        size_t at, total = 0;
+        for (at = 0; at < TEST_FRAMES; at += range)
+        {
+            TEST_CHECK(Wave_DetectFaults(&wave, at, range, test_some + total, TEST_MAX_EVENTS - total, &found));
+            total += found;
+        }
+        TEST_CHECK((total == count) && (memcmp(test_some, test_all, count * sizeof(WAVE_FAULT_EVENT)) == 0));
+    }
+
+    // Truncated results keep the events starting first, long runs closing late included
+    size_t max_events;
+    for (max_events = 0; max_events < count; max_events = max_events * 2 + 1)
+    {
+        memset(test_some, 0, sizeof(test_some));
+        TEST_CHECK(Wave_DetectFaults(&wave, 0, TEST_FRAMES, test_some, max_events, &found));
+        TEST_CHECK(found == count);
+        TEST_CHECK(memcmp(test_some, test_all, max_events * sizeof(WAVE_FAULT_EVENT)) == 0);
+    }
+
+    free(buffer);
+    fclose(file);
+    return TEST_RESULT();
+}
@@ -0,0 +1,155 @@
+// The levels reduction must give bit-identical results however the frames are split, ordered or resumed, and so must a resumed true-peak meter
+
+#define SIMPLE_WAVE_IMPLEMENTATION
+#include "simple_wave.h"
+
+#include "test.h"
+
+static int Test_SameLevels(const WAVE_LEVELS* a, const WAVE_LEVELS* b)
+{
+    return (a->channels == b->channels) && (a->frame_count == b->frame_count) &&
+           (memcmp(a->peak, b->peak, sizeof(a->peak[0]) * (size_t)a->channels) == 0) &&
+           (memcmp(a->sum_squares, b->sum_squares, sizeof(a->sum_squares[0]) * (size_t)a->channels) == 0);
+}
+
+static size_t Test_RandomCount(size_t max)
+{
+    return 1 + Test_Random() % max;
+}
+
+static void Test_Levels(WAVE_SAMPLE_FORMAT sample_format, int channels, size_t frame_count)
+{
+    size_t sample_count = frame_count * (size_t)channels;
+    float* floats = (float*)malloc(sample_count * sizeof(float));
+    void* samples = malloc(sample_count * Wave_GetSampleFormatSize(sample_format));
+    size_t i;
+
+    for (i = 0; i < sample_count; ++i)
+        floats[i] = Test_RandomFloat() * (float)(1 + (i / 5000) % 4) * 0.25f;
+    Wave_ConvertFromFloat(floats, sample_count, sample_format, samples);
+
+    FILE* file = tmpfile();
+    WAVE_WRITER writer;
+    TEST_CHECK(Wave_WriterBegin(&writer, file, sample_format, channels, 48000));
+    TEST_CHECK(Wave_WriterWrite(&writer, samples, frame_count));
+    TEST_CHECK(Wave_WriterEnd(&writer));
+
+    long size = 0;
+    void* buffer = Test_ReadAll(file, &size);
+    WAVE wave;
+    TEST_CHECK(Wave_ParseBuffer(buffer, (size_t)size, &wave));
+    Wave_ReadFramesFloat(&wave, 0, frame_count, floats);
+
+    // Reference: the whole wave in one call
+    WAVE_LEVELS_STATE state;
+    WAVE_LEVELS reference, levels;
+    TEST_CHECK(Wave_LevelsBegin(&state, channels));
+    TEST_CHECK(Wave_LevelsProcessWave(&state, &wave));
+    TEST_CHECK(Wave_LevelsGetResult(&state, &reference));
+    TEST_CHECK(reference.frame_count == frame_count);
+
+    // Streamed in random sized pieces, reading the result on the way must not disturb it
+    int round;
+    for (round = 0; round < 8; ++round)
+    {
+        size_t at = 0;
+        TEST_CHECK(Wave_LevelsBegin(&state, channels));
+        while (at < frame_count)
+        {
+            size_t count = Test_RandomCount(round < 4 ? 64 : 20000);
+            if (count > frame_count - at)
+                count = frame_count - at;
+            TEST_CHECK(Wave_LevelsProcess(&state, floats + at * (size_t)channels, count));
+            at += count;
+            if ((Test_Random() & 7) == 0)
+                TEST_CHECK(Wave_LevelsGetResult(&state, &levels));
+        }
+        TEST_CHECK(Wave_LevelsGetResult(&state, &levels));
+        TEST_CHECK(Test_SameLevels(&levels, &reference));
+    }
+
+    // Block partials computed in random ranges, last range first, then combined in random sized batches
+    size_t block_count = (frame_count + WAVE_LEVELS_BLOCK_FRAMES - 1) / WAVE_LEVELS_BLOCK_FRAMES;
+    WAVE_LEVELS* blocks = (WAVE_LEVELS*)malloc(block_count * sizeof(WAVE_LEVELS));
+    for (round = 0; round < 8; ++round)
+    {
+        size_t end = block_count;
+        memset(blocks, 0xCD, block_count * sizeof(WAVE_LEVELS));
+        while (end)
+        {
+            size_t count = Test_RandomCount(5);
+            if (count > end)
+                count = end;
+            TEST_CHECK(Wave_LevelsComputeBlocks(&wave, end - count, count, blocks + end - count));
+            end -= count;
+        }
+
+        size_t at = 0;
+        TEST_CHECK(Wave_LevelsBegin(&state, channels));
+        while (at < block_count)
+        {
+            size_t count = Test_RandomCount(round < 4 ? 3 : block_count);
+            if (count > block_count - at)
+                count = block_count - at;
+            TEST_CHECK(Wave_LevelsCombine(&state, blocks + at, count));
+            at += count;
+        }
+        TEST_CHECK(Wave_LevelsGetResult(&state, &levels));
+        TEST_CHECK(Test_SameLevels(&levels, &reference));
+    }
+
+    // Saved mid-stream and resumed from the serialized state
+    size_t split = frame_count / 3;
+    size_t saved_size;
+    void* saved;
+    WAVE_LEVELS_STATE resumed;
+    TEST_CHECK(Wave_LevelsBegin(&state, channels));
+    TEST_CHECK(Wave_LevelsProcess(&state, floats, split));
+    saved_size = Wave_LevelsSave(&state, NULL, 0);
+    saved = malloc(saved_size);
+    TEST_CHECK(Wave_LevelsSave(&state, saved, saved_size) == saved_size);
+    TEST_CHECK(Wave_LevelsLoad(&resumed, saved, saved_size));
+    TEST_CHECK(Wave_LevelsGetFrameCount(&resumed) == split);
+    TEST_CHECK(Wave_LevelsProcess(&resumed, floats + split * (size_t)channels, frame_count - split));
+    TEST_CHECK(Wave_LevelsGetResult(&resumed, &levels));
+    TEST_CHECK(Test_SameLevels(&levels, &reference));
+
+    // The true-peak meter resumes with its filter history, a cut or foreign state is refused
+    WAVE_TRUE_PEAK meter, resumed_meter;
+    void* saved_meter;
+    size_t saved_meter_size;
+    TEST_CHECK(Wave_TruePeakInit(&meter, channels));
+    TEST_CHECK(Wave_TruePeakProcess(&meter, floats, split));
+    saved_meter_size = Wave_TruePeakSave(&meter, NULL, 0);
+    saved_meter = malloc(saved_meter_size);
+    TEST_CHECK(Wave_TruePeakSave(&meter, saved_meter, saved_meter_size - 1) == 0);
+    TEST_CHECK(Wave_TruePeakSave(&meter, saved_meter, saved_meter_size) == saved_meter_size);
+    TEST_CHECK(!Wave_TruePeakLoad(&resumed_meter, saved_meter, saved_meter_size - 1));
+    TEST_CHECK(!Wave_TruePeakLoad(&resumed_meter, saved, saved_size));
+    TEST_CHECK(Wave_TruePeakLoad(&resumed_meter, saved_meter, saved_meter_size));
+    TEST_CHECK(resumed_meter.frames_processed == split);
+    TEST_CHECK(Wave_TruePeakProcess(&meter, floats + split * (size_t)channels, frame_count - split));
+    TEST_CHECK(Wave_TruePeakProcess(&resumed_meter, floats + split * (size_t)channels, frame_count - split));
+    TEST_CHECK(Wave_TruePeakFinish(&meter) && Wave_TruePeakFinish(&resumed_meter));
+    TEST_CHECK(resumed_meter.frames_processed == frame_count);
+    TEST_CHECK(memcmp(resumed_meter.peak, meter.peak, sizeof(meter.peak[0]) * (size_t)channels) == 0);
+    TEST_CHECK(memcmp(resumed_meter.peak_frame, meter.peak_frame, sizeof(meter.peak_frame[0]) * (size_t)channels) == 0);
+
+    free(saved_meter);
+    free(saved);
+    free(blocks);
+    free(buffer);
+    fclose(file);
+    free(samples);
+    free(floats);
+}
+
+int main(void)
+{
+    Test_Levels(WAVE_SAMPLE_FORMAT_S16, 2, 10 * WAVE_LEVELS_BLOCK_FRAMES + 1234);
+    Test_Levels(WAVE_SAMPLE_FORMAT_F32, 1, 37 * WAVE_LEVELS_BLOCK_FRAMES);
+    Test_Levels(WAVE_SAMPLE_FORMAT_S32, 7, 3 * WAVE_LEVELS_BLOCK_FRAMES - 1);
+    Test_Levels(WAVE_SAMPLE_FORMAT_U8, 3, 100);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,46 @@
+// Parser-only build: every optional subsystem is compiled out and the program is linked without libm
+
+#define SIMPLE_WAVE_NO_STDIO
+#define SIMPLE_WAVE_NO_DSP
+#define SIMPLE_WAVE_NO_ALLOCATORS
+#define SIMPLE_WAVE_IMPLEMENTATION
+#include "simple_wave.h"
+
+#include "test.h"
+
+int main(void)
+{
+    static const float samples[6] = { -1.5f, -1.0f, -0.00001f, 0.0f, 0.49999f, 1.0f };
+    static const int16_t expected[6] = { -32768, -32768, 0, 0, 16384, 32767 };
+    unsigned char buffer[sizeof(RIFF_HEADER) + sizeof(RIFF_CHUNK) * 2 + sizeof(WAVE_FORMAT) + sizeof(expected)];
+    int16_t converted[6];
+    WAVE wave;
+
+    Wave_ConvertFromFloat(samples, 6, WAVE_SAMPLE_FORMAT_S16, converted);
+    TEST_CHECK(memcmp(converted, expected, sizeof(expected)) == 0);
+
+    RIFF_HEADER header = { RIFF_CODE('R', 'I', 'F', 'F'), (uint32_t)(sizeof(buffer) - 8), RIFF_CODE('W', 'A', 'V', 'E') };
+    RIFF_CHUNK format_chunk = { WAVE_CHUNK_FORMAT, sizeof(WAVE_FORMAT) };
+    WAVE_FORMAT format = { WAVE_FORMAT_TAG_PCM, 2, 8000, 32000, 4, 16 };
+    RIFF_CHUNK data_chunk = { WAVE_CHUNK_DATA, sizeof(expected) };
+    unsigned char* at = buffer;
+    memcpy(at, &header, sizeof(header));
+    at += sizeof(header);
+    memcpy(at, &format_chunk, sizeof(format_chunk));
+    at += sizeof(format_chunk);
+    memcpy(at, &format, sizeof(format));
+    at += sizeof(format);
+    memcpy(at, &data_chunk, sizeof(data_chunk));
+    at += sizeof(data_chunk);
+    memcpy(at, expected, sizeof(expected));
+
+    TEST_CHECK(Wave_ParseBuffer(buffer, sizeof(buffer), &wave));
+    TEST_CHECK(Wave_GetSampleFormat(&wave) == WAVE_SAMPLE_FORMAT_S16);
+    TEST_CHECK(Wave_GetFrameCount(&wave) == 3);
+
+    float frames[6];
+    TEST_CHECK(Wave_ReadFramesFloat(&wave, 0, 3, frames) == 3);
+    TEST_CHECK((frames[0] == -1.0f) && (frames[5] == 32767.0f / 32768.0f));
+
+    return TEST_RESULT();
+}
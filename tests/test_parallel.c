@@ -0,0 +1,150 @@
+// Batches split between threads must give the same results as one call on the whole batch, run it under the tsan preset
+
+#define SIMPLE_WAVE_IMPLEMENTATION
+#include "simple_wave.h"
+
+#include "test.h"
+
+#include <pthread.h>
+
+#define TEST_FILES 12
+#define TEST_THREADS 4
+#define TEST_RATE 8000
+#define TEST_MAX_SEGMENTS 16
+
+typedef struct TEST_SLICE
+{
+    WAVE_READER* readers;
+    const WAVE_BUFFER* buffers;
+    size_t count;
+    WAVE waves[TEST_FILES];
+    int parse_results[TEST_FILES];
+    size_t parsed;
+    WAVE_VAD_SEGMENT segments[TEST_FILES * TEST_MAX_SEGMENTS];
+    size_t segment_counts[TEST_FILES];
+    int result;
+} TEST_SLICE;
+
+// Noise with tones switched on and off at a different pace in every file
+static void Test_MakeFile(size_t index, FILE** out_file, long* out_size, void** out_bytes)
+{
+    size_t frame_count = TEST_RATE * 2;
+    float* frames = (float*)malloc(frame_count * sizeof(float));
+    size_t period = TEST_RATE / 4 + index * 400;
+    size_t i;
+
+    for (i = 0; i < frame_count; ++i)
+    {
+        float value = Test_RandomFloat() * 0.003f;
+        if ((i / period) & 1)
+            value += 0.3f * sinf(2.0f * 3.14159265f * (float)(200 + 40 * index) * (float)i / TEST_RATE);
+        frames[i] = value;
+    }
+
+    FILE* file = tmpfile();
+    WAVE_WRITER writer;
+    TEST_CHECK(Wave_WriterBegin(&writer, file, WAVE_SAMPLE_FORMAT_S16, 1, TEST_RATE));
+    TEST_CHECK(Wave_WriterWriteFloat(&writer, frames, frame_count));
+    TEST_CHECK(Wave_WriterEnd(&writer));
+    free(frames);
+
+    *out_bytes = Test_ReadAll(file, out_size);
+    *out_file = file;
+}
+
+static void* Test_RunSlice(void* data)
+{
+    TEST_SLICE* slice = (TEST_SLICE*)data;
+    slice->parsed = Wave_ParseBuffers(slice->buffers, slice->count, slice->waves, slice->parse_results);
+    slice->result = Wave_VadProcessReaders(slice->readers, slice->count, slice->segments, TEST_FILES * TEST_MAX_SEGMENTS, slice->segment_counts, NULL);
+    return NULL;
+}
+
+static void Test_OpenReaders(FILE** files, const long* sizes, WAVE_READER* readers)
+{
+    size_t i;
+    for (i = 0; i < TEST_FILES; ++i)
+    {
+        fseek(files[i], 0, SEEK_SET);
+        TEST_CHECK(Wave_ReaderOpen(&readers[i], files[i], sizes[i], NULL));
+    }
+}
+
+static void Test_CloseReaders(WAVE_READER* readers)
+{
+    size_t i;
+    for (i = 0; i < TEST_FILES; ++i)
+        TEST_CHECK(Wave_ReaderClose(&readers[i], NULL));
+}
+
+int main(void)
+{
+    FILE* files[TEST_FILES];
+    long sizes[TEST_FILES];
+    WAVE_BUFFER buffers[TEST_FILES];
+    WAVE_READER readers[TEST_FILES];
+    static TEST_SLICE whole, slices[TEST_THREADS];
+    size_t i, t;
+
+    for (i = 0; i < TEST_FILES; ++i)
+    {
+        Test_MakeFile(i, &files[i], &sizes[i], &buffers[i].data);
+        buffers[i].size = (size_t)sizes[i];
+    }
+
+    // Reference: the whole batch in one call
+    Test_OpenReaders(files, sizes, readers);
+    whole.readers = readers;
+    whole.buffers = buffers;
+    whole.count = TEST_FILES;
+    Test_RunSlice(&whole);
+    TEST_CHECK(whole.parsed == TEST_FILES);
+    TEST_CHECK(whole.result);
+    Test_CloseReaders(readers);
+
+    // Uneven slices, one per thread
+    Test_OpenReaders(files, sizes, readers);
+    pthread_t threads[TEST_THREADS];
+    size_t first = 0;
+    for (t = 0; t < TEST_THREADS; ++t)
+    {
+        size_t count = (t + 1 < TEST_THREADS) ? t + 1 : TEST_FILES - first;
+        slices[t].readers = readers + first;
+        slices[t].buffers = buffers + first;
+        slices[t].count = count;
+        TEST_CHECK(pthread_create(&threads[t], NULL, Test_RunSlice, &slices[t]) == 0);
+        first += count;
+    }
+    for (t = 0; t < TEST_THREADS; ++t)
+        TEST_CHECK(pthread_join(threads[t], NULL) == 0);
+    Test_CloseReaders(readers);
+
+    // Same waves, segment counts and segments, in the same order
+    const WAVE_VAD_SEGMENT* expected = whole.segments;
+    first = 0;
+    for (t = 0; t < TEST_THREADS; ++t)
+    {
+        const WAVE_VAD_SEGMENT* found = slices[t].segments;
+        TEST_CHECK(slices[t].parsed == slices[t].count);
+        TEST_CHECK(slices[t].result);
+        for (i = 0; i < slices[t].count; ++i)
+        {
+            size_t count = whole.segment_counts[first + i];
+            TEST_CHECK(memcmp(&slices[t].waves[i], &whole.waves[first + i], sizeof(WAVE)) == 0);
+            TEST_CHECK(slices[t].segment_counts[i] == count);
+            TEST_CHECK(count > 0);
+            TEST_CHECK((count == slices[t].segment_counts[i]) && (memcmp(found, expected, count * sizeof(WAVE_VAD_SEGMENT)) == 0));
+            found += count;
+            expected += count;
+        }
+        first += slices[t].count;
+    }
+
+    for (i = 0; i < TEST_FILES; ++i)
+    {
+        free(buffers[i].data);
+        fclose(files[i]);
+    }
+
+    return TEST_RESULT();
+}
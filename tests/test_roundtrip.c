@@ -0,0 +1,1024 @@
+// Round trips every sample format and a set of chunk layouts through the writer, the parser and the loaders
+
+#define SIMPLE_WAVE_IMPLEMENTATION
+#include "simple_wave.h"
+
+#include "test.h"
+
+#define TEST_RATE 44100
+#define TEST_PATH "simple_wave_roundtrip.wav"
+#define TEST_TAIL_PATH "simple_wave_tail.wav"
+
+static const WAVE_SAMPLE_FORMAT test_formats[] = {
+    WAVE_SAMPLE_FORMAT_U8, WAVE_SAMPLE_FORMAT_S16, WAVE_SAMPLE_FORMAT_S32, WAVE_SAMPLE_FORMAT_F32, WAVE_SAMPLE_FORMAT_F64,
+};
+
+// Fills samples that survive the float conversion exactly, so the float path can be compared byte for byte
+static void Test_FillSamples(WAVE_SAMPLE_FORMAT sample_format, void* out_samples, size_t sample_count)
+{
+    unsigned char* dst = (unsigned char*)out_samples;
+    size_t i;
+
+    for (i = 0; i < sample_count; ++i)
+    {
+        switch (sample_format)
+        {
+            case WAVE_SAMPLE_FORMAT_U8:
+                dst[i] = (unsigned char)Test_Random();
+                break;
+            case WAVE_SAMPLE_FORMAT_S16:
+            {
+                int16_t v = (int16_t)Test_Random();
+                memcpy(dst + i * 2, &v, 2);
+                break;
+            }
+            case WAVE_SAMPLE_FORMAT_S32:
+            {
+                // 24 significant bits are exact in a float
+                int32_t v = (int32_t)(Test_Random() & 0xFFFFFF00u);
+                memcpy(dst + i * 4, &v, 4);
+                break;
+            }
+            case WAVE_SAMPLE_FORMAT_F32:
+            {
+                float v = Test_RandomFloat();
+                memcpy(dst + i * 4, &v, 4);
+                break;
+            }
+            case WAVE_SAMPLE_FORMAT_F64:
+            {
+                double v = Test_RandomFloat();
+                memcpy(dst + i * 8, &v, 8);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+static void Test_CheckWave(WAVE* wave, WAVE_SAMPLE_FORMAT sample_format, int channels, const void* samples, size_t frame_count)
+{
+    size_t block_align = Wave_GetSampleFormatSize(sample_format) * (size_t)channels;
+
+    TEST_CHECK(Wave_GetSampleFormat(wave) == sample_format);
+    TEST_CHECK(Wave_GetChannelCount(wave) == channels);
+    TEST_CHECK(Wave_GetSampleFrequency(wave) == TEST_RATE);
+    TEST_CHECK(Wave_GetFrameCount(wave) == frame_count);
+    TEST_CHECK(wave->sample_data_size == frame_count * block_align);
+    TEST_CHECK((wave->sample_data) && (memcmp(wave->sample_data, samples, frame_count * block_align) == 0));
+}
+
+static void Test_CheckInfo(WAVE* info, WAVE* parsed)
+{
+    TEST_CHECK(Wave_GetSampleFormat(info) == Wave_GetSampleFormat(parsed));
+    TEST_CHECK(Wave_GetChannelCount(info) == Wave_GetChannelCount(parsed));
+    TEST_CHECK(Wave_GetFrameCount(info) == Wave_GetFrameCount(parsed));
+    TEST_CHECK(info->sample_data == NULL);
+    TEST_CHECK(info->sample_data_offset == parsed->sample_data_offset);
+    TEST_CHECK(info->sample_data_size == parsed->sample_data_size);
+    TEST_CHECK(info->format_chunk_offset == parsed->format_chunk_offset);
+    TEST_CHECK((info->checksum_chunk != NULL) == (parsed->checksum_chunk != NULL));
+    TEST_CHECK(!Wave_Relocate(info, parsed->header));
+
+    WAVE_DESC info_desc, parsed_desc;
+    TEST_CHECK(Wave_GetDesc(info, &info_desc) && Wave_GetDesc(parsed, &parsed_desc));
+    TEST_CHECK(memcmp(&info_desc, &parsed_desc, sizeof(WAVE_DESC)) == 0);
+}
+
+// A description bound back to the bytes it was made from gives the parsed wave
+static void Test_CheckDesc(WAVE* parsed, void* buff, size_t size)
+{
+    WAVE_DESC desc;
+    WAVE bound;
+
+    memset(&bound, 0, sizeof(bound));
+    TEST_CHECK(Wave_GetDesc(parsed, &desc));
+    TEST_CHECK(Wave_BindDesc(&desc, buff, size, &bound));
+    TEST_CHECK((bound.format == parsed->format) && (bound.sample_data == parsed->sample_data));
+    TEST_CHECK((bound.sample_data_size == parsed->sample_data_size) && (bound.data_chunk == parsed->data_chunk));
+    TEST_CHECK(bound.checksum_chunk == parsed->checksum_chunk);
+
+    // The samples it held must still be there
+    if (parsed->sample_data_size)
+        TEST_CHECK(!Wave_BindDesc(&desc, buff, parsed->sample_data_offset + parsed->sample_data_size - 1, &bound));
+}
+
+// Streams the wav back through a reader, in odd sized blocks and after a seek
+static void Test_CheckReader(FILE* file, long size, WAVE_SAMPLE_FORMAT sample_format, int channels, const void* samples, size_t frame_count, int checksum)
+{
+    size_t block_align = Wave_GetSampleFormatSize(sample_format) * (size_t)channels;
+    unsigned char* frames = (unsigned char*)malloc(frame_count * block_align + 1);
+    float* floats = (float*)malloc(16 * (size_t)channels * sizeof(float));
+    float* expected = (float*)malloc(16 * (size_t)channels * sizeof(float));
+    WAVE_READER reader;
+    size_t read = 0;
+
+    fseek(file, 0, SEEK_SET);
+    TEST_CHECK(Wave_ReaderOpen(&reader, file, size, NULL));
+    TEST_CHECK(reader.frame_count == frame_count);
+    for (;;)
+    {
+        size_t count = Wave_ReaderRead(&reader, frames + read * block_align, 7);
+        if (!count)
+            break;
+        read += count;
+    }
+    TEST_CHECK(read == frame_count);
+    TEST_CHECK(memcmp(frames, samples, frame_count * block_align) == 0);
+    if (checksum)
+        TEST_CHECK(Wave_ReaderVerifyChecksum(&reader));
+
+    size_t seek_frame = frame_count / 2;
+    TEST_CHECK(Wave_ReaderSeek(&reader, seek_frame));
+    TEST_CHECK(Wave_ReaderReadFloat(&reader, floats, 16) == 16);
+    Wave_ConvertToFloat((const unsigned char*)samples + seek_frame * block_align, sample_format, 16 * (size_t)channels, expected);
+    TEST_CHECK(memcmp(floats, expected, 16 * (size_t)channels * sizeof(float)) == 0);
+    if (checksum)
+        TEST_CHECK(Wave_ReaderVerifyChecksum(&reader));
+    TEST_CHECK(Wave_ReaderClose(&reader, NULL));
+
+    free(frames);
+    free(floats);
+    free(expected);
+}
+
+static void Test_WriterRoundTrip(WAVE_SAMPLE_FORMAT sample_format, int channels, int extensible, int checksum)
+{
+    size_t frame_count = 1001;
+    size_t block_align = Wave_GetSampleFormatSize(sample_format) * (size_t)channels;
+    unsigned char* samples = (unsigned char*)malloc(frame_count * block_align);
+    float* floats = (float*)malloc(frame_count * (size_t)channels * sizeof(float));
+    Test_FillSamples(sample_format, samples, frame_count * (size_t)channels);
+    Wave_ConvertToFloat(samples, sample_format, frame_count * (size_t)channels, floats);
+
+    // Raw frames, in two writes
+    FILE* file = tmpfile();
+    WAVE_WRITER writer;
+    TEST_CHECK(file != NULL);
+    if (extensible)
+        TEST_CHECK(Wave_WriterBeginExtensible(&writer, file, sample_format, channels, TEST_RATE, Wave_GetDefaultChannelMask(channels)));
+    else
+        TEST_CHECK(Wave_WriterBegin(&writer, file, sample_format, channels, TEST_RATE));
+    if (checksum)
+        TEST_CHECK(Wave_WriterEnableChecksum(&writer));
+    TEST_CHECK(Wave_WriterWrite(&writer, samples, 300));
+    TEST_CHECK(Wave_WriterWrite(&writer, samples + 300 * block_align, frame_count - 300));
+    TEST_CHECK(Wave_WriterEnd(&writer));
+
+    long size = 0;
+    unsigned char* buffer = (unsigned char*)Test_ReadAll(file, &size);
+    TEST_CHECK((buffer != NULL) && (size % 2 == 0));
+
+    // Parse
+    WAVE parsed;
+    TEST_CHECK(Wave_ParseBuffer(buffer, (size_t)size, &parsed));
+    Test_CheckWave(&parsed, sample_format, channels, samples, frame_count);
+    TEST_CHECK((parsed.format->format_tag == WAVE_FORMAT_TAG_EXTENSIBLE) == (extensible != 0));
+    TEST_CHECK((parsed.checksum_chunk != NULL) == (checksum != 0));
+    TEST_CHECK(parsed.header->size + 8 == (uint32_t)size);
+    if (checksum)
+    {
+        TEST_CHECK(Wave_VerifyChecksum(&parsed));
+        ((unsigned char*)parsed.sample_data)[block_align] ^= 1;
+        TEST_CHECK(!Wave_VerifyChecksum(&parsed));
+        ((unsigned char*)parsed.sample_data)[block_align] ^= 1;
+    }
+
+    // Load from the stream, whole and info only
+    WAVE loaded;
+    fseek(file, 0, SEEK_SET);
+    TEST_CHECK(Wave_LoadStream(file, size, &loaded, NULL));
+    Test_CheckWave(&loaded, sample_format, channels, samples, frame_count);
+    TEST_CHECK(Wave_Free(&loaded, NULL));
+
+    WAVE info;
+    fseek(file, 0, SEEK_SET);
+    TEST_CHECK(Wave_LoadStreamOnlyInfo(file, size, &info, NULL));
+    Test_CheckInfo(&info, &parsed);
+    TEST_CHECK(Wave_Free(&info, NULL));
+
+    Test_CheckReader(file, size, sample_format, channels, samples, frame_count, checksum);
+
+    // Load from a path
+    FILE* path_file = fopen(TEST_PATH, "wb");
+    TEST_CHECK(path_file != NULL);
+    if (path_file)
+    {
+        TEST_CHECK(fwrite(buffer, 1, (size_t)size, path_file) == (size_t)size);
+        fclose(path_file);
+
+        TEST_CHECK(Wave_LoadPath(TEST_PATH, &loaded, NULL));
+        Test_CheckWave(&loaded, sample_format, channels, samples, frame_count);
+        TEST_CHECK(Wave_Free(&loaded, NULL));
+
+        TEST_CHECK(Wave_LoadPathOnlyInfo(TEST_PATH, &info, NULL));
+        Test_CheckInfo(&info, &parsed);
+        TEST_CHECK(Wave_Free(&info, NULL));
+        remove(TEST_PATH);
+    }
+    fclose(file);
+
+    // The float path converts back to the very same bytes
+    file = tmpfile();
+    TEST_CHECK(Wave_WriterBegin(&writer, file, sample_format, channels, TEST_RATE));
+    TEST_CHECK(Wave_WriterWriteFloat(&writer, floats, frame_count));
+    TEST_CHECK(Wave_WriterEnd(&writer));
+    free(buffer);
+    buffer = (unsigned char*)Test_ReadAll(file, &size);
+    TEST_CHECK(Wave_ParseBuffer(buffer, (size_t)size, &parsed));
+    Test_CheckWave(&parsed, sample_format, channels, samples, frame_count);
+    fclose(file);
+
+    free(buffer);
+    free(samples);
+    free(floats);
+}
+
+typedef struct TEST_BYTES
+{
+    unsigned char data[4096];
+    size_t size;
+} TEST_BYTES;
+
+static void Test_Append(TEST_BYTES* bytes, const void* data, size_t size)
+{
+    memcpy(bytes->data + bytes->size, data, size);
+    bytes->size += size;
+}
+
+static void Test_AppendChunk(TEST_BYTES* bytes, uint32_t id, const void* data, size_t size)
+{
+    RIFF_CHUNK chunk = { id, (uint32_t)size };
+    static const unsigned char pad = 0;
+    Test_Append(bytes, &chunk, sizeof(chunk));
+    Test_Append(bytes, data, size);
+    if (size & 1)
+        Test_Append(bytes, &pad, 1);
+}
+
+// Builds a wav whose chunks follow the layout string:
+// F fmt, X extensible fmt, E fmt with an empty extension (18 bytes), D data, H checksum, L odd LIST, J junk, T trailing cue
+static void Test_BuildLayout(TEST_BYTES* bytes, const char* layout, WAVE_SAMPLE_FORMAT sample_format, int channels, const void* samples, size_t frame_count)
+{
+    size_t sample_size = Wave_GetSampleFormatSize(sample_format);
+    size_t data_size = frame_count * sample_size * (size_t)channels;
+    WAVE_FORMAT_EXTENSIBLE format;
+    memset(&format, 0, sizeof(format));
+    format.format.format_tag = (uint16_t)(((sample_format == WAVE_SAMPLE_FORMAT_F32) || (sample_format == WAVE_SAMPLE_FORMAT_F64)) ? WAVE_FORMAT_TAG_IEEE_FLOAT : WAVE_FORMAT_TAG_PCM);
+    format.format.channels = (uint16_t)channels;
+    format.format.samples_per_sec = TEST_RATE;
+    format.format.block_align = (uint16_t)(sample_size * (size_t)channels);
+    format.format.avg_bytes_per_sec = TEST_RATE * format.format.block_align;
+    format.format.bits_per_sample = (uint16_t)(sample_size * 8);
+
+    RIFF_HEADER header = { RIFF_CODE('R', 'I', 'F', 'F'), 0, RIFF_CODE('W', 'A', 'V', 'E') };
+    bytes->size = 0;
+    Test_Append(bytes, &header, sizeof(header));
+
+    for (; *layout; ++layout)
+    {
+        switch (*layout)
+        {
+            case 'F':
+                Test_AppendChunk(bytes, WAVE_CHUNK_FORMAT, &format, sizeof(WAVE_FORMAT));
+                break;
+            case 'E':
+                Test_AppendChunk(bytes, WAVE_CHUNK_FORMAT, &format, sizeof(WAVE_FORMAT) + 2);
+                break;
+            case 'X':
+            {
+                WAVE_FORMAT_EXTENSIBLE extensible = format;
+                extensible.format.format_tag = WAVE_FORMAT_TAG_EXTENSIBLE;
+                extensible.extension_size = 22;
+                extensible.valid_bits_per_sample = format.format.bits_per_sample;
+                extensible.sub_format[0] = (uint8_t)format.format.format_tag;
+                Test_AppendChunk(bytes, WAVE_CHUNK_FORMAT, &extensible, sizeof(extensible));
+                break;
+            }
+            case 'D':
+                Test_AppendChunk(bytes, WAVE_CHUNK_DATA, samples, data_size);
+                break;
+            case 'H':
+            {
+                WAVE_HASH hash;
+                WAVE_CHECKSUM checksum = { WAVE_CHECKSUM_ALGORITHM_XXH64, 0, 0 };
+                Wave_HashBegin(&hash);
+                Wave_HashUpdate(&hash, samples, data_size);
+                checksum.value = Wave_HashEnd(&hash);
+                Test_AppendChunk(bytes, WAVE_CHUNK_CHECKSUM, &checksum, sizeof(checksum));
+                break;
+            }
+            case 'L':
+                Test_AppendChunk(bytes, RIFF_CODE('L', 'I', 'S', 'T'), "INFOx", 5);
+                break;
+            case 'J':
+                Test_AppendChunk(bytes, RIFF_CODE('J', 'U', 'N', 'K'), "\0\0\0", 3);
+                break;
+            case 'T':
+                Test_AppendChunk(bytes, RIFF_CODE('c', 'u', 'e', ' '), "\0\0\0\0", 4);
+                break;
+        }
+    }
+
+    uint32_t riff_size = (uint32_t)(bytes->size - 8);
+    memcpy(bytes->data + 4, &riff_size, 4);
+}
+
+static void Test_ChunkLayouts(void)
+{
+    static const char* layouts[] = { "FD", "DF", "LFD", "FJD", "FDT", "XD", "ED", "JFLDH", "FDHT", "DTF" };
+    static const WAVE_SAMPLE_FORMAT formats[] = { WAVE_SAMPLE_FORMAT_U8, WAVE_SAMPLE_FORMAT_S16, WAVE_SAMPLE_FORMAT_F64 };
+    static const int channel_counts[] = { 1, 2 };
+    size_t frame_count = 37; // Odd, mono U8 data needs a pad byte
+    unsigned char samples[37 * 2 * 8];
+    size_t l, f, c;
+
+    for (f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+    {
+        for (c = 0; c < sizeof(channel_counts) / sizeof(channel_counts[0]); ++c)
+        {
+            for (l = 0; l < sizeof(layouts) / sizeof(layouts[0]); ++l)
+            {
+                TEST_BYTES bytes;
+                WAVE parsed, loaded, info;
+                int channels = channel_counts[c];
+
+                Test_FillSamples(formats[f], samples, frame_count * (size_t)channels);
+                Test_BuildLayout(&bytes, layouts[l], formats[f], channels, samples, frame_count);
+                int checksum = strchr(layouts[l], 'H') != NULL;
+
+                TEST_CHECK(Wave_ParseBuffer(bytes.data, bytes.size, &parsed));
+                Test_CheckWave(&parsed, formats[f], channels, samples, frame_count);
+                TEST_CHECK((parsed.checksum_chunk != NULL) == checksum);
+                if (checksum)
+                    TEST_CHECK(Wave_VerifyChecksum(&parsed));
+
+                FILE* file = Test_OpenBytes(bytes.data, bytes.size);
+                TEST_CHECK(file != NULL);
+                if (!file)
+                    continue;
+
+                TEST_CHECK(Wave_LoadStream(file, (long)bytes.size, &loaded, NULL));
+                Test_CheckWave(&loaded, formats[f], channels, samples, frame_count);
+                TEST_CHECK(Wave_Free(&loaded, NULL));
+
+                fseek(file, 0, SEEK_SET);
+                TEST_CHECK(Wave_LoadStreamOnlyInfo(file, (long)bytes.size, &info, NULL));
+                Test_CheckInfo(&info, &parsed);
+                TEST_CHECK(Wave_Free(&info, NULL));
+
+                Test_CheckReader(file, (long)bytes.size, formats[f], channels, samples, frame_count, checksum);
+                fclose(file);
+            }
+        }
+    }
+}
+
+// Every prefix of a valid wav either fails to parse or reports only the samples it holds
+static void Test_Truncation(void)
+{
+    unsigned char samples[64 * 2 * 2];
+    TEST_BYTES bytes;
+    size_t size;
+
+    Test_FillSamples(WAVE_SAMPLE_FORMAT_S16, samples, 64 * 2);
+    Test_BuildLayout(&bytes, "LFDH", WAVE_SAMPLE_FORMAT_S16, 2, samples, 64);
+
+    for (size = 0; size <= bytes.size; ++size)
+    {
+        WAVE parsed, info;
+        unsigned char* copy = (unsigned char*)malloc(size ? size : 1);
+        memcpy(copy, bytes.data, size);
+
+        if (Wave_ParseBuffer(copy, size, &parsed))
+        {
+            TEST_CHECK(parsed.sample_data_offset + parsed.sample_data_size <= size);
+            TEST_CHECK((!parsed.sample_data_size) || (memcmp(parsed.sample_data, samples, parsed.sample_data_size) == 0));
+            Test_CheckDesc(&parsed, copy, size);
+        }
+
+        FILE* file = Test_OpenBytes(copy, size);
+        if (file)
+        {
+            if (Wave_LoadStreamOnlyInfo(file, (long)size, &info, NULL))
+            {
+                TEST_CHECK(info.sample_data_offset + info.sample_data_size <= size);
+                TEST_CHECK(!Wave_Relocate(&info, copy)); // Also when the prefix stops before the data chunk
+                TEST_CHECK(Wave_Free(&info, NULL));
+            }
+            fclose(file);
+        }
+        free(copy);
+    }
+}
+
+// Frames appended after Wave_WriterWriteAt land after the stored ones, whatever the stream position
+static void Test_WriteAtThenWrite(void)
+{
+    int16_t samples[12 * 2];
+    FILE* file = tmpfile();
+    WAVE_WRITER writer;
+    WAVE wave;
+    long size = 0;
+
+    Test_FillSamples(WAVE_SAMPLE_FORMAT_S16, samples, 12 * 2);
+    TEST_CHECK(Wave_WriterBegin(&writer, file, WAVE_SAMPLE_FORMAT_S16, 2, TEST_RATE));
+    TEST_CHECK(Wave_WriterEnableChecksum(&writer));
+    TEST_CHECK(Wave_WriterWriteAt(&writer, 0, samples, 4));
+    TEST_CHECK(Wave_WriterWrite(&writer, samples + 4 * 2, 4));
+    TEST_CHECK(Wave_WriterWriteAt(&writer, 8, samples + 8 * 2, 2));
+    TEST_CHECK(Wave_WriterWrite(&writer, samples + 10 * 2, 2));
+    TEST_CHECK(Wave_WriterEnd(&writer));
+
+    void* buffer = Test_ReadAll(file, &size);
+    TEST_CHECK(Wave_ParseBuffer(buffer, (size_t)size, &wave));
+    Test_CheckWave(&wave, WAVE_SAMPLE_FORMAT_S16, 2, samples, 12);
+    TEST_CHECK(Wave_VerifyChecksum(&wave) == 1);
+
+    free(buffer);
+    fclose(file);
+}
+
+// A reader seeking past 2 GB and a writer patching a header in front of it, the file is sparse so little is written
+static void Test_LargeOffsets(void)
+{
+    // Wave_ReaderOpen takes the stream size as a long
+    if (sizeof(long) < 8)
+        return;
+
+    size_t frame_count = (size_t)0x90000000u / 2;
+    int16_t head[16], tail[16], read[16];
+    FILE* file = tmpfile();
+    WAVE_WRITER writer;
+    WAVE_READER reader;
+
+    Test_FillSamples(WAVE_SAMPLE_FORMAT_S16, head, 16);
+    Test_FillSamples(WAVE_SAMPLE_FORMAT_S16, tail, 16);
+    TEST_CHECK(Wave_WriterBegin(&writer, file, WAVE_SAMPLE_FORMAT_S16, 1, TEST_RATE));
+    TEST_CHECK(Wave_WriterWrite(&writer, head, 16));
+    if (!Wave_WriterWriteAt(&writer, frame_count - 16, tail, 16))
+    {
+        printf("no room for a sparse 2 GB file, large offsets not tested\n");
+        fclose(file);
+        return;
+    }
+    TEST_CHECK(Wave_WriterEnd(&writer));
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    TEST_CHECK(Wave_ReaderOpen(&reader, file, size, NULL));
+    TEST_CHECK(reader.frame_count == frame_count);
+    TEST_CHECK(Wave_ReaderSeek(&reader, frame_count - 16));
+    TEST_CHECK((Wave_ReaderRead(&reader, read, 16) == 16) && (memcmp(read, tail, sizeof(tail)) == 0));
+    TEST_CHECK(Wave_ReaderSeek(&reader, 0));
+    TEST_CHECK((Wave_ReaderRead(&reader, read, 16) == 16) && (memcmp(read, head, sizeof(head)) == 0));
+    TEST_CHECK(Wave_ReaderClose(&reader, NULL));
+    fclose(file);
+}
+
+// Frames wider than the conversion buffer of Wave_WriterWriteFloat are encoded a few samples at a time
+static void Test_WideFrames(void)
+{
+    static const WAVE_SAMPLE_FORMAT formats[] = { WAVE_SAMPLE_FORMAT_S16, WAVE_SAMPLE_FORMAT_F64 };
+    enum { channels = 700, frame_count = 5 };
+    float* floats = (float*)malloc(channels * frame_count * sizeof(float));
+    unsigned char* expected = (unsigned char*)malloc(channels * frame_count * 8);
+    size_t i, f;
+
+    for (i = 0; i < channels * frame_count; ++i)
+        floats[i] = Test_RandomFloat() * 0.5f;
+
+    for (f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+    {
+        FILE* file = tmpfile();
+        WAVE_WRITER writer;
+        WAVE wave;
+        long size = 0;
+
+        TEST_CHECK(Wave_WriterBegin(&writer, file, formats[f], channels, TEST_RATE));
+        TEST_CHECK(Wave_WriterSetDither(&writer, 1));
+        TEST_CHECK(Wave_WriterEncode(&writer, floats, 0, frame_count, expected));
+        TEST_CHECK(Wave_WriterWriteFloat(&writer, floats, 2));
+        TEST_CHECK(Wave_WriterWriteFloat(&writer, floats + 2 * channels, frame_count - 2));
+        TEST_CHECK(Wave_WriterEnd(&writer));
+
+        void* buffer = Test_ReadAll(file, &size);
+        TEST_CHECK(Wave_ParseBuffer(buffer, (size_t)size, &wave));
+        Test_CheckWave(&wave, formats[f], channels, expected, frame_count);
+
+        free(buffer);
+        fclose(file);
+    }
+
+    // One more channel would overflow the 16 bit block align
+    WAVE_WRITER writer;
+    FILE* file = tmpfile();
+    TEST_CHECK(!Wave_WriterBegin(&writer, file, WAVE_SAMPLE_FORMAT_F64, 0xFFFF / 8 + 1, TEST_RATE));
+    fclose(file);
+
+    free(expected);
+    free(floats);
+}
+
+static void Test_OpenReader(WAVE_READER* reader, FILE* file)
+{
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    TEST_CHECK(Wave_ReaderOpen(reader, file, size, NULL));
+}
+
+// Channels split in mono wavs and merged back give the original frames, a shorter input is padded with silence
+static void Test_SplitMerge(void)
+{
+    enum { channels = 3, frame_count = 5000, skipped = 100, short_count = 1000 };
+    int16_t* samples = (int16_t*)malloc(frame_count * channels * sizeof(int16_t));
+    int16_t shorter[short_count];
+    FILE* file = tmpfile();
+    FILE* outputs[channels] = { tmpfile(), NULL, tmpfile() };
+    FILE* short_file = tmpfile();
+    FILE* merged_file = tmpfile();
+    WAVE_WRITER writer;
+    WAVE_READER reader;
+    size_t i;
+    int c;
+
+    Test_FillSamples(WAVE_SAMPLE_FORMAT_S16, samples, frame_count * channels);
+    Test_FillSamples(WAVE_SAMPLE_FORMAT_S16, shorter, short_count);
+    TEST_CHECK(Wave_WriterBegin(&writer, file, WAVE_SAMPLE_FORMAT_S16, channels, TEST_RATE));
+    TEST_CHECK(Wave_WriterWrite(&writer, samples, frame_count));
+    TEST_CHECK(Wave_WriterEnd(&writer));
+    TEST_CHECK(Wave_WriterBegin(&writer, short_file, WAVE_SAMPLE_FORMAT_S16, 1, TEST_RATE));
+    TEST_CHECK(Wave_WriterWrite(&writer, shorter, short_count));
+    TEST_CHECK(Wave_WriterEnd(&writer));
+
+    // Only the frames left after the first reads are split, the NULL output is skipped
+    int16_t first[skipped * channels];
+    Test_OpenReader(&reader, file);
+    TEST_CHECK(Wave_ReaderRead(&reader, first, skipped) == skipped);
+    TEST_CHECK(Wave_SplitChannels(&reader, outputs, NULL));
+    TEST_CHECK(Wave_ReaderClose(&reader, NULL));
+
+    for (c = 0; c < channels; c += 2)
+    {
+        WAVE wave;
+        long size = 0;
+        void* buffer = Test_ReadAll(outputs[c], &size);
+        TEST_CHECK(Wave_ParseBuffer(buffer, (size_t)size, &wave));
+        TEST_CHECK((Wave_GetChannelCount(&wave) == 1) && (Wave_GetSampleFormat(&wave) == WAVE_SAMPLE_FORMAT_S16));
+        TEST_CHECK(Wave_GetFrameCount(&wave) == frame_count - skipped);
+        const int16_t* mono = (const int16_t*)wave.sample_data;
+        for (i = 0; i < frame_count - skipped; ++i)
+            if (mono[i] != samples[(skipped + i) * channels + c])
+                break;
+        TEST_CHECK(i == frame_count - skipped);
+        free(buffer);
+    }
+
+    // Merged in another order, the short input runs out in the first block
+    WAVE_READER inputs[3];
+    Test_OpenReader(&inputs[0], outputs[2]);
+    Test_OpenReader(&inputs[1], short_file);
+    Test_OpenReader(&inputs[2], outputs[0]);
+    TEST_CHECK(Wave_MergeChannels(inputs, 3, merged_file, 0x107, NULL));
+    for (c = 0; c < 3; ++c)
+        TEST_CHECK(Wave_ReaderClose(&inputs[c], NULL));
+
+    WAVE merged;
+    long size = 0;
+    void* buffer = Test_ReadAll(merged_file, &size);
+    TEST_CHECK(Wave_ParseBuffer(buffer, (size_t)size, &merged));
+    TEST_CHECK(merged.format->format_tag == WAVE_FORMAT_TAG_EXTENSIBLE);
+    TEST_CHECK(((const WAVE_FORMAT_EXTENSIBLE*)merged.format)->channel_mask == 0x107);
+    TEST_CHECK((Wave_GetChannelCount(&merged) == 3) && (Wave_GetFrameCount(&merged) == frame_count - skipped));
+    const int16_t* frames = (const int16_t*)merged.sample_data;
+    for (i = 0; i < frame_count - skipped; ++i)
+    {
+        const int16_t* source = samples + (skipped + i) * channels;
+        if ((frames[i * 3] != source[2]) || (frames[i * 3 + 2] != source[0]))
+            break;
+        if (frames[i * 3 + 1] != ((i < short_count) ? shorter[i] : 0))
+            break;
+    }
+    TEST_CHECK(i == frame_count - skipped);
+
+    // Inputs must be mono
+    Test_OpenReader(&reader, file);
+    TEST_CHECK(!Wave_MergeChannels(&reader, 1, merged_file, 0, NULL));
+    TEST_CHECK(Wave_ReaderClose(&reader, NULL));
+
+    free(buffer);
+    fclose(merged_file);
+    fclose(short_file);
+    fclose(outputs[2]);
+    fclose(outputs[0]);
+    fclose(file);
+    free(samples);
+}
+
+// A hybrid voice plays the head from memory and the tail from its ring, fed by Service or by refills of the caller
+static void Test_Hybrid(void)
+{
+    enum { channels = 2, frame_count = 10000, head_frames = 1000, ring_frames = 777 };
+    int16_t* samples = (int16_t*)malloc(frame_count * channels * sizeof(int16_t));
+    int16_t* played = (int16_t*)malloc(frame_count * channels * sizeof(int16_t));
+    int16_t ring[ring_frames * channels];
+    FILE* file = tmpfile();
+    WAVE_WRITER writer;
+    WAVE_HYBRID_SAMPLE sample;
+    WAVE_HYBRID_VOICE voice;
+    size_t total, count;
+
+    Test_FillSamples(WAVE_SAMPLE_FORMAT_S16, samples, frame_count * channels);
+    TEST_CHECK(Wave_WriterBegin(&writer, file, WAVE_SAMPLE_FORMAT_S16, channels, TEST_RATE));
+    TEST_CHECK(Wave_WriterWrite(&writer, samples, frame_count));
+    TEST_CHECK(Wave_WriterEnd(&writer));
+
+    // The head keeps whole frames only
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    TEST_CHECK(Wave_HybridOpen(&sample, file, size, head_frames * channels * sizeof(int16_t) + 3, NULL, NULL));
+    TEST_CHECK((sample.head_frames == head_frames) && (sample.frame_count == frame_count));
+    TEST_CHECK(memcmp(sample.head, samples, head_frames * channels * sizeof(int16_t)) == 0);
+
+    // Nothing fetched yet: the head plays, then the voice runs dry
+    TEST_CHECK(Wave_HybridVoiceStart(&voice, &sample, ring, ring_frames));
+    TEST_CHECK(Wave_HybridVoiceGetBufferedFrames(&voice) == head_frames);
+    TEST_CHECK(Wave_HybridVoiceRead(&voice, played, head_frames + 10) == head_frames);
+    TEST_CHECK(voice.underruns == 1);
+
+    // Service fills the ring whenever it has room
+    total = head_frames;
+    while (total < frame_count)
+    {
+        Wave_HybridVoiceService(&voice);
+        count = Wave_HybridVoiceRead(&voice, played + total * channels, 300);
+        if (!count)
+            break;
+        total += count;
+    }
+    TEST_CHECK(total == frame_count);
+    TEST_CHECK(memcmp(played, samples, frame_count * channels * sizeof(int16_t)) == 0);
+    TEST_CHECK(Wave_HybridVoiceRead(&voice, played, 1) == 0);
+
+    // Refills read by the caller from the offsets the voice asks for, played as floats
+    float floats[64 * channels], expected[64 * channels];
+    int16_t block[ring_frames * channels];
+    uint64_t offset = 0;
+    TEST_CHECK(Wave_HybridVoiceStart(&voice, &sample, ring, ring_frames));
+    total = 0;
+    while (total < frame_count)
+    {
+        TEST_CHECK(Wave_HybridVoiceGetRefill(&voice, &offset, &count));
+        TEST_CHECK(offset == sample.wave.sample_data_offset + (head_frames + voice.ring_write) * channels * sizeof(int16_t));
+        memcpy(block, samples + (head_frames + voice.ring_write) * channels, count * channels * sizeof(int16_t));
+        TEST_CHECK(Wave_HybridVoiceCommitRefill(&voice, block, count));
+        TEST_CHECK(!Wave_HybridVoiceCommitRefill(&voice, block, 1));
+
+        count = Wave_HybridVoiceReadFloat(&voice, floats, 64);
+        Wave_ConvertToFloat(samples + total * channels, WAVE_SAMPLE_FORMAT_S16, count * channels, expected);
+        TEST_CHECK(memcmp(floats, expected, count * channels * sizeof(float)) == 0);
+        if (!count)
+            break;
+        total += count;
+    }
+    TEST_CHECK((total == frame_count) && (voice.underruns == 0));
+
+    TEST_CHECK(Wave_HybridClose(&sample, NULL, NULL));
+    fclose(file);
+    free(played);
+    free(samples);
+}
+
+// Two voices of one sample fed by a scheduler: a voice is queued once per service, stale refills are dropped
+static void Test_Scheduler(void)
+{
+    enum { frame_count = 20000, ring_frames = 1000 };
+    int16_t* samples = (int16_t*)malloc(frame_count * sizeof(int16_t));
+    int16_t* played[2];
+    int16_t rings[2][ring_frames];
+    unsigned char staging[16 * 1024];
+    WAVE_STREAM_REQUEST requests[4];
+    WAVE_STREAM_SCHEDULER scheduler;
+    WAVE_HYBRID_SAMPLE sample;
+    WAVE_HYBRID_VOICE voices[2];
+    FILE* file = tmpfile();
+    WAVE_WRITER writer;
+    size_t positions[2] = { 0, 0 };
+    size_t v;
+
+    Test_FillSamples(WAVE_SAMPLE_FORMAT_S16, samples, frame_count);
+    TEST_CHECK(Wave_WriterBegin(&writer, file, WAVE_SAMPLE_FORMAT_S16, 1, TEST_RATE));
+    TEST_CHECK(Wave_WriterWrite(&writer, samples, frame_count));
+    TEST_CHECK(Wave_WriterEnd(&writer));
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    TEST_CHECK(Wave_HybridOpen(&sample, file, size, 0, NULL, NULL));
+    for (v = 0; v < 2; ++v)
+    {
+        played[v] = (int16_t*)malloc(frame_count * sizeof(int16_t));
+        TEST_CHECK(Wave_HybridVoiceStart(&voices[v], &sample, rings[v], ring_frames));
+    }
+    TEST_CHECK(Wave_SchedulerInit(&scheduler, requests, 4, staging, sizeof(staging), 100, 200));
+
+    // A second submit of a queued voice is refused, both voices share one read of the same frames
+    TEST_CHECK(Wave_SchedulerSubmit(&scheduler, &voices[0]));
+    TEST_CHECK(!Wave_SchedulerSubmit(&scheduler, &voices[0]));
+    TEST_CHECK(Wave_SchedulerSubmit(&scheduler, &voices[1]));
+    TEST_CHECK(scheduler.request_count == 2);
+    TEST_CHECK(Wave_SchedulerService(&scheduler) == 2 * ring_frames);
+    TEST_CHECK(scheduler.request_count == 0);
+
+    // Refills below min_request_frames wait while the voice is not about to run dry
+    positions[1] += Wave_HybridVoiceRead(&voices[1], played[1], 150);
+    TEST_CHECK(Wave_SchedulerSubmit(&scheduler, &voices[1]));
+    TEST_CHECK(scheduler.request_count == 0);
+
+    // A voice refilled elsewhere after its submit gets nothing from the service, even with room for the stale frames
+    positions[0] += Wave_HybridVoiceRead(&voices[0], played[0], 500);
+    TEST_CHECK(Wave_SchedulerSubmit(&scheduler, &voices[0]));
+    TEST_CHECK(Wave_HybridVoiceService(&voices[0]) == 500);
+    positions[0] += Wave_HybridVoiceRead(&voices[0], played[0] + positions[0], 500);
+    TEST_CHECK(Wave_SchedulerService(&scheduler) == 0);
+    TEST_CHECK(voices[0].ring_write == ring_frames + 500);
+
+    // Play both to the end
+    while ((positions[0] < frame_count) || (positions[1] < frame_count))
+    {
+        size_t delivered;
+        for (v = 0; v < 2; ++v)
+            TEST_CHECK(Wave_SchedulerSubmit(&scheduler, &voices[v]));
+        delivered = Wave_SchedulerService(&scheduler);
+        for (v = 0; v < 2; ++v)
+            positions[v] += Wave_HybridVoiceRead(&voices[v], played[v] + positions[v], 300 + 100 * v);
+        if ((!delivered) && (!Wave_HybridVoiceGetBufferedFrames(&voices[0])) && (!Wave_HybridVoiceGetBufferedFrames(&voices[1])))
+            break;
+    }
+    for (v = 0; v < 2; ++v)
+    {
+        TEST_CHECK(positions[v] == frame_count);
+        TEST_CHECK(memcmp(played[v], samples, frame_count * sizeof(int16_t)) == 0);
+        free(played[v]);
+    }
+
+    TEST_CHECK(Wave_HybridClose(&sample, NULL, NULL));
+    fclose(file);
+    free(samples);
+}
+
+// Descriptions of a live recorded wav, and of one read from the middle of a file, bind to the bytes of the wav
+static void Test_Desc(void)
+{
+    unsigned char samples[64 * 2 * 2];
+    TEST_BYTES bytes;
+    WAVE parsed, info;
+    WAVE_DESC desc, info_desc;
+
+    Test_FillSamples(WAVE_SAMPLE_FORMAT_S16, samples, 64 * 2);
+    Test_BuildLayout(&bytes, "FDH", WAVE_SAMPLE_FORMAT_S16, 2, samples, 64);
+    TEST_CHECK(Wave_ParseBuffer(bytes.data, bytes.size, &parsed));
+    Test_CheckDesc(&parsed, bytes.data, bytes.size);
+
+    // Info read after 1001 bytes of something else
+    FILE* file = tmpfile();
+    unsigned char prefix[1001];
+    memset(prefix, 0x55, sizeof(prefix));
+    fwrite(prefix, 1, sizeof(prefix), file);
+    fwrite(bytes.data, 1, bytes.size, file);
+    fseek(file, (long)sizeof(prefix), SEEK_SET);
+    TEST_CHECK(Wave_LoadStreamOnlyInfo(file, (long)(sizeof(prefix) + bytes.size), &info, NULL));
+    TEST_CHECK((info.header_offset == sizeof(prefix)) && (info.sample_data_offset == sizeof(prefix) + parsed.sample_data_offset));
+    TEST_CHECK(Wave_GetDesc(&info, &info_desc) && Wave_GetDesc(&parsed, &desc));
+    TEST_CHECK(memcmp(&info_desc, &desc, sizeof(WAVE_DESC)) == 0);
+    TEST_CHECK(Wave_Free(&info, NULL));
+    fclose(file);
+
+    // Recorders that never patched the sizes leave 0xFFFFFFFF, the description keeps it and the samples that are there
+    uint32_t unset = 0xFFFFFFFFu;
+    memcpy(bytes.data + 4, &unset, 4);
+    memcpy(bytes.data + parsed.data_chunk_offset + 4, &unset, 4);
+    TEST_CHECK(Wave_ParseBuffer(bytes.data, bytes.size, &parsed));
+    TEST_CHECK(parsed.sample_data_size == bytes.size - parsed.sample_data_offset);
+    TEST_CHECK(Wave_GetDesc(&parsed, &desc));
+    TEST_CHECK((desc.data_chunk_size == unset) && (desc.sample_data_size == parsed.sample_data_size));
+    Test_CheckDesc(&parsed, bytes.data, bytes.size);
+
+    // A description of other sizes or of another version is refused
+    WAVE bound;
+    desc.data_chunk_size = sizeof(samples);
+    TEST_CHECK(!Wave_BindDesc(&desc, bytes.data, bytes.size, &bound));
+    TEST_CHECK(Wave_GetDesc(&parsed, &desc));
+    desc.magic = RIFF_CODE('S', 'W', 'D', '1');
+    TEST_CHECK(!Wave_BindDesc(&desc, bytes.data, bytes.size, &bound));
+}
+
+// A float view converts pages on access, keeps the most recently used ones and stops at the last partial page
+static void Test_View(void)
+{
+    enum { channels = 2, frame_count = 1000, page_frames = 64 };
+    int16_t samples[frame_count * channels];
+    float expected[frame_count * channels];
+    FILE* file = tmpfile();
+    WAVE_WRITER writer;
+    WAVE_FLOAT_VIEW view;
+    WAVE wave;
+    long size = 0;
+    size_t frame, count = 0;
+
+    Test_FillSamples(WAVE_SAMPLE_FORMAT_S16, samples, frame_count * channels);
+    Wave_ConvertToFloat(samples, WAVE_SAMPLE_FORMAT_S16, frame_count * channels, expected);
+    TEST_CHECK(Wave_WriterBegin(&writer, file, WAVE_SAMPLE_FORMAT_S16, channels, TEST_RATE));
+    TEST_CHECK(Wave_WriterWrite(&writer, samples, frame_count));
+    TEST_CHECK(Wave_WriterEnd(&writer));
+    void* buffer = Test_ReadAll(file, &size);
+    TEST_CHECK(Wave_ParseBuffer(buffer, (size_t)size, &wave));
+    TEST_CHECK(Wave_ViewInit(&view, &wave, page_frames, 3, NULL));
+
+    // Every frame, walked in runs of one page
+    for (frame = 0; frame < frame_count; frame += count)
+    {
+        const float* frames = Wave_ViewGetFrames(&view, frame, &count);
+        TEST_CHECK((frames != NULL) && ((count == page_frames - frame % page_frames) || (frame + count == frame_count)));
+        if (!frames)
+            break;
+        TEST_CHECK(memcmp(frames, expected + frame * channels, count * channels * sizeof(float)) == 0);
+    }
+    TEST_CHECK(frame == frame_count);
+
+    // The least recently used page is the one replaced
+    const float* page0 = Wave_ViewGetPage(&view, 0, NULL);
+    const float* page1 = Wave_ViewGetPage(&view, 1, NULL);
+    const float* page2 = Wave_ViewGetPage(&view, 2, NULL);
+    TEST_CHECK((page0 != page1) && (page1 != page2) && (page0 != page2));
+    TEST_CHECK(Wave_ViewGetPage(&view, 0, NULL) == page0);
+    TEST_CHECK(Wave_ViewGetPage(&view, 5, NULL) == page1);
+    TEST_CHECK(memcmp(page1, expected + 5 * page_frames * channels, page_frames * channels * sizeof(float)) == 0);
+    TEST_CHECK(Wave_ViewGetPage(&view, 0, NULL) == page0);
+    TEST_CHECK(Wave_ViewGetPage(&view, 2, NULL) == page2);
+
+    // The last page is partial, nothing lies past it
+    TEST_CHECK((Wave_ViewGetPage(&view, frame_count / page_frames, &count) != NULL) && (count == frame_count % page_frames));
+    TEST_CHECK((Wave_ViewGetFrames(&view, frame_count - 1, &count) != NULL) && (count == 1));
+    TEST_CHECK(Wave_ViewGetPage(&view, frame_count / page_frames + 1, NULL) == NULL);
+    TEST_CHECK(Wave_ViewGetFrames(&view, frame_count, NULL) == NULL);
+    TEST_CHECK(Wave_ViewGetPage(&view, (size_t)-1, NULL) == NULL);
+
+    TEST_CHECK(Wave_ViewFree(&view, NULL));
+    TEST_CHECK(!Wave_ViewFree(&view, NULL));
+    free(buffer);
+    fclose(file);
+}
+
+// Reads every frame a pipe gets from the stream of a built layout, in odd sized blocks
+static size_t Test_ReadPipe(TEST_BYTES* bytes, int16_t* out_frames, size_t max_frames, int* out_unbounded)
+{
+    WAVE_PIPE pipe;
+    size_t total = 0, count;
+    FILE* file = Test_OpenBytes(bytes->data, bytes->size);
+
+    TEST_CHECK(Wave_PipeOpen(&pipe, file, NULL));
+    *out_unbounded = pipe.unbounded;
+    while ((count = Wave_PipeRead(&pipe, out_frames + total * 2, (max_frames - total < 7) ? max_frames - total : 7)) != 0)
+        total += count;
+    TEST_CHECK(pipe.frame_position == total);
+    TEST_CHECK(Wave_PipeClose(&pipe, NULL));
+    fclose(file);
+    return total;
+}
+
+// A pipe stops at the end of the data chunk, unless live recorders left its size unset
+static void Test_Pipe(void)
+{
+    enum { frame_count = 100 };
+    int16_t samples[frame_count * 2], read[frame_count * 4];
+    TEST_BYTES bytes;
+    WAVE parsed;
+    int unbounded = 0;
+
+    Test_FillSamples(WAVE_SAMPLE_FORMAT_S16, samples, frame_count * 2);
+    Test_BuildLayout(&bytes, "LFDT", WAVE_SAMPLE_FORMAT_S16, 2, samples, frame_count);
+    TEST_CHECK(Test_ReadPipe(&bytes, read, frame_count * 2, &unbounded) == frame_count);
+    TEST_CHECK((!unbounded) && (memcmp(read, samples, sizeof(samples)) == 0));
+
+    // Converted to floats
+    WAVE_PIPE pipe;
+    float floats[frame_count * 2], expected[frame_count * 2];
+    FILE* file = Test_OpenBytes(bytes.data, bytes.size);
+    TEST_CHECK(Wave_PipeOpen(&pipe, file, NULL));
+    TEST_CHECK(Wave_PipeReadFloat(&pipe, floats, frame_count + 10) == frame_count);
+    Wave_ConvertToFloat(samples, WAVE_SAMPLE_FORMAT_S16, frame_count * 2, expected);
+    TEST_CHECK(memcmp(floats, expected, sizeof(floats)) == 0);
+    TEST_CHECK(Wave_PipeClose(&pipe, NULL));
+    fclose(file);
+
+    // An empty data chunk in a sized RIFF has no frames, the LIST after it is not read as samples
+    Test_BuildLayout(&bytes, "FDL", WAVE_SAMPLE_FORMAT_S16, 2, samples, 0);
+    TEST_CHECK(Test_ReadPipe(&bytes, read, frame_count * 2, &unbounded) == 0);
+    TEST_CHECK(!unbounded);
+
+    // Sizes left at 0xFFFFFFFF, or at 0 in both headers, are read to the end of the stream
+    static const uint32_t unset[2] = { 0xFFFFFFFFu, 0 };
+    size_t u;
+    for (u = 0; u < 2; ++u)
+    {
+        Test_BuildLayout(&bytes, "FD", WAVE_SAMPLE_FORMAT_S16, 2, samples, frame_count);
+        TEST_CHECK(Wave_ParseBuffer(bytes.data, bytes.size, &parsed));
+        memcpy(bytes.data + 4, &unset[u], 4);
+        memcpy(bytes.data + parsed.data_chunk_offset + 4, &unset[u], 4);
+        TEST_CHECK(Test_ReadPipe(&bytes, read, frame_count * 2, &unbounded) == frame_count);
+        TEST_CHECK((unbounded) && (memcmp(read, samples, sizeof(samples)) == 0));
+    }
+
+    // A data size of 0xFFFFFFFF is unset even in a sized RIFF
+    Test_BuildLayout(&bytes, "FD", WAVE_SAMPLE_FORMAT_S16, 2, samples, frame_count);
+    memcpy(bytes.data + parsed.data_chunk_offset + 4, &unset[0], 4);
+    TEST_CHECK(Test_ReadPipe(&bytes, read, frame_count * 2, &unbounded) == frame_count);
+    TEST_CHECK((unbounded) && (memcmp(read, samples, sizeof(samples)) == 0));
+}
+
+// A tail follows a wav while it is written, then stops at the data chunk once the recording is complete
+static void Test_Tail(void)
+{
+    enum { frame_count = 150, first_count = 100 };
+    int16_t samples[frame_count * 2], read[frame_count * 2];
+    float floats[frame_count * 2], expected[frame_count * 2];
+    WAVE_WRITER writer;
+    WAVE_TAIL tail;
+
+    Test_FillSamples(WAVE_SAMPLE_FORMAT_S16, samples, frame_count * 2);
+    Wave_ConvertToFloat(samples, WAVE_SAMPLE_FORMAT_S16, frame_count * 2, expected);
+    FILE* file = fopen(TEST_TAIL_PATH, "wb");
+    TEST_CHECK(file != NULL);
+    if (!file)
+        return;
+    TEST_CHECK(Wave_WriterBegin(&writer, file, WAVE_SAMPLE_FORMAT_S16, 2, TEST_RATE));
+    TEST_CHECK(Wave_WriterWrite(&writer, samples, first_count));
+    fflush(file);
+
+    // Frames are read as they reach the disk, in any number of reads
+    TEST_CHECK(Wave_TailOpen(&tail, TEST_TAIL_PATH, NULL));
+    TEST_CHECK(tail.frame_count == first_count);
+    TEST_CHECK(Wave_TailRead(&tail, read, 30) == 30);
+    TEST_CHECK(Wave_TailReadFloat(&tail, floats + 30 * 2, frame_count) == first_count - 30);
+    TEST_CHECK(Wave_TailRead(&tail, read, 1) == 0);
+
+    TEST_CHECK(Wave_WriterWrite(&writer, samples + first_count * 2, frame_count - first_count));
+    fflush(file);
+    TEST_CHECK(Wave_TailUpdate(&tail, 0) == frame_count - first_count);
+    TEST_CHECK(Wave_TailRead(&tail, read + first_count * 2, frame_count) == frame_count - first_count);
+    TEST_CHECK(memcmp(read, samples, 30 * 2 * sizeof(int16_t)) == 0);
+    TEST_CHECK(memcmp(floats + 30 * 2, expected + 30 * 2, (first_count - 30) * 2 * sizeof(float)) == 0);
+    TEST_CHECK(memcmp(read + first_count * 2, samples + first_count * 2, (frame_count - first_count) * 2 * sizeof(int16_t)) == 0);
+
+    // A chunk appended after the finished recording is not read as samples
+    TEST_CHECK(Wave_WriterEnd(&writer));
+    RIFF_CHUNK list = { RIFF_CODE('L', 'I', 'S', 'T'), 4 };
+    uint32_t riff_size;
+    fseek(file, 0, SEEK_END);
+    fwrite(&list, sizeof(list), 1, file);
+    fwrite("INFO", 1, 4, file);
+    riff_size = (uint32_t)ftell(file) - 8;
+    fseek(file, 4, SEEK_SET);
+    fwrite(&riff_size, sizeof(riff_size), 1, file);
+    fclose(file);
+    TEST_CHECK(Wave_TailUpdate(&tail, 0) == 0);
+    TEST_CHECK((tail.frame_count == frame_count) && (Wave_TailRead(&tail, read, 1) == 0));
+
+    TEST_CHECK(Wave_TailClose(&tail, NULL));
+    remove(TEST_TAIL_PATH);
+}
+
+int main(void)
+{
+    static const int channel_counts[] = { 1, 2, 6 };
+    size_t f, c;
+    int extensible, checksum;
+
+    for (f = 0; f < sizeof(test_formats) / sizeof(test_formats[0]); ++f)
+        for (c = 0; c < sizeof(channel_counts) / sizeof(channel_counts[0]); ++c)
+            for (extensible = 0; extensible < 2; ++extensible)
+                for (checksum = 0; checksum < 2; ++checksum)
+                    Test_WriterRoundTrip(test_formats[f], channel_counts[c], extensible, checksum);
+
+    Test_ChunkLayouts();
+    Test_Truncation();
+    Test_Desc();
+    Test_View();
+    Test_Pipe();
+    Test_Tail();
+    Test_WriteAtThenWrite();
+    Test_WideFrames();
+    Test_LargeOffsets();
+    Test_SplitMerge();
+    Test_Hybrid();
+    Test_Scheduler();
+    WAVE missing;
+    TEST_CHECK(!Wave_LoadPath("simple_wave_missing.wav", &missing, NULL));
+    TEST_CHECK(!Wave_LoadPathOnlyInfo("simple_wave_missing.wav", &missing, NULL));
+
+    return TEST_RESULT();
+}